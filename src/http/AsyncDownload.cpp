@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   AsyncDownload.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 15, 2021, 3:40 PM
+ */
+
+#include "AsyncDownload.h"
+#include "Client.h"
+#include "Response.h"
+#include "Pool.h"
+#include "Url.h"
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+namespace ygg
+{
+  /** The default amount of downloads run at once.
+   */
+  static const unsigned DEFAULT_CONCURRENCY = 4 ;
+
+  /** Structure to describe a queued download.
+   */
+  struct Job
+  {
+    using Clock = std::chrono::steady_clock ;
+
+    std::string               url      ; ///< The URL to download.
+    std::promise<Download>    promise  ; ///< The promise to complete, if there is no callback.
+    AsyncDownloader::Callback callback ; ///< The function to complete the download with, if any.
+    void*                     user     ; ///< The pointer handed to the callback.
+    Clock::time_point         queued   ; ///< When the download was queued.
+  };
+
+  /** Structure to contain an asynchronous downloader's data.
+   */
+  struct AsyncDownloaderData
+  {
+    using Clock   = std::chrono::steady_clock ;
+    using Jobs    = std::deque<Job>           ;
+    using Threads = std::vector<std::thread>  ;
+
+    http::Pool              pool        ; ///< The idle connections shared by every worker.
+    Jobs                    jobs        ; ///< The downloads not yet started.
+    Threads                 workers     ; ///< The threads running downloads.
+    std::mutex              lock        ; ///< The lock guarding the queue.
+    std::condition_variable ready       ; ///< Signalled when a download is queued, or the workers should stop.
+    std::condition_variable idle        ; ///< Signalled when a download completes.
+    unsigned                concurrency ; ///< The amount of worker threads to start.
+    unsigned                running     ; ///< The amount of downloads in progress.
+    bool                    stopping    ; ///< Whether or not the workers should stop once the queue is empty.
+
+    /** Default constructor.
+     */
+    AsyncDownloaderData() ;
+
+    /** Method to queue a download, starting the workers if they are not running yet.
+     * @param job The download to queue.
+     */
+    void queue( Job&& job ) ;
+
+    /** Method to run a worker, completing downloads until told to stop.
+     */
+    void work() ;
+
+    /** Method to download & decode a single image.
+     * @param job The download to run.
+     * @param client The client of the worker running the download.
+     * @param response The response of the worker running the download.
+     * @param download The outcome to fill in.
+     */
+    static void run( const Job& job, http::Client& client, http::Response& response, Download& download ) ;
+
+    /** Function to find the time between two points in milliseconds.
+     * @param begin The earlier point.
+     * @param end The later point.
+     * @return The milliseconds between the points.
+     */
+    static double milliseconds( Clock::time_point begin, Clock::time_point end ) ;
+  };
+
+  Download::Download()
+  {
+    this->download_status = 0                      ;
+    this->download_error  = Yggdrasil::Error::None ;
+    this->wait_time       = 0.0                    ;
+    this->fetch_time      = 0.0                    ;
+    this->decode_time     = 0.0                    ;
+  }
+
+  const Image& Download::image() const
+  {
+    return this->download_image ;
+  }
+
+  const char* Download::url() const
+  {
+    return this->download_url.c_str() ;
+  }
+
+  unsigned Download::status() const
+  {
+    return this->download_status ;
+  }
+
+  Yggdrasil::Error Download::error() const
+  {
+    return this->download_error ;
+  }
+
+  double Download::waitTime() const
+  {
+    return this->wait_time ;
+  }
+
+  double Download::fetchTime() const
+  {
+    return this->fetch_time ;
+  }
+
+  double Download::decodeTime() const
+  {
+    return this->decode_time ;
+  }
+
+  double Download::totalTime() const
+  {
+    return this->wait_time + this->fetch_time + this->decode_time ;
+  }
+
+  AsyncDownloaderData::AsyncDownloaderData()
+  {
+    this->concurrency = DEFAULT_CONCURRENCY ;
+    this->running     = 0                   ;
+    this->stopping    = false               ;
+  }
+
+  double AsyncDownloaderData::milliseconds( Clock::time_point begin, Clock::time_point end )
+  {
+    return std::chrono::duration<double, std::milli>( end - begin ).count() ;
+  }
+
+  void AsyncDownloaderData::queue( Job&& job )
+  {
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+
+      this->jobs.push_back( std::move( job ) ) ;
+      while( this->workers.size() < this->concurrency )
+      {
+        this->workers.emplace_back( &AsyncDownloaderData::work, this ) ;
+      }
+    }
+
+    this->ready.notify_one() ;
+  }
+
+  void AsyncDownloaderData::run( const Job& job, http::Client& client, http::Response& response, Download& download )
+  {
+    Clock::time_point started ;
+    Clock::time_point fetched ;
+    http::Url         url     ;
+    bool              success ;
+
+    started = Clock::now() ;
+    download.download_url = job.url ;
+    download.wait_time    = AsyncDownloaderData::milliseconds( job.queued, started ) ;
+
+    if( !url.parse( job.url ) )
+    {
+      download.download_error = Yggdrasil::Error::InvalidUrl ;
+      return ;
+    }
+
+    success = client.get( job.url.c_str(), response ) ;
+    fetched = Clock::now() ;
+
+    download.download_status = response.status() ;
+    download.fetch_time      = AsyncDownloaderData::milliseconds( started, fetched ) ;
+
+    // Without a status the server was never reached, otherwise the body was cut short.
+    if( !success )
+    {
+      download.download_error = response.status() == 0 ? Yggdrasil::Error::ConnectionFailure : Yggdrasil::Error::RecieveFailure ;
+      return ;
+    }
+
+    if( response.status() != 200 )
+    {
+      download.download_error = Yggdrasil::Error::InvalidStatus ;
+      return ;
+    }
+
+    if( !download.download_image.decode( response.body(), response.size() ) ) download.download_error = Yggdrasil::Error::InvalidImage ;
+    download.decode_time = AsyncDownloaderData::milliseconds( fetched, Clock::now() ) ;
+  }
+
+  void AsyncDownloaderData::work()
+  {
+    http::Client   client   ;
+    http::Response response ;
+
+    client.setPool( this->pool ) ;
+
+    while( true )
+    {
+      Job      job      ;
+      Download download ;
+
+      {
+        std::unique_lock<std::mutex> lock( this->lock ) ;
+
+        this->ready.wait( lock, [this]() { return this->stopping || !this->jobs.empty() ; } ) ;
+        if( this->jobs.empty() ) return ;
+
+        job = std::move( this->jobs.front() ) ;
+        this->jobs.pop_front() ;
+        this->running++ ;
+      }
+
+      AsyncDownloaderData::run( job, client, response, download ) ;
+
+      if( job.callback != nullptr ) job.callback( download, job.user ) ;
+      else                          job.promise.set_value( std::move( download ) ) ;
+
+      {
+        std::lock_guard<std::mutex> lock( this->lock ) ;
+        this->running-- ;
+      }
+
+      this->idle.notify_all() ;
+    }
+  }
+
+  AsyncDownloader::AsyncDownloader()
+  {
+    this->async_data = new AsyncDownloaderData() ;
+  }
+
+  AsyncDownloader::~AsyncDownloader()
+  {
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+      data().stopping = true ;
+    }
+
+    // Workers only stop once the queue is empty, so every queued download still completes.
+    data().ready.notify_all() ;
+    for( auto& worker : data().workers ) worker.join() ;
+
+    delete this->async_data ;
+  }
+
+  void AsyncDownloader::setConcurrency( unsigned amount )
+  {
+    std::lock_guard<std::mutex> lock( data().lock ) ;
+
+    data().concurrency = std::max( 1u, amount ) ;
+  }
+
+  std::future<Download> AsyncDownloader::fetch( const char* url )
+  {
+    Job                   job    ;
+    std::future<Download> future ;
+
+    job.url      = url                               ;
+    job.callback = nullptr                           ;
+    job.user     = nullptr                           ;
+    job.queued   = AsyncDownloaderData::Clock::now() ;
+    future       = job.promise.get_future()          ;
+
+    data().queue( std::move( job ) ) ;
+    return future ;
+  }
+
+  void AsyncDownloader::fetch( const char* url, Callback callback, void* user )
+  {
+    Job job ;
+
+    job.url      = url                               ;
+    job.callback = callback                          ;
+    job.user     = user                              ;
+    job.queued   = AsyncDownloaderData::Clock::now() ;
+
+    data().queue( std::move( job ) ) ;
+  }
+
+  void AsyncDownloader::wait()
+  {
+    std::unique_lock<std::mutex> lock( data().lock ) ;
+
+    data().idle.wait( lock, [this]() { return data().jobs.empty() && data().running == 0 ; } ) ;
+  }
+
+  AsyncDownloaderData& AsyncDownloader::data()
+  {
+    return *this->async_data ;
+  }
+
+  const AsyncDownloaderData& AsyncDownloader::data() const
+  {
+    return *this->async_data ;
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   AsyncDownload.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 15, 2021, 3:40 PM
+ */
+
+#ifndef YGGDRASIL_ASYNC_DOWNLOAD_H
+#define YGGDRASIL_ASYNC_DOWNLOAD_H
+
+#include "Image.h"
+#include <ygg/Yggdrasil.h>
+#include <string>
+#include <future>
+
+namespace ygg
+{
+  /** Class to describe the outcome of a single asynchronous download.
+   */
+  class Download
+  {
+    public:
+
+      /** Default constructor.
+       */
+      Download() ;
+
+      /** Method to retrieve the decoded image.
+       * @return The image. Empty if the download failed.
+       */
+      const Image& image() const ;
+
+      /** Method to retrieve the URL that was downloaded.
+       * @return The C-string URL as it was queued.
+       */
+      const char* url() const ;
+
+      /** Method to retrieve the status code the server answered with.
+       * @return The HTTP status code of the response, or 0 if none was received.
+       */
+      unsigned status() const ;
+
+      /** Method to retrieve what went wrong with the download, if anything.
+       * @return The error of the download, or Yggdrasil::Error::None if the image was downloaded & decoded.
+       */
+      Yggdrasil::Error error() const ;
+
+      /** Method to retrieve how long the download waited to be started.
+       * @return The time in milliseconds between queueing the download & a worker taking it.
+       */
+      double waitTime() const ;
+
+      /** Method to retrieve how long the image took to fetch.
+       * @return The time in milliseconds spent connecting, requesting & receiving the body.
+       */
+      double fetchTime() const ;
+
+      /** Method to retrieve how long the image took to decode.
+       * @return The time in milliseconds spent decoding the body.
+       */
+      double decodeTime() const ;
+
+      /** Method to retrieve how long the whole download took.
+       * @return The time in milliseconds between queueing the download & it completing.
+       */
+      double totalTime() const ;
+
+    private:
+
+      friend struct AsyncDownloaderData ;
+
+      Image            download_image  ; ///< The decoded image.
+      std::string      download_url    ; ///< The URL that was downloaded.
+      unsigned         download_status ; ///< The status code of the response.
+      Yggdrasil::Error download_error  ; ///< What went wrong with the download.
+      double           wait_time       ; ///< The milliseconds spent waiting for a worker.
+      double           fetch_time      ; ///< The milliseconds spent fetching.
+      double           decode_time     ; ///< The milliseconds spent decoding.
+  };
+
+  /** Class to download & decode images in the background, so the thread queueing them can keep working.
+   * Each download is completed either through a future or by calling a function, from one of this object's worker threads.
+   */
+  class AsyncDownloader
+  {
+    public:
+
+      /** The function called when a download completes.
+       * @param download The outcome of the download. Only valid for the duration of the call.
+       * @param user The pointer handed to AsyncDownloader::fetch().
+       */
+      using Callback = void ( * )( const Download& download, void* user ) ;
+
+      /** Default constructor.
+       */
+      AsyncDownloader() ;
+
+      /** Default deconstructor. Waits for every queued download to complete.
+       */
+      ~AsyncDownloader() ;
+
+      /** Method to set the amount of downloads run at once.
+       * @note Only takes effect before the first download is queued.
+       * @param amount The amount of worker threads. Clamped to at least 1.
+       */
+      void setConcurrency( unsigned amount ) ;
+
+      /** Method to queue a download, completing it through a future.
+       * @param url The C-string URL of the image. It is copied, so it does not need to outlive the call.
+       * @return The future the outcome of the download is delivered through.
+       */
+      std::future<Download> fetch( const char* url ) ;
+
+      /** Method to queue a download, completing it by calling a function.
+       * @param url The C-string URL of the image. It is copied, so it does not need to outlive the call.
+       * @param callback The function to call from a worker thread once the download completes.
+       * @param user The pointer handed to the function.
+       */
+      void fetch( const char* url, Callback callback, void* user = nullptr ) ;
+
+      /** Method to wait for every queued download to complete.
+       */
+      void wait() ;
+
+    private:
+
+      /** The forward declared structure containing this object's data.
+       */
+      struct AsyncDownloaderData *async_data ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      AsyncDownloaderData& data() ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      const AsyncDownloaderData& data() const ;
+  };
+}
+
+#endif /* ASYNC_DOWNLOAD_H */
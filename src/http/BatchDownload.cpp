@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   BatchDownload.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 14, 2021, 5:10 PM
+ */
+
+#include "BatchDownload.h"
+#include "Image.h"
+#include "Client.h"
+#include "Response.h"
+#include "Pool.h"
+#include "Url.h"
+
+#include <vector>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+namespace ygg
+{
+  /** The default maximum amount of images downloaded at once.
+   */
+  static const unsigned DEFAULT_CONCURRENCY = 16 ;
+
+  /** The default maximum amount of images downloaded at once from one host, the same as most browsers allow.
+   */
+  static const unsigned DEFAULT_HOST_LIMIT = 6 ;
+
+  /** Structure to contain the URLs of one origin in a batch.
+   */
+  struct Origin
+  {
+    std::deque<std::size_t> pending    ; ///< The indices of the origin's URLs not yet started, oldest first.
+    unsigned                active = 0 ; ///< The amount of the origin's downloads in flight.
+  };
+
+  /** Structure to contain the state of a single batch, shared by it's workers.
+   */
+  struct Batch
+  {
+    using Keys    = std::vector<unsigned>                       ;
+    using Origins = std::unordered_map<unsigned, Origin>        ;
+    using Open    = std::set<std::pair<std::size_t, unsigned>> ;
+
+    const char* const*          urls      ; ///< The URLs of the batch.
+    Keys                        keys      ; ///< The origin key of each URL.
+    Origins                     origins   ; ///< The URLs not yet started & downloads in flight, per origin.
+    Open                        open      ; ///< The oldest URL not yet started & key of each origin with room, oldest first.
+    std::size_t                 remaining ; ///< The amount of URLs not yet started.
+    unsigned                    limit     ; ///< The maximum amount of downloads in flight per origin.
+    std::mutex                  lock      ; ///< The lock guarding the origins.
+    std::condition_variable     ready     ; ///< Signalled whenever an origin with URLs left frees up.
+    std::mutex                  report    ; ///< The lock serializing calls to the callback.
+    BatchDownloader::Callback   callback  ; ///< The function to report images to.
+    void*                       user      ; ///< The pointer handed to the callback.
+
+    /** Method to take the next URL whose origin has room, waiting for one to free up if needed.
+     * @param index Set to the index of the URL taken.
+     * @return Whether or not a URL was taken. False once the batch has no URLs left.
+     */
+    bool take( std::size_t& index ) ;
+
+    /** Method to mark a URL taken with Batch::take() as done, freeing up it's origin.
+     * @param index The index of the URL.
+     */
+    void finish( std::size_t index ) ;
+
+    /** Method to run a worker, downloading URLs until none are left.
+     * @param pool The pool the worker's connections are taken from.
+     */
+    void work( http::Pool& pool ) ;
+  };
+
+  /** Structure to contain a batch downloader's data.
+   */
+  struct BatchDownloaderData
+  {
+    http::Pool pool        ; ///< The idle connections shared by every worker & batch.
+    unsigned   concurrency ; ///< The maximum amount of images downloaded at once.
+    unsigned   host_limit  ; ///< The maximum amount of images downloaded at once from one host.
+
+    /** Default constructor.
+     */
+    BatchDownloaderData() ;
+  };
+
+  bool Batch::take( std::size_t& index )
+  {
+    std::unique_lock<std::mutex> lock( this->lock ) ;
+
+    while( this->remaining != 0 )
+    {
+      // The oldest URL whose origin has room goes first, so one busy host does not hold up the others.
+      if( !this->open.empty() )
+      {
+        const unsigned key    = this->open.begin()->second ;
+        Origin&        origin = this->origins[ key ]        ;
+
+        this->open.erase( this->open.begin() ) ;
+        index = origin.pending.front() ;
+        origin.pending.pop_front() ;
+        origin.active++ ;
+
+        if( !origin.pending.empty() && origin.active < this->limit ) this->open.emplace( origin.pending.front(), key ) ;
+
+        // Once nothing is left to start, every waiting worker can stop.
+        if( --this->remaining == 0 ) this->ready.notify_all() ;
+        return true ;
+      }
+
+      this->ready.wait( lock ) ;
+    }
+
+    return false ;
+  }
+
+  void Batch::finish( std::size_t index )
+  {
+    bool freed ;
+
+    {
+      std::lock_guard<std::mutex> lock( this->lock ) ;
+
+      const unsigned key    = this->keys[ index ]  ;
+      Origin&        origin = this->origins[ key ] ;
+
+      // An origin that was full has room again, & only one waiting worker can use it.
+      freed = origin.active-- == this->limit && !origin.pending.empty() ;
+      if( freed ) this->open.emplace( origin.pending.front(), key ) ;
+    }
+
+    if( freed ) this->ready.notify_one() ;
+  }
+
+  void Batch::work( http::Pool& pool )
+  {
+    http::Client   client   ;
+    http::Response response ;
+    Image          image    ;
+    std::size_t    index    ;
+    bool           fetched  ;
+
+    client.setPool( pool ) ;
+
+    while( this->take( index ) )
+    {
+      image.clear() ;
+      fetched = client.get( this->urls[ index ], response ) && response.status() == 200 ;
+
+      // The origin is freed before decoding, so another worker can fetch from it while this one decodes.
+      this->finish( index ) ;
+      if( fetched ) image.decode( response.body(), response.size() ) ;
+
+      std::lock_guard<std::mutex> lock( this->report ) ;
+      this->callback( index, image, this->user ) ;
+    }
+  }
+
+  BatchDownloaderData::BatchDownloaderData()
+  {
+    this->concurrency = DEFAULT_CONCURRENCY ;
+    this->host_limit  = DEFAULT_HOST_LIMIT  ;
+    this->pool.setLimit( this->host_limit ) ;
+  }
+
+  BatchDownloader::BatchDownloader()
+  {
+    this->batch_data = new BatchDownloaderData() ;
+  }
+
+  BatchDownloader::~BatchDownloader()
+  {
+    delete this->batch_data ;
+  }
+
+  void BatchDownloader::setConcurrency( unsigned amount )
+  {
+    data().concurrency = std::max( 1u, amount ) ;
+  }
+
+  void BatchDownloader::setHostLimit( unsigned amount )
+  {
+    data().host_limit = std::max( 1u, amount ) ;
+    data().pool.setLimit( data().host_limit ) ;
+  }
+
+  void BatchDownloader::downloadMany( const char* const* urls, std::size_t count, Callback callback, void* user )
+  {
+    std::vector<std::thread> workers ;
+    Batch                    batch   ;
+    http::Url                url     ;
+
+    batch.urls      = urls              ;
+    batch.remaining = count             ;
+    batch.limit     = data().host_limit ;
+    batch.callback  = callback          ;
+    batch.user      = user              ;
+
+    batch.keys.reserve( count ) ;
+    for( std::size_t index = 0; index < count; index++ )
+    {
+      // Invalid URLs all share key 0, & fail as soon as a worker takes them.
+      batch.keys.push_back( url.parse( urls[ index ] ) ? url.key() : 0 ) ;
+      batch.origins[ batch.keys.back() ].pending.push_back( index ) ;
+    }
+
+    for( auto& origin : batch.origins ) batch.open.emplace( origin.second.pending.front(), origin.first ) ;
+
+    const std::size_t amount = std::min<std::size_t>( data().concurrency, count ) ;
+    for( std::size_t index = 0; index < amount; index++ )
+    {
+      workers.emplace_back( &Batch::work, &batch, std::ref( data().pool ) ) ;
+    }
+
+    for( auto& worker : workers ) worker.join() ;
+  }
+
+  BatchDownloaderData& BatchDownloader::data()
+  {
+    return *this->batch_data ;
+  }
+
+  const BatchDownloaderData& BatchDownloader::data() const
+  {
+    return *this->batch_data ;
+  }
+}
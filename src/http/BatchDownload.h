@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   BatchDownload.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 14, 2021, 5:10 PM
+ */
+
+#ifndef YGGDRASIL_BATCH_DOWNLOAD_H
+#define YGGDRASIL_BATCH_DOWNLOAD_H
+
+#include <cstddef>
+
+namespace ygg
+{
+  class Image ;
+
+  /** Class to download & decode many images in parallel.
+   * Each worker thread fetches an image over a pooled keep-alive connection, decodes it, and reports it before taking the next one.
+   * The amount of images in flight is capped both overall & per host, so a batch does not flood any one server.
+   */
+  class BatchDownloader
+  {
+    public:
+
+      /** The function called as each image of a batch completes.
+       * @param index The index of the image's URL in the batch.
+       * @param image The decoded image. Empty if it could not be downloaded or decoded. Only valid for the duration of the call.
+       * @param user The pointer handed to BatchDownloader::downloadMany().
+       */
+      using Callback = void ( * )( std::size_t index, const Image& image, void* user ) ;
+
+      /** Default constructor.
+       */
+      BatchDownloader() ;
+
+      /** Default deconstructor.
+       */
+      ~BatchDownloader() ;
+
+      /** Method to set the maximum amount of images downloaded at once.
+       * @param amount The amount of worker threads. Clamped to at least 1.
+       */
+      void setConcurrency( unsigned amount ) ;
+
+      /** Method to set the maximum amount of images downloaded at once from a single host.
+       * @param amount The amount of connections allowed to one host. Clamped to at least 1.
+       */
+      void setHostLimit( unsigned amount ) ;
+
+      /** Method to download & decode a batch of images, reporting each as it completes.
+       * @note This blocks until the whole batch is done. The callback is called from the worker threads, but never from two at once.
+       * @param urls The C-string URLs of the images.
+       * @param count The amount of URLs.
+       * @param callback The function to call with each image, in the order they complete.
+       * @param user The pointer handed to every call of the callback.
+       */
+      void downloadMany( const char* const* urls, std::size_t count, Callback callback, void* user = nullptr ) ;
+
+    private:
+
+      /** The forward declared structure containing this object's data.
+       */
+      struct BatchDownloaderData *batch_data ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      BatchDownloaderData& data() ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      const BatchDownloaderData& data() const ;
+  };
+}
+
+#endif /* BATCH_DOWNLOAD_H */
@@ -0,0 +1,347 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Cache.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 7, 2021, 1:48 PM
+ */
+
+#include "Cache.h"
+#include "Parser.h"
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+namespace ygg
+{
+  namespace http
+  {
+    using Clock = std::chrono::steady_clock ;
+
+    /** The default amount of memory a cache may use.
+     */
+    static const std::size_t DEFAULT_BUDGET = 64u << 20 ;
+
+    /** Function to parse an HTTP date, e.g. "Tue, 19 Jan 2021 08:48:00 GMT".
+     * @param date The C-string date to parse.
+     * @return The seconds since the epoch, or -1 if the date could not be parsed.
+     */
+    static long long parseDate( const char* date ) ;
+
+    /** Structure to contain a single cached response.
+     */
+    struct CacheEntry
+    {
+      using Body = std::vector<unsigned char> ;
+
+      std::string       url      ; ///< The URL the response was stored under.
+      std::string       etag     ; ///< The ETag of the response.
+      std::string       modified ; ///< The Last-Modified date of the response.
+      Body              body     ; ///< The body of the response.
+      Clock::time_point expires  ; ///< When the response becomes stale.
+
+      /** Method to retrieve the amount of memory this entry counts against the budget.
+       * @return The amount of bytes used by this entry.
+       */
+      std::size_t cost() const ;
+    };
+
+    /** Structure to contain a cache's data.
+     */
+    struct CacheData
+    {
+      using Entries = std::list<CacheEntry>                                ;
+      using Index   = std::unordered_map<std::string, Entries::iterator>   ;
+
+      Entries           entries ; ///< Every entry, most recently used first.
+      Index             index   ; ///< The entries by URL.
+      std::string       lookup  ; ///< The reused key buffer for lookups.
+      Entries::iterator current ; ///< The current entry, or the end of the entries if there is none.
+      std::size_t       budget  ; ///< The maximum amount of bytes all entries may use.
+      std::size_t       used    ; ///< The amount of bytes all entries use.
+
+      /** Default constructor.
+       */
+      CacheData() ;
+
+      /** Method to remove an entry.
+       * @param entry The entry to remove.
+       */
+      void remove( Entries::iterator entry ) ;
+
+      /** Method to remove the least recently used entries until the cache fits it's budget.
+       */
+      void evict() ;
+    };
+
+    long long parseDate( const char* date )
+    {
+      static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec" ;
+
+      const char* comma ;
+      const char* month ;
+      int         day   ;
+      int         year  ;
+      int         hour  ;
+      int         min   ;
+      int         sec   ;
+      int         index ;
+      long long   days  ;
+
+      // Only the IMF-fixdate form is accepted, which is the only one servers may send.
+      comma = std::strchr( date, ',' ) ;
+      if( comma == nullptr || std::strlen( comma ) < 26 ) return -1 ;
+
+      day   = std::atoi( comma + 2 ) ;
+      month = std::strstr( MONTHS, std::string( comma + 5, 3 ).c_str() ) ;
+      year  = std::atoi( comma + 9  ) ;
+      hour  = std::atoi( comma + 14 ) ;
+      min   = std::atoi( comma + 17 ) ;
+      sec   = std::atoi( comma + 20 ) ;
+
+      if( month == nullptr || ( month - MONTHS ) % 3 != 0 || day < 1 || year < 1970 ) return -1 ;
+
+      // Days since the epoch of a proleptic Gregorian date, counting years from March so leap days fall last.
+      index = static_cast<int>( month - MONTHS ) / 3 ;
+      if( index < 2 ) year-- ;
+
+      const long long era  = year / 400 ;
+      const long long yoe  = year - era * 400 ;
+      const long long doy  = ( 153 * ( index + ( index > 1 ? -2 : 10 ) ) + 2 ) / 5 + day - 1 ;
+      const long long doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy ;
+
+      days = era * 146097 + doe - 719468 ;
+      return days * 86400 + hour * 3600 + min * 60 + sec ;
+    }
+
+    long long Cache::lifetime( const Parser& response )
+    {
+      std::string control ;
+      std::size_t offset  ;
+      long long   fresh   ;
+      long long   date    ;
+      long long   other   ;
+
+      control = response.value( "Cache-Control" ) ;
+      for( auto& character : control ) character = static_cast<char>( std::tolower( character ) ) ;
+
+      if( control.find( "no-store" ) != std::string::npos ) return -1 ;
+      if( control.find( "no-cache" ) != std::string::npos ) return 0  ;
+
+      date   = parseDate( response.value( "Date" ) ) ;
+      offset = control.find( "max-age=" ) ;
+
+      // Cache-Control wins over Expires, which wins over a guess of a tenth of the time since the last change.
+      if( offset != std::string::npos )
+      {
+        fresh = std::atoll( control.c_str() + offset + 8 ) ;
+      }
+      else if( response.value( "Expires" )[ 0 ] != '\0' )
+      {
+        other = parseDate( response.value( "Expires" ) ) ;
+        fresh = other >= 0 && date >= 0 ? other - date : 0 ;
+      }
+      else if( response.value( "Last-Modified" )[ 0 ] != '\0' )
+      {
+        other = parseDate( response.value( "Last-Modified" ) ) ;
+        fresh = other >= 0 && date >= other ? ( date - other ) / 10 : 0 ;
+      }
+      else
+      {
+        fresh = 0 ;
+      }
+
+      // Time the response already spent in other caches counts against it.
+      fresh -= std::atoll( response.value( "Age" ) ) ;
+      return fresh > 0 ? fresh : 0 ;
+    }
+
+    std::size_t CacheEntry::cost() const
+    {
+      return this->body.size() + this->url.size() + this->etag.size() + this->modified.size() + sizeof( CacheEntry ) ;
+    }
+
+    CacheData::CacheData()
+    {
+      this->current = this->entries.end() ;
+      this->budget  = DEFAULT_BUDGET      ;
+      this->used    = 0                   ;
+    }
+
+    void CacheData::remove( Entries::iterator entry )
+    {
+      if( entry == this->current ) this->current = this->entries.end() ;
+
+      this->used -= entry->cost() ;
+      this->index.erase( entry->url ) ;
+      this->entries.erase( entry ) ;
+    }
+
+    void CacheData::evict()
+    {
+      while( this->used > this->budget && !this->entries.empty() )
+      {
+        this->remove( std::prev( this->entries.end() ) ) ;
+      }
+    }
+
+    Cache::Cache()
+    {
+      this->cache_data = new CacheData() ;
+    }
+
+    Cache::~Cache()
+    {
+      delete this->cache_data ;
+    }
+
+    void Cache::setBudget( std::size_t bytes )
+    {
+      data().budget = bytes ;
+      data().evict() ;
+    }
+
+    bool Cache::find( std::string_view url )
+    {
+      data().lookup.assign( url.data(), url.size() ) ;
+
+      const auto iter = data().index.find( data().lookup ) ;
+
+      if( iter == data().index.end() )
+      {
+        data().current = data().entries.end() ;
+        return false ;
+      }
+
+      data().entries.splice( data().entries.begin(), data().entries, iter->second ) ;
+      data().current = iter->second ;
+      return true ;
+    }
+
+    bool Cache::fresh() const
+    {
+      return data().current != data().entries.end() && Clock::now() < data().current->expires ;
+    }
+
+    const char* Cache::etag() const
+    {
+      return data().current != data().entries.end() ? data().current->etag.c_str() : "" ;
+    }
+
+    const char* Cache::lastModified() const
+    {
+      return data().current != data().entries.end() ? data().current->modified.c_str() : "" ;
+    }
+
+    const unsigned char* Cache::body() const
+    {
+      return data().current != data().entries.end() ? data().current->body.data() : nullptr ;
+    }
+
+    std::size_t Cache::size() const
+    {
+      return data().current != data().entries.end() ? data().current->body.size() : 0 ;
+    }
+
+    bool Cache::store( std::string_view url, const Parser& response, const unsigned char* body, std::size_t size )
+    {
+      const long long fresh = lifetime( response ) ;
+
+      this->erase( url ) ;
+
+      // Without a validator a stale entry could never be reused, so it is only worth keeping while fresh.
+      if( response.status() != 200 || fresh < 0 ) return false ;
+      if( fresh == 0 && response.value( "ETag" )[ 0 ] == '\0' && response.value( "Last-Modified" )[ 0 ] == '\0' ) return false ;
+
+      CacheEntry entry ;
+      entry.url      = std::string( url )                             ;
+      entry.etag     = response.value( "ETag"          )              ;
+      entry.modified = response.value( "Last-Modified" )              ;
+      entry.expires  = Clock::now() + std::chrono::seconds( fresh )   ;
+      if( entry.cost() + size > data().budget ) return false ;
+
+      entry.body.assign( body, body + size ) ;
+
+      data().entries.push_front( std::move( entry ) ) ;
+      data().index[ data().entries.front().url ] = data().entries.begin() ;
+      data().used   += data().entries.front().cost() ;
+      data().current = data().entries.begin()        ;
+      data().evict() ;
+
+      return true ;
+    }
+
+    void Cache::refresh( const Parser& response )
+    {
+      const long long fresh = lifetime( response ) ;
+
+      if( data().current == data().entries.end() ) return ;
+
+      if( fresh < 0 )
+      {
+        data().remove( data().current ) ;
+        return ;
+      }
+
+      // A 304 may carry a new validator, which replaces the stored one.
+      data().used -= data().current->cost() ;
+      if( response.value( "ETag"          )[ 0 ] != '\0' ) data().current->etag     = response.value( "ETag"          ) ;
+      if( response.value( "Last-Modified" )[ 0 ] != '\0' ) data().current->modified = response.value( "Last-Modified" ) ;
+      data().current->expires = Clock::now() + std::chrono::seconds( fresh ) ;
+      data().used += data().current->cost() ;
+    }
+
+    void Cache::erase( std::string_view url )
+    {
+      data().lookup.assign( url.data(), url.size() ) ;
+
+      const auto iter = data().index.find( data().lookup ) ;
+
+      if( iter != data().index.end() ) data().remove( iter->second ) ;
+    }
+
+    void Cache::clear()
+    {
+      data().index.clear() ;
+      data().entries.clear() ;
+      data().current = data().entries.end() ;
+      data().used    = 0                    ;
+    }
+
+    std::size_t Cache::used() const
+    {
+      return data().used ;
+    }
+
+    CacheData& Cache::data()
+    {
+      return *this->cache_data ;
+    }
+
+    const CacheData& Cache::data() const
+    {
+      return *this->cache_data ;
+    }
+  }
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Chunked.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on January 24, 2021, 3:12 PM
+ */
+
+#include "Chunked.h"
+#include <ygg/Yggdrasil.h>
+#include <algorithm>
+#include <cstring>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The states of the chunked decoding state machine.
+     */
+    enum class ChunkState
+    {
+      Size,
+      Extension,
+      SizeLF,
+      Data,
+      DataCR,
+      DataLF,
+      TrailerStart,
+      TrailerLine,
+      TrailerLF,
+      Done,
+      Invalid
+    };
+
+    /** Function to convert a hexadecimal character to it's value.
+     * @param token The character to convert.
+     * @return The value of the character, or -1 if it is not a hexadecimal digit.
+     */
+    static int hexValue( char token ) ;
+
+    /** Structure to contain a chunked decoder's data.
+     */
+    struct ChunkedDecoderData
+    {
+      ChunkState         state     ;
+      unsigned long long remaining ;
+      unsigned           digits    ;
+      unsigned           consumed  ;
+
+      /** Default constructor.
+       */
+      ChunkedDecoderData() ;
+
+      /** Method to mark the stream as malformed.
+       */
+      void invalidate() ;
+    };
+
+    int hexValue( char token )
+    {
+      if( token >= '0' && token <= '9' ) return token - '0'      ;
+      if( token >= 'a' && token <= 'f' ) return token - 'a' + 10 ;
+      if( token >= 'A' && token <= 'F' ) return token - 'A' + 10 ;
+
+      return -1 ;
+    }
+
+    ChunkedDecoderData::ChunkedDecoderData()
+    {
+      this->state     = ChunkState::Size ;
+      this->remaining = 0                ;
+      this->digits    = 0                ;
+      this->consumed  = 0                ;
+    }
+
+    void ChunkedDecoderData::invalidate()
+    {
+      this->state = ChunkState::Invalid ;
+      ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+    }
+
+    ChunkedDecoder::ChunkedDecoder()
+    {
+      this->decoder_data = new ChunkedDecoderData() ;
+    }
+
+    ChunkedDecoder::~ChunkedDecoder()
+    {
+      delete this->decoder_data ;
+    }
+
+    unsigned ChunkedDecoder::decode( char* data, unsigned size )
+    {
+      return this->decode( data, size, data ) ;
+    }
+
+    unsigned ChunkedDecoder::decode( const char* input, unsigned size, char* output )
+    {
+      unsigned in     ;
+      unsigned out    ;
+      unsigned amount ;
+      int      value  ;
+      char     token  ;
+
+      in  = 0 ;
+      out = 0 ;
+
+      while( in < size && data().state != ChunkState::Done && data().state != ChunkState::Invalid )
+      {
+        // Chunk data is moved as a whole run. The output never passes the input, so this is safe to do in place.
+        if( data().state == ChunkState::Data )
+        {
+          amount = static_cast<unsigned>( std::min<unsigned long long>( data().remaining, size - in ) ) ;
+          std::memmove( output + out, input + in, amount ) ;
+
+          in                += amount ;
+          out               += amount ;
+          data().remaining  -= amount ;
+          if( data().remaining == 0 ) data().state = ChunkState::DataCR ;
+          continue ;
+        }
+
+        token = input[ in++ ] ;
+        switch( data().state )
+        {
+          case ChunkState::Size :
+            if( ( value = hexValue( token ) ) >= 0 )
+            {
+              // Anything past 15 hex digits cannot be a sane chunk & would overflow.
+              if( ++data().digits > 15 ) { data().invalidate() ; break ; }
+              data().remaining = ( data().remaining << 4 ) | static_cast<unsigned>( value ) ;
+            }
+            else if( data().digits == 0 )                 data().invalidate()                     ;
+            else if( token == '\r'                      ) data().state = ChunkState::SizeLF       ;
+            else if( token == '\n'                      ) data().state = data().remaining ? ChunkState::Data : ChunkState::TrailerStart ;
+            else if( token == ';' || token == ' ' || token == '\t' ) data().state = ChunkState::Extension ;
+            else                                          data().invalidate()                     ;
+            break ;
+
+          case ChunkState::Extension :
+            if     ( token == '\r' ) data().state = ChunkState::SizeLF ;
+            else if( token == '\n' ) data().state = data().remaining ? ChunkState::Data : ChunkState::TrailerStart ;
+            break ;
+
+          case ChunkState::SizeLF :
+            if( token != '\n' ) { data().invalidate() ; break ; }
+            data().state = data().remaining ? ChunkState::Data : ChunkState::TrailerStart ;
+            break ;
+
+          case ChunkState::DataCR :
+            if     ( token == '\r' ) data().state = ChunkState::DataLF ;
+            else if( token == '\n' ) { data().state = ChunkState::Size ; data().digits = 0 ; }
+            else                     data().invalidate() ;
+            break ;
+
+          case ChunkState::DataLF :
+            if( token != '\n' ) { data().invalidate() ; break ; }
+            data().state  = ChunkState::Size ;
+            data().digits = 0                ;
+            break ;
+
+          case ChunkState::TrailerStart :
+            if     ( token == '\r' ) data().state = ChunkState::TrailerLF   ;
+            else if( token == '\n' ) data().state = ChunkState::Done        ;
+            else                     data().state = ChunkState::TrailerLine ;
+            break ;
+
+          case ChunkState::TrailerLine :
+            // Trailer fields are not used by anything, so they are skipped rather than stored.
+            if( token == '\n' ) data().state = ChunkState::TrailerStart ;
+            break ;
+
+          case ChunkState::TrailerLF :
+            if( token != '\n' ) { data().invalidate() ; break ; }
+            data().state = ChunkState::Done ;
+            break ;
+
+          default : break ;
+        }
+      }
+
+      data().consumed = in ;
+      return out ;
+    }
+
+    unsigned ChunkedDecoder::consumed() const
+    {
+      return data().consumed ;
+    }
+
+    bool ChunkedDecoder::done() const
+    {
+      return data().state == ChunkState::Done ;
+    }
+
+    bool ChunkedDecoder::valid() const
+    {
+      return data().state != ChunkState::Invalid ;
+    }
+
+    void ChunkedDecoder::reset()
+    {
+      data().state     = ChunkState::Size ;
+      data().remaining = 0                ;
+      data().digits    = 0                ;
+      data().consumed  = 0                ;
+    }
+
+    ChunkedDecoderData& ChunkedDecoder::data()
+    {
+      return *this->decoder_data ;
+    }
+
+    const ChunkedDecoderData& ChunkedDecoder::data() const
+    {
+      return *this->decoder_data ;
+    }
+  }
+}
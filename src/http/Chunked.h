@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Chunked.h
+ * Author: Jordan Hendl
+ *
+ * Created on January 24, 2021, 3:12 PM
+ */
+
+#ifndef YGGDRASIL_CHUNKED_H
+#define YGGDRASIL_CHUNKED_H
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to incrementally decode a 'Transfer-Encoding: chunked' HTTP body.
+     * Data can be fed in any amount at a time, so chunk headers, chunk data & trailers are allowed to span packets.
+     */
+    class ChunkedDecoder
+    {
+      public:
+
+        /** Default constructor.
+         */
+        ChunkedDecoder() ;
+
+        /** Default deconstructor.
+         */
+        ~ChunkedDecoder() ;
+
+        /** Method to decode a block of chunked data in place, removing all of the chunk framing.
+         * @param data The data to decode. On return, the front of this buffer contains the decoded body bytes.
+         * @param size The amount of bytes in the input data.
+         * @return The amount of body bytes written to the front of the input data.
+         */
+        unsigned decode( char* data, unsigned size ) ;
+
+        /** Method to decode a block of chunked data into a caller provided buffer.
+         * @param input The chunked data to decode.
+         * @param size The amount of bytes in the input data.
+         * @param output The buffer to write the body to. Must be able to hold at least the input size in bytes.
+         * @return The amount of body bytes written to the output.
+         */
+        unsigned decode( const char* input, unsigned size, char* output ) ;
+
+        /** Method to retrieve how many input bytes were consumed by the last decode.
+         * @note This is only less than the input size when the body finished before the end of the input, i.e. the rest belongs to the next message.
+         * @return The amount of input bytes consumed by the last call to decode.
+         */
+        unsigned consumed() const ;
+
+        /** Method to retrieve whether or not the terminating chunk & trailers have been fully decoded.
+         * @return Whether or not the whole body has been decoded.
+         */
+        bool done() const ;
+
+        /** Method to retrieve whether or not the decoded stream has been well formed so far.
+         * @return Whether or not this decoder has seen valid chunked data.
+         */
+        bool valid() const ;
+
+        /** Method to reset this object to decode a new body.
+         */
+        void reset() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct ChunkedDecoderData *decoder_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        ChunkedDecoderData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const ChunkedDecoderData& data() const ;
+    };
+  }
+}
+
+#endif /* CHUNKED_H */
+
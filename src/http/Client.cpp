@@ -0,0 +1,587 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Client.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 11, 2021, 7:48 PM
+ */
+
+#include "Client.h"
+#include "Response.h"
+#include "Pool.h"
+#include "Url.h"
+#include "Parser.h"
+#include "Request.h"
+#include "Chunked.h"
+#include "Decompressor.h"
+#include <ygg/Yggdrasil.h>
+#include <ygg/Connection.h>
+#ifdef _WIN32
+  #include <win32/Win32.h>
+#elif __linux__
+  #include <linux/Linux.h>
+#endif
+
+#include <array>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The amount of times a request is sent before giving up on getting a response header.
+     * An idle pooled connection may have been closed by the server, so the first failure is retried on a fresh one.
+     */
+    static const unsigned REQUEST_ATTEMPTS = 2 ;
+
+    /** The default amount of redirects followed per request.
+     */
+    static const unsigned DEFAULT_REDIRECTS = 5 ;
+
+    /** Function to find whether or not a status code redirects to it's 'Location'.
+     * @param status The status code of a response.
+     * @return Whether or not the status code is a redirect.
+     */
+    static bool redirects( unsigned status ) ;
+
+    /** Function to find whether or not a method can be sent again without changing what it does, so a failed request can be retried.
+     * @param method The request method.
+     * @return Whether or not the method is idempotent.
+     */
+    static bool idempotent( const std::string& method ) ;
+
+    /** Function to find whether or not a header carries credentials, which must not be handed to another origin.
+     * @param name The C-string name of the header.
+     * @return Whether or not the header carries credentials.
+     */
+    static bool credential( const char* name ) ;
+
+    /** Function to resolve the 'Location' of a redirect against the URL that was requested.
+     * @param base The URL that was requested.
+     * @param location The C-string value of the 'Location' header.
+     * @return The absolute URL to request next.
+     */
+    static std::string resolve( const Url& base, const char* location ) ;
+
+    /** Sink to hand a body to a plain function.
+     */
+    struct FunctionSink : public Sink
+    {
+      using Function = bool ( * )( const unsigned char*, std::size_t, void* ) ;
+
+      Function function ; ///< The function to call with each block of the body.
+      void*    user     ; ///< The pointer handed to the function.
+
+      /** Method to hand a block of the body to the function.
+       * @param bytes The body bytes.
+       * @param amount The amount of body bytes.
+       * @return Whether or not the function accepted the bytes.
+       */
+      bool write( const unsigned char* bytes, std::size_t amount ) override ;
+    };
+
+    /** Sink to throw away the body of a redirect, so it's connection can be reused.
+     */
+    struct DiscardSink : public Sink
+    {
+      /** Method to throw away a block of the body.
+       * @param bytes The body bytes.
+       * @param amount The amount of body bytes.
+       * @return Always true.
+       */
+      bool write( const unsigned char* bytes, std::size_t amount ) override ;
+    };
+
+    /** Structure to contain a client's data.
+     */
+    struct ClientData
+    {
+      using Scratch = std::array<char, ygg::PACKET_SIZE>                 ;
+      using Headers = std::vector<std::pair<std::string, std::string>> ;
+
+      Pool*          pool     ; ///< The pool connections are taken from.
+      Pool           own_pool ; ///< The pool used if none was set.
+      Url            url      ; ///< The URL of the current request.
+      Request        request  ; ///< The builder of the request message.
+      Parser         parser   ; ///< The parser of the response header.
+      ChunkedDecoder decoder  ; ///< The decoder for chunked bodies.
+      Decompressor   inflater ; ///< The decompressor for gzip/deflate bodies.
+      Scratch        scratch  ; ///< The reused buffer for chunk-decoded data.
+      std::string    target   ; ///< The URL being requested, which the parsed URL views.
+      std::string    method   ; ///< The method of the request being made.
+      Headers        secrets  ; ///< The headers carrying credentials, only sent to the origin first requested.
+      unsigned       redirect ; ///< The maximum amount of redirects to follow.
+
+      /** Default constructor.
+       */
+      ClientData() ;
+
+      /** Method to hand a block of the body to a sink, decompressing it if needed.
+       * @param sink The sink to hand the body to.
+       * @param bytes The body bytes, with any transfer framing already removed.
+       * @param amount The amount of body bytes.
+       * @return Whether or not the sink accepted the bytes.
+       */
+      bool deliver( Sink& sink, const char* bytes, unsigned amount ) ;
+
+      /** Method to send the built request & parse the response header.
+       * Idempotent requests are retried once, in case a pooled connection turned out to be closed.
+       * @param parser The parser to parse the response header into.
+       * @return The connection the response is being read from, or nullptr if no header was received.
+       */
+      Pool::Link* open( Parser& parser ) ;
+
+      /** Method to read a response body off of a connection, handing it to a sink as it arrives.
+       * @param link The connection the response is read from.
+       * @param parser The parsed header of the response.
+       * @param sink The sink to hand the body to.
+       * @param head Whether or not the request was a HEAD, so there is no body.
+       * @param reusable Set to whether or not the connection can carry another request afterwards.
+       * @return Whether or not the whole body was received & accepted by the sink.
+       */
+      bool stream( Pool::Link& link, const Parser& parser, Sink& sink, bool head, bool& reusable ) ;
+
+      /** Method to make a request, following redirects, & hand the final response to a sink.
+       * @param method The C-string request method.
+       * @param url The C-string URL to request.
+       * @param body The body to send, or nullptr to send none.
+       * @param size The amount of bytes of the body to send.
+       * @param type The C-string 'Content-Type' of the body to send.
+       * @param parser The parser to parse the response header into.
+       * @param sink The sink to hand the response to.
+       * @return Whether or not the whole body was received & accepted by the sink.
+       */
+      bool exchange( const char* method, const char* url, const void* body, std::size_t size, const char* type, Parser& parser, Sink& sink ) ;
+    };
+
+    bool redirects( unsigned status )
+    {
+      return status == 301 || status == 302 || status == 303 || status == 307 || status == 308 ;
+    }
+
+    bool idempotent( const std::string& method )
+    {
+      return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS" || method == "TRACE" ;
+    }
+
+    bool credential( const char* name )
+    {
+      static const char* const names[] = { "Authorization", "Proxy-Authorization", "Cookie" } ;
+
+      for( const char* secret : names )
+      {
+        std::size_t index = 0 ;
+        while( secret[ index ] != '\0' && std::tolower( static_cast<unsigned char>( name[ index ] ) ) == std::tolower( static_cast<unsigned char>( secret[ index ] ) ) ) index++ ;
+        if( secret[ index ] == '\0' && name[ index ] == '\0' ) return true ;
+      }
+
+      return false ;
+    }
+
+    std::string resolve( const Url& base, const char* location )
+    {
+      std::string      target ;
+      std::string_view path   ;
+      const char*      iter   ;
+
+      // An absolute URL starts with a scheme, which is only letters, digits, '+', '-' & '.'.
+      for( iter = location; std::isalnum( static_cast<unsigned char>( *iter ) ) || *iter == '+' || *iter == '-' || *iter == '.'; iter++ ) {}
+      if( iter != location && std::strncmp( iter, "://", 3 ) == 0 ) return location ;
+
+      target = base.secure() ? "https:" : "http:" ;
+      if( std::strncmp( location, "//", 2 ) == 0 ) return target + location ;
+
+      target += "//" ;
+      target.append( base.authority().data(), base.authority().size() ) ;
+      if( location[ 0 ] != '/' )
+      {
+        // Relative locations replace the last segment of the requested path.
+        path = base.path() ;
+        target.append( path.data(), path.rfind( '/' ) + 1 ) ;
+      }
+
+      return target + location ;
+    }
+
+    bool Sink::header( const Parser& header )
+    {
+      static_cast<void>( header ) ;
+      return true ;
+    }
+
+    Sink::~Sink()
+    {
+
+    }
+
+    bool FunctionSink::write( const unsigned char* bytes, std::size_t amount )
+    {
+      return this->function( bytes, amount, this->user ) ;
+    }
+
+    bool DiscardSink::write( const unsigned char* bytes, std::size_t amount )
+    {
+      static_cast<void>( bytes  ) ;
+      static_cast<void>( amount ) ;
+      return true ;
+    }
+
+    ClientData::ClientData()
+    {
+      this->pool     = &this->own_pool  ;
+      this->redirect = DEFAULT_REDIRECTS ;
+    }
+
+    bool ClientData::deliver( Sink& sink, const char* bytes, unsigned amount )
+    {
+      unsigned produced ;
+
+      if( amount == 0 ) return true ;
+
+      if( this->inflater.active() )
+      {
+        produced = this->inflater.decompress( bytes, amount ) ;
+        if( !this->inflater.valid() ) return false ;
+
+        return produced == 0 || sink.write( this->inflater.output(), produced ) ;
+      }
+
+      return sink.write( reinterpret_cast<const unsigned char*>( bytes ), amount ) ;
+    }
+
+    Pool::Link* ClientData::open( Parser& parser )
+    {
+      Pool::Link* link     ;
+      ygg::Packet packet   ;
+      unsigned    attempts ;
+
+      // The server may have acted on a request whose response was lost, so only requests that are safe to repeat are sent again.
+      link     = nullptr ;
+      attempts = idempotent( this->method ) ? REQUEST_ATTEMPTS : 1 ;
+      for( unsigned attempt = 0; attempt < attempts && !parser.parsed(); attempt++ )
+      {
+        if( link != nullptr ) this->pool->release( this->url, link, false ) ;
+
+        parser.reset() ;
+        link = this->pool->acquire( this->url ) ;
+        if( link == nullptr ) break ;
+
+        link->send( this->request.payload(), this->request.size() ) ;
+        while( !parser.parsed() )
+        {
+          packet = link->recieve() ;
+          if( packet.size() == 0 ) break ;
+          parser.parse( packet ) ;
+
+          // Informational responses, e.g. 100 Continue or 103 Early Hints, come before the final one on the same connection.
+          while( parser.parsed() && parser.status() < 200 )
+          {
+            packet = parser.leftover() ;
+            parser.reset() ;
+            if( packet.size() != 0 ) parser.parse( packet ) ;
+          }
+        }
+      }
+
+      if( !parser.parsed() )
+      {
+        this->pool->release( this->url, link, false ) ;
+        return nullptr ;
+      }
+
+      return link ;
+    }
+
+    bool ClientData::stream( Pool::Link& link, const Parser& parser, Sink& sink, bool head, bool& reusable )
+    {
+      ygg::Packet packet    ;
+      const char* length    ;
+      unsigned    remaining ;
+      unsigned    amount    ;
+      unsigned    status    ;
+      bool        chunked   ;
+      bool        complete  ;
+
+      status   = parser.status() ;
+      packet   = parser.leftover() ;
+      reusable = std::string( parser.value( "Connection" ) ).find( "close" ) == std::string::npos ;
+      chunked  = std::string( parser.value( "Transfer-Encoding" ) ).find( "chunked" ) != std::string::npos ;
+      length   = parser.value( "Content-Length" ) ;
+      this->inflater.initialize( parser.value( "Content-Encoding" ) ) ;
+
+      // These responses never have a body, whatever their headers say.
+      if( head || status < 200 || status == 204 || status == 304 ) return true ;
+
+      if( chunked )
+      {
+        this->decoder.reset() ;
+        while( true )
+        {
+          amount = this->decoder.decode( packet.payload(), packet.size(), this->scratch.data() ) ;
+          if( !this->deliver( sink, this->scratch.data(), amount ) ) break ;
+
+          if( this->decoder.done() || !this->decoder.valid() ) break ;
+
+          packet = link.recieve() ;
+          if( packet.size() == 0 ) break ;
+        }
+
+        complete = this->decoder.done() ;
+      }
+      else if( length[ 0 ] != '\0' )
+      {
+        // Lengths too big to count are clamped rather than wrapped, so they can't pass for a short body.
+        remaining = static_cast<unsigned>( std::min<unsigned long long>( std::strtoull( length, nullptr, 10 ), std::numeric_limits<unsigned>::max() ) ) ;
+        while( true )
+        {
+          amount     = std::min( packet.size(), remaining ) ;
+          remaining -= amount ;
+          if( !this->deliver( sink, packet.payload(), amount ) ) break ;
+
+          if( remaining == 0 ) break ;
+
+          packet = link.recieve( std::min( remaining, ygg::PACKET_SIZE ) ) ;
+          if( packet.size() == 0 ) break ;
+        }
+
+        complete = remaining == 0 ;
+      }
+      else
+      {
+        // Without a length, the body runs until the server closes the connection.
+        reusable = false ;
+        complete = false ;
+        while( this->deliver( sink, packet.payload(), packet.size() ) )
+        {
+          packet = link.recieve() ;
+          if( packet.size() == 0 )
+          {
+            complete = true ;
+            break ;
+          }
+        }
+      }
+
+      // A body cut short, or one the sink stopped, leaves the rest of it on the wire.
+      reusable = reusable && complete ;
+      return complete ;
+    }
+
+    bool ClientData::exchange( const char* method, const char* url, const void* body, std::size_t size, const char* type, Parser& parser, Sink& sink )
+    {
+      DiscardSink discard  ;
+      Pool::Link* link     ;
+      std::string next     ;
+      const char* location ;
+      unsigned    status   ;
+      unsigned    origin   ;
+      bool        head     ;
+      bool        reusable ;
+      bool        complete ;
+
+      this->target = url    ;
+      this->method = method ;
+      head         = this->method == "HEAD" ;
+      origin       = 0 ;
+
+      for( unsigned hop = 0; true; hop++ )
+      {
+        parser.reset() ;
+        if( !this->url.parse( this->target ) )
+        {
+          ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidUrl ) ;
+          return false ;
+        }
+
+        this->request.setHost( this->url.authority() ) ;
+        this->request.clear() ;
+        this->request.begin( this->method, this->url.path(), this->url.query() ) ;
+        if( body != nullptr && type[ 0 ] != '\0' ) this->request.add( "Content-Type", type ) ;
+
+        // Credentials are only for the origin they were meant for. A redirect elsewhere, or to plain HTTP, goes without them.
+        if( hop == 0 ) origin = this->url.key() ;
+        if( this->url.key() == origin ) for( const auto& secret : this->secrets ) this->request.add( secret.first, secret.second ) ;
+        this->request.end( body, static_cast<unsigned>( size ) ) ;
+
+        link = this->open( parser ) ;
+        if( link == nullptr )
+        {
+          ygg::Yggdrasil::addError( Yggdrasil::Error::ConnectionFailure ) ;
+          return false ;
+        }
+
+        status   = parser.status() ;
+        location = parser.value( "Location" ) ;
+        if( hop == this->redirect || !redirects( status ) || location[ 0 ] == '\0' ) break ;
+
+        // The redirect's own body is read off the wire, so it's connection can carry the next request.
+        complete = this->stream( *link, parser, discard, head, reusable ) ;
+        next     = resolve( this->url, location ) ;
+        this->pool->release( this->url, link, complete && reusable ) ;
+        this->target = next ;
+
+        // A 303, or a 301/302 of a POST, is followed with a GET without the body, like browsers do.
+        if( status == 303 || ( status != 307 && status != 308 && this->method == "POST" ) )
+        {
+          if( !head ) this->method = "GET" ;
+          body = nullptr ;
+          size = 0       ;
+        }
+      }
+
+      if( !sink.header( parser ) )
+      {
+        this->pool->release( this->url, link, false ) ;
+        return false ;
+      }
+
+      complete = this->stream( *link, parser, sink, head, reusable ) ;
+      this->pool->release( this->url, link, reusable ) ;
+
+      return complete ;
+    }
+
+    Client::Client()
+    {
+      this->client_data = new ClientData() ;
+    }
+
+    Client::~Client()
+    {
+      delete this->client_data ;
+    }
+
+    void Client::setPool( Pool& pool )
+    {
+      data().pool = &pool ;
+    }
+
+    void Client::setCompression( bool value )
+    {
+      data().request.setHeader( "Accept-Encoding", value ? Decompressor::acceptEncoding() : "" ) ;
+    }
+
+    void Client::setHeader( const char* name, const char* value )
+    {
+      auto& secrets = data().secrets ;
+
+      if( !credential( name ) )
+      {
+        data().request.setHeader( name, value ) ;
+        return ;
+      }
+
+      for( auto iter = secrets.begin(); iter != secrets.end(); ++iter )
+      {
+        if( iter->first == name )
+        {
+          if( value[ 0 ] == '\0' ) secrets.erase( iter ) ;
+          else                     iter->second = value ;
+          return ;
+        }
+      }
+
+      if( value[ 0 ] != '\0' ) secrets.emplace_back( name, value ) ;
+    }
+
+    void Client::setRedirects( unsigned amount )
+    {
+      data().redirect = amount ;
+    }
+
+    bool Client::send( const char* method, const char* url, const void* body, std::size_t size, const char* type, Sink& sink )
+    {
+      return data().exchange( method, url, body, size, type, data().parser, sink ) ;
+    }
+
+    bool Client::get( const char* url, Sink& sink )
+    {
+      return data().exchange( "GET", url, nullptr, 0, "", data().parser, sink ) ;
+    }
+
+    bool Client::get( const char* url, bool ( *sink )( const unsigned char* bytes, std::size_t amount, void* user ), void* user )
+    {
+      FunctionSink function ;
+
+      function.function = sink ;
+      function.user     = user ;
+
+      return this->get( url, function ) ;
+    }
+
+    bool Client::get( const char* url, Response& response )
+    {
+      bool complete ;
+
+      response.prepare( false ) ;
+      complete = data().exchange( "GET", url, nullptr, 0, "", response.parser(), response ) ;
+      response.setUrl( data().target.c_str() ) ;
+
+      return complete ;
+    }
+
+    bool Client::head( const char* url, Response& response )
+    {
+      bool complete ;
+
+      response.prepare( true ) ;
+      complete = data().exchange( "HEAD", url, nullptr, 0, "", response.parser(), response ) ;
+      response.setUrl( data().target.c_str() ) ;
+
+      return complete ;
+    }
+
+    bool Client::post( const char* url, const void* body, std::size_t size, const char* type, Response& response )
+    {
+      bool complete ;
+
+      response.prepare( false ) ;
+      complete = data().exchange( "POST", url, body, size, type, response.parser(), response ) ;
+      response.setUrl( data().target.c_str() ) ;
+
+      return complete ;
+    }
+
+    unsigned Client::status() const
+    {
+      return data().parser.status() ;
+    }
+
+    const char* Client::value( const char* key ) const
+    {
+      return data().parser.value( key ) ;
+    }
+
+    ClientData& Client::data()
+    {
+      return *this->client_data ;
+    }
+
+    const ClientData& Client::data() const
+    {
+      return *this->client_data ;
+    }
+  }
+}
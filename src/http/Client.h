@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Client.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 11, 2021, 7:48 PM
+ */
+
+#ifndef YGGDRASIL_CLIENT_H
+#define YGGDRASIL_CLIENT_H
+
+#include <cstddef>
+
+namespace ygg
+{
+  namespace http
+  {
+    class Parser   ;
+    class Pool     ;
+    class Response ;
+
+    /** Abstract class for a consumer of a streamed response body.
+     * If you wish to receive a body as it arrives, inherit this class and implement the write() function.
+     * The connection is not read while the sink is working, so a slow sink slows the server down instead of the body piling up in memory.
+     */
+    class Sink
+    {
+      public:
+
+        /** Virtual method called once the response header is parsed, before any of the body.
+         * @param header The parsed header of the response.
+         * @return Whether or not to receive the body. False aborts the transfer.
+         */
+        virtual bool header( const Parser& header ) ;
+
+        /** Pure virtual method called with each block of the body as it arrives, with transfer & content encodings already removed.
+         * @param bytes The body bytes. Only valid for the duration of this call.
+         * @param amount The amount of body bytes.
+         * @return Whether or not to keep receiving the body. False aborts the transfer.
+         */
+        virtual bool write( const unsigned char* bytes, std::size_t amount ) = 0 ;
+
+        /** Virtual deconstructor.
+         */
+        virtual ~Sink() ;
+    };
+
+    /** Class to make HTTP/1.1 requests, handing response bodies to a sink as they arrive or collecting them into a Response.
+     * Connections are taken from a pool, so requests to the same origin reuse a kept-alive connection.
+     * Redirects are followed, so the sink only ever sees the final response.
+     */
+    class Client
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Client() ;
+
+        /** Default deconstructor.
+         */
+        ~Client() ;
+
+        /** Method to set the pool connections are taken from, to share connections between clients.
+         * @param pool The pool to use. It must outlive this object.
+         */
+        void setPool( Pool& pool ) ;
+
+        /** Method to set whether or not to request compressed bodies. Sinks always receive the decompressed body.
+         * @param value Whether or not to request a compressed body.
+         */
+        void setCompression( bool value ) ;
+
+        /** Method to set a header sent with every following request, e.g. 'User-Agent' or 'Authorization'.
+         * Credentials, i.e. 'Authorization', 'Proxy-Authorization' & 'Cookie', are not sent along redirects to another origin.
+         * @param name The name of the header.
+         * @param value The value of the header. An empty value removes the header.
+         */
+        void setHeader( const char* name, const char* value ) ;
+
+        /** Method to set how many redirects are followed before giving up on a request.
+         * @param amount The maximum amount of redirects to follow. 0 hands redirects to the caller like any other response.
+         */
+        void setRedirects( unsigned amount ) ;
+
+        /** Method to make a request, streaming the body of the response to a sink.
+         * @param method The C-string request method, e.g. "PUT".
+         * @param url The C-string URL to request.
+         * @param body The body to send, or nullptr to send none.
+         * @param size The amount of bytes of the body to send.
+         * @param type The C-string 'Content-Type' of the body to send. May be empty.
+         * @param sink The sink to hand the response to.
+         * @return Whether or not the whole body was received & accepted by the sink.
+         */
+        bool send( const char* method, const char* url, const void* body, std::size_t size, const char* type, Sink& sink ) ;
+
+        /** Method to GET a URL, streaming the body to a sink.
+         * @param url The C-string URL to request.
+         * @param sink The sink to hand the response to.
+         * @return Whether or not the whole body was received & accepted by the sink.
+         */
+        bool get( const char* url, Sink& sink ) ;
+
+        /** Method to GET a URL, streaming the body to a function.
+         * @param url The C-string URL to request.
+         * @param sink The function to call with each block of the body. Returning false aborts the transfer.
+         * @param user The pointer handed to every call of the function.
+         * @return Whether or not the whole body was received & accepted by the function.
+         */
+        bool get( const char* url, bool ( *sink )( const unsigned char* bytes, std::size_t amount, void* user ), void* user = nullptr ) ;
+
+        /** Method to GET a URL into a response.
+         * @param url The C-string URL to request.
+         * @param response The response to receive into.
+         * @return Whether or not the whole response was received.
+         */
+        bool get( const char* url, Response& response ) ;
+
+        /** Method to request only the header of a URL.
+         * @param url The C-string URL to request.
+         * @param response The response to receive into. It's body is always empty.
+         * @return Whether or not the header was received.
+         */
+        bool head( const char* url, Response& response ) ;
+
+        /** Method to POST a body to a URL.
+         * @param url The C-string URL to post to.
+         * @param body The body to send.
+         * @param size The amount of bytes of the body.
+         * @param type The C-string 'Content-Type' of the body, e.g. "application/json".
+         * @param response The response to receive into.
+         * @return Whether or not the whole response was received.
+         */
+        bool post( const char* url, const void* body, std::size_t size, const char* type, Response& response ) ;
+
+        /** Method to retrieve the status code of the last response streamed to a sink.
+         * @note Requests made into a Response are reported by the Response instead.
+         * @return The HTTP status code of the last response, or 0 if none was received.
+         */
+        unsigned status() const ;
+
+        /** Method to retrieve the value of a header of the last response streamed to a sink.
+         * @param key The header name to look up.
+         * @return The value of the header, or an empty string if it was not sent.
+         */
+        const char* value( const char* key ) const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct ClientData *client_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        ClientData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const ClientData& data() const ;
+    };
+  }
+}
+
+#endif /* CLIENT_H */
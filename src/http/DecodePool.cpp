@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DecodePool.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 17, 2021, 10:05 AM
+ */
+
+#include "DecodePool.h"
+#include "Image.h"
+
+#ifdef __linux__
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+namespace ygg
+{
+  /** Structure to describe a queued decode.
+   */
+  struct DecodeJob
+  {
+    Image*               image    ; ///< The image to decode into.
+    const unsigned char* bytes    ; ///< The encoded bytes.
+    std::size_t          size     ; ///< The amount of encoded bytes.
+    DecodeOptions        options  ; ///< How to decode the image.
+    std::promise<bool>   promise  ; ///< The promise to complete with whether or not the decode succeeded.
+  };
+
+  /** Structure to contain a single decoding thread & it's queue.
+   */
+  struct DecodeWorker
+  {
+    using Jobs = std::deque<DecodeJob> ;
+
+    Jobs        jobs   ; ///< The decodes queued on this thread. Taken from the front by it's owner, & from the back by others.
+    std::mutex  lock   ; ///< The lock guarding the queue.
+    std::thread thread ; ///< The thread running decodes.
+  };
+
+  /** Structure to contain a decode pool's data.
+   */
+  struct DecodePoolData
+  {
+    using Workers = std::vector<std::unique_ptr<DecodeWorker>> ;
+    using Cores   = std::vector<unsigned>                      ;
+
+    Workers                     workers  ; ///< The decoding threads, started with the first decode.
+    Cores                       cores    ; ///< The cores to pin the threads to, if any.
+    std::mutex                  lock     ; ///< The lock guarding starting, stopping & sleeping.
+    std::condition_variable     ready    ; ///< Signalled when a decode is queued, or the threads should stop.
+    std::atomic<std::ptrdiff_t> queued   ; ///< The amount of decodes not yet taken by a thread.
+    std::atomic<unsigned>       next     ; ///< The thread to queue the next decode from outside the pool on.
+    unsigned                    size     ; ///< The amount of threads to start.
+    bool                        stopping ; ///< Whether or not the threads should stop once every queue is empty.
+
+    /** Default constructor.
+     */
+    DecodePoolData() ;
+
+    /** Method to start the decoding threads.
+     */
+    void start() ;
+
+    /** Method to run a decoding thread until told to stop.
+     * @param index The index of the thread.
+     */
+    void work( unsigned index ) ;
+
+    /** Method to take a decode, from the thread's own queue if it has any, otherwise from another's.
+     * @param index The index of the thread taking a decode.
+     * @param job The decode to fill in.
+     * @return Whether or not a decode was taken.
+     */
+    bool take( unsigned index, DecodeJob& job ) ;
+
+    /** Function to pin a thread to a core.
+     * @param thread The thread to pin.
+     * @param core The index of the core.
+     */
+    static void pin( std::thread& thread, unsigned core ) ;
+  };
+
+  /** The pool the current thread decodes for, if any, so decodes it queues stay on it's own queue.
+   */
+  static thread_local const DecodePoolData* current_pool = nullptr ;
+
+  /** The index of the current thread in it's pool.
+   */
+  static thread_local unsigned current_worker = 0 ;
+
+  DecodePoolData::DecodePoolData()
+  {
+    this->queued   = 0     ;
+    this->next     = 0     ;
+    this->stopping = false ;
+    this->size     = std::max( 1u, std::thread::hardware_concurrency() ) ;
+  }
+
+  void DecodePoolData::pin( std::thread& thread, unsigned core )
+  {
+    #ifdef __linux__
+      cpu_set_t set ;
+
+      CPU_ZERO( &set ) ;
+      CPU_SET( core, &set ) ;
+      pthread_setaffinity_np( thread.native_handle(), sizeof( set ), &set ) ;
+    #else
+      static_cast<void>( thread ) ;
+      static_cast<void>( core   ) ;
+    #endif
+  }
+
+  void DecodePoolData::start()
+  {
+    for( unsigned index = 0; index < this->size; index++ )
+    {
+      this->workers.emplace_back( new DecodeWorker() ) ;
+    }
+
+    // Every queue exists before any thread starts, since threads look through all of them.
+    for( unsigned index = 0; index < this->size; index++ )
+    {
+      this->workers[ index ]->thread = std::thread( &DecodePoolData::work, this, index ) ;
+      if( !this->cores.empty() ) DecodePoolData::pin( this->workers[ index ]->thread, this->cores[ index % this->cores.size() ] ) ;
+    }
+  }
+
+  bool DecodePoolData::take( unsigned index, DecodeJob& job )
+  {
+    const unsigned count = this->workers.size() ;
+
+    for( unsigned offset = 0; offset < count; offset++ )
+    {
+      DecodeWorker&               worker = *this->workers[ ( index + offset ) % count ] ;
+      std::lock_guard<std::mutex> lock( worker.lock ) ;
+
+      if( worker.jobs.empty() ) continue ;
+
+      // The owner works through it's queue in order, while others steal the decodes it would reach last.
+      if( offset == 0 )
+      {
+        job = std::move( worker.jobs.front() ) ;
+        worker.jobs.pop_front() ;
+      }
+      else
+      {
+        job = std::move( worker.jobs.back() ) ;
+        worker.jobs.pop_back() ;
+      }
+
+      this->queued-- ;
+      return true ;
+    }
+
+    return false ;
+  }
+
+  void DecodePoolData::work( unsigned index )
+  {
+    current_pool   = this  ;
+    current_worker = index ;
+
+    while( true )
+    {
+      DecodeJob job ;
+
+      if( this->take( index, job ) )
+      {
+        job.promise.set_value( job.image->decode( job.bytes, job.size, job.options ) ) ;
+        continue ;
+      }
+
+      std::unique_lock<std::mutex> lock( this->lock ) ;
+
+      this->ready.wait( lock, [this]() { return this->stopping || this->queued > 0 ; } ) ;
+      if( this->stopping && this->queued <= 0 ) return ;
+    }
+  }
+
+  DecodePool::DecodePool()
+  {
+    this->pool_data = new DecodePoolData() ;
+  }
+
+  DecodePool::~DecodePool()
+  {
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+      data().stopping = true ;
+    }
+
+    // Threads only stop once every queue is empty, so every queued decode still completes.
+    data().ready.notify_all() ;
+    for( auto& worker : data().workers ) worker->thread.join() ;
+
+    delete this->pool_data ;
+  }
+
+  void DecodePool::setSize( unsigned amount )
+  {
+    std::lock_guard<std::mutex> lock( data().lock ) ;
+
+    if( data().workers.empty() ) data().size = amount != 0 ? amount : std::max( 1u, std::thread::hardware_concurrency() ) ;
+  }
+
+  void DecodePool::setAffinity( const unsigned* cores, unsigned count )
+  {
+    std::lock_guard<std::mutex> lock( data().lock ) ;
+
+    if( data().workers.empty() ) data().cores.assign( cores, cores + count ) ;
+  }
+
+  unsigned DecodePool::size() const
+  {
+    return data().size ;
+  }
+
+  std::future<bool> DecodePool::decode( Image& image, const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned max_width, unsigned max_height )
+  {
+    DecodeOptions options ;
+
+    options.format     = format     ;
+    options.max_width  = max_width  ;
+    options.max_height = max_height ;
+
+    return this->decode( image, bytes, size, options ) ;
+  }
+
+  std::future<bool> DecodePool::decode( Image& image, const unsigned char* bytes, std::size_t size, const DecodeOptions& options )
+  {
+    DecodeJob         job    ;
+    std::future<bool> future ;
+    unsigned          index  ;
+
+    job.image    = &image                   ;
+    job.bytes    = bytes                    ;
+    job.size     = size                     ;
+    job.options  = options                  ;
+    future       = job.promise.get_future() ;
+
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+      if( data().workers.empty() ) data().start() ;
+    }
+
+    // Decodes queued from outside are spread round the threads. Ones queued by a decoding thread stay on it's queue.
+    index = current_pool == &data() ? current_worker : data().next++ % data().workers.size() ;
+
+    {
+      std::lock_guard<std::mutex> lock( data().workers[ index ]->lock ) ;
+      data().workers[ index ]->jobs.push_back( std::move( job ) ) ;
+    }
+
+    // Counted under the lock the threads sleep on, so none can miss it.
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+      data().queued++ ;
+    }
+
+    data().ready.notify_one() ;
+    return future ;
+  }
+
+  DecodePoolData& DecodePool::data()
+  {
+    return *this->pool_data ;
+  }
+
+  const DecodePoolData& DecodePool::data() const
+  {
+    return *this->pool_data ;
+  }
+}
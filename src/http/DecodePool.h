@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DecodePool.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 17, 2021, 10:05 AM
+ */
+
+#ifndef YGGDRASIL_DECODE_POOL_H
+#define YGGDRASIL_DECODE_POOL_H
+
+#include "Image.h"
+#include <future>
+#include <cstddef>
+
+namespace ygg
+{
+  /** Class to decode images on a set of dedicated threads.
+   * Each thread has it's own queue of decodes, & a thread with nothing left to do takes decodes from the back of the others' queues.
+   * A thread stuck on one huge image therefore only holds up that image; everything queued behind it is picked up by the rest.
+   */
+  class DecodePool
+  {
+    public:
+
+      /** Default constructor.
+       */
+      DecodePool() ;
+
+      /** Default deconstructor. Waits for every queued decode to complete.
+       */
+      ~DecodePool() ;
+
+      /** Method to set the amount of decoding threads.
+       * @note Only takes effect before the first decode is queued.
+       * @param amount The amount of threads. 0 uses one per core.
+       */
+      void setSize( unsigned amount ) ;
+
+      /** Method to pin the decoding threads to cores, so their caches stay warm.
+       * @note Only takes effect before the first decode is queued. Threads are not pinned by default.
+       * @param cores The indices of the cores to pin to. Thread N is pinned to cores[ N % count ].
+       * @param count The amount of cores. 0 leaves the threads unpinned.
+       */
+      void setAffinity( const unsigned* cores, unsigned count ) ;
+
+      /** Method to retrieve the amount of decoding threads.
+       * @return The amount of threads decodes are spread over.
+       */
+      unsigned size() const ;
+
+      /** Method to queue an image to be decoded.
+       * @note The image & the encoded bytes must outlive the decode.
+       * @param image The image to decode into.
+       * @param bytes The encoded .png/jpeg/whatever bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to. PixelFormat::Native keeps the channels of the source.
+       * @param max_width The widest the decoded image may be. 0 for no limit.
+       * @param max_height The tallest the decoded image may be. 0 for no limit.
+       * @return The future of whether or not the image could be decoded.
+       */
+      std::future<bool> decode( Image& image, const unsigned char* bytes, std::size_t size, PixelFormat format = PixelFormat::Rgba, unsigned max_width = 0, unsigned max_height = 0 ) ;
+
+      /** Method to queue an image to be decoded with the backend registered for it's encoding.
+       * @note The image & the encoded bytes must outlive the decode.
+       * @param image The image to decode into.
+       * @param bytes The encoded .png/jpeg/whatever bytes.
+       * @param size The amount of encoded bytes.
+       * @param options The format, size limits & encoding hint to decode with.
+       * @return The future of whether or not the image could be decoded.
+       */
+      std::future<bool> decode( Image& image, const unsigned char* bytes, std::size_t size, const DecodeOptions& options ) ;
+
+    private:
+
+      /** The forward declared structure containing this object's data.
+       */
+      struct DecodePoolData *pool_data ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      DecodePoolData& data() ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      const DecodePoolData& data() const ;
+  };
+}
+
+#endif /* DECODE_POOL_H */
@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Decoder.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 20, 2021, 11:15 AM
+ */
+
+#include "Decoder.h"
+#include "stb_image.h"
+
+#ifdef YGGDRASIL_HTTP_LIBJPEG
+  #include <cstdio>
+  #include <csetjmp>
+  #include <jpeglib.h>
+#endif
+
+#ifdef YGGDRASIL_HTTP_SPNG
+  #include <spng.h>
+#endif
+
+#include <atomic>
+#include <string>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+namespace ygg
+{
+  /** The amount of encodings backends can be set for.
+   */
+  static const unsigned FORMAT_COUNT = static_cast<unsigned>( ImageFormat::Tga ) + 1 ;
+
+  /** The backends set for each encoding, if any.
+   */
+  static std::atomic<ImageDecoder*> registered[ FORMAT_COUNT ] ;
+
+  /** Function to find how many halvings of an image keep it no smaller than a size, as far as 1/8 scale.
+   * @param width The width of the image.
+   * @param height The height of the image.
+   * @param out_width The width it is going to be shrunk to.
+   * @param out_height The height it is going to be shrunk to.
+   * @return The amount of halvings, 0 to 3. Each rounds up, as JPEG decoders do.
+   */
+  static unsigned halvings( unsigned width, unsigned height, unsigned out_width, unsigned out_height )
+  {
+    unsigned scale = 0 ;
+
+    if( out_width == 0 || out_height == 0 ) return 0 ;
+
+    while( scale < 3 && ( ( width  + ( 2u << scale ) - 1 ) >> ( scale + 1 ) ) >= out_width
+                     && ( ( height + ( 2u << scale ) - 1 ) >> ( scale + 1 ) ) >= out_height ) scale++ ;
+
+    return scale ;
+  }
+
+  /** Structure to describe the conversion done on each row of a JPEG as STB writes it.
+   */
+  struct RowConversion
+  {
+    PixelFormat from ; ///< The format the decoder writes.
+    PixelFormat to   ; ///< The format to convert each row to.
+  };
+
+  /** Function called by STB with each finished row, converting it in place while it is still in cache.
+   * @param user The row conversion to do.
+   * @param row The pixels of the row.
+   * @param width The amount of pixels in the row.
+   * @param channels The amount of channels of each pixel.
+   */
+  static void convertRow( void* user, stbi_uc* row, int width, int channels )
+  {
+    const RowConversion* conversion = static_cast<const RowConversion*>( user ) ;
+
+    static_cast<void>( channels ) ;
+    pixels::convert( row, conversion->from, row, conversion->to, static_cast<std::size_t>( width ) ) ;
+  }
+
+  /** Class to decode images with STB, which understands every encoding.
+   */
+  class StbDecoder : public ImageDecoder
+  {
+    public:
+
+      /** Method to retrieve whether or not this backend can decode an encoding.
+       * @param type The encoding.
+       * @return Whether or not images of this encoding can be decoded.
+       */
+      bool supports( ImageFormat type ) const override ;
+
+      /** Method to decode an encoded image.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to.
+       * @param width The width the image is going to be shrunk to, or 0.
+       * @param height The height the image is going to be shrunk to, or 0.
+       * @param image The decoded pixels to fill in.
+       * @return Whether or not the image could be decoded.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image ) override ;
+  };
+
+  bool StbDecoder::supports( ImageFormat type ) const
+  {
+    return type != ImageFormat::Unknown ;
+  }
+
+  bool StbDecoder::decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image )
+  {
+    RowConversion     conversion ;
+    stbi_row_callback callback   ;
+    unsigned char*    pixels     ;
+    unsigned          out_chan   ;
+    int               in_width   ;
+    int               in_height  ;
+    int               chan       ;
+    int               scale      ;
+    bool              jpeg       ;
+
+    scale = 0 ;
+
+    if( size > static_cast<std::size_t>( std::numeric_limits<int>::max() ) ) return false ;
+
+    jpeg = decoders::sniff( bytes, size ) == ImageFormat::Jpeg ;
+
+    // JPEGs are shrunk by halves inside the decoder, as far as they go without becoming smaller than asked for.
+    if( jpeg && width != 0 && stbi_info_from_memory( bytes, static_cast<int>( size ), &in_width, &in_height, &chan ) != 0 )
+    {
+      scale = static_cast<int>( halvings( static_cast<unsigned>( in_width ), static_cast<unsigned>( in_height ), width, height ) ) ;
+    }
+
+    // The decoder produces the format's channels in the standard order. JPEGs have no alpha, so they are only ever reordered, row by row.
+    out_chan        = pixels::channels( format ) ;
+    conversion.from = pixels::standard( out_chan ) ;
+    conversion.to   = jpeg ? pixels::straight( format ) : conversion.from ;
+    callback        = conversion.from != conversion.to ? &convertRow : nullptr ;
+
+    // Asking for 0 channels keeps the source's.
+    pixels = stbi_load_from_memory_ex( bytes, static_cast<int>( size ), &in_width, &in_height, &chan, static_cast<int>( out_chan ), scale, callback, &conversion ) ;
+    if( pixels == nullptr ) return false ;
+
+    image.pixels = pixels                                                           ;
+    image.width  = static_cast<unsigned>( in_width  )                               ;
+    image.height = static_cast<unsigned>( in_height )                               ;
+    image.source = static_cast<unsigned>( chan      )                               ;
+    image.format = out_chan != 0 ? conversion.to : pixels::standard( image.source ) ;
+
+    return true ;
+  }
+
+  #ifdef YGGDRASIL_HTTP_LIBJPEG
+  /** Structure to route libjpeg's errors back to the decode that hit them.
+   */
+  struct JpegError
+  {
+    jpeg_error_mgr manager ; ///< The error handler libjpeg calls.
+    std::jmp_buf   jump    ; ///< Where to return to when libjpeg can not go on.
+  };
+
+  /** Function called by libjpeg when it can not go on, returning to the decode instead of exiting.
+   * @param info The decode that failed.
+   */
+  static void jpegExit( j_common_ptr info )
+  {
+    std::longjmp( reinterpret_cast<JpegError*>( info->err )->jump, 1 ) ;
+  }
+
+  /** Function called by libjpeg with warnings, which are not printed.
+   * @param info The decode warned about.
+   */
+  static void jpegMessage( j_common_ptr info )
+  {
+    static_cast<void>( info ) ;
+  }
+
+  /** Class to decode JPEGs with libjpeg-turbo.
+   * Besides it's faster IDCT, it writes any RGB(A) order directly & decodes at 1/2, 1/4 or 1/8 scale like STB.
+   */
+  class LibjpegDecoder : public ImageDecoder
+  {
+    public:
+
+      /** Method to retrieve whether or not this backend can decode an encoding.
+       * @param type The encoding.
+       * @return Whether or not images of this encoding can be decoded.
+       */
+      bool supports( ImageFormat type ) const override ;
+
+      /** Method to decode an encoded image.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to.
+       * @param width The width the image is going to be shrunk to, or 0.
+       * @param height The height the image is going to be shrunk to, or 0.
+       * @param image The decoded pixels to fill in.
+       * @return Whether or not the image could be decoded.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image ) override ;
+  };
+
+  bool LibjpegDecoder::supports( ImageFormat type ) const
+  {
+    return type == ImageFormat::Jpeg ;
+  }
+
+  bool LibjpegDecoder::decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image )
+  {
+    jpeg_decompress_struct   info   ;
+    JpegError                error  ;
+    JSAMPROW                 row    ;
+    std::size_t              stride ;
+    unsigned char* volatile  pixels ;
+
+    pixels                       = nullptr ;
+    info.err                     = jpeg_std_error( &error.manager ) ;
+    error.manager.error_exit     = &jpegExit    ;
+    error.manager.output_message = &jpegMessage ;
+
+    // Everything libjpeg fails on lands back here, after which only what lives in memory is trusted.
+    if( setjmp( error.jump ) != 0 )
+    {
+      jpeg_destroy_decompress( &info ) ;
+      std::free( pixels ) ;
+      return false ;
+    }
+
+    jpeg_create_decompress( &info ) ;
+    jpeg_mem_src( &info, bytes, static_cast<unsigned long>( size ) ) ;
+    jpeg_read_header( &info, TRUE ) ;
+
+    // CMYK has to be inverted & multiplied out, which STB already does.
+    if( info.jpeg_color_space == JCS_CMYK || info.jpeg_color_space == JCS_YCCK )
+    {
+      jpeg_destroy_decompress( &info ) ;
+      return decoders::stb().decode( bytes, size, format, width, height, image ) ;
+    }
+
+    // libjpeg-turbo writes every order directly. JPEGs have no alpha, so premultiplied formats are the straight ones & grey-alpha is grey.
+    switch( format )
+    {
+      case PixelFormat::Grey              :
+      case PixelFormat::GreyAlpha         : info.out_color_space = JCS_GRAYSCALE ; image.format = PixelFormat::Grey ; break ;
+      case PixelFormat::Rgb               : info.out_color_space = JCS_EXT_RGB   ; image.format = PixelFormat::Rgb  ; break ;
+      case PixelFormat::Bgr               : info.out_color_space = JCS_EXT_BGR   ; image.format = PixelFormat::Bgr  ; break ;
+      case PixelFormat::Rgba              :
+      case PixelFormat::RgbaPremultiplied : info.out_color_space = JCS_EXT_RGBA  ; image.format = PixelFormat::Rgba ; break ;
+      case PixelFormat::Bgra              :
+      case PixelFormat::BgraPremultiplied : info.out_color_space = JCS_EXT_BGRA  ; image.format = PixelFormat::Bgra ; break ;
+      default                             : image.format = info.num_components == 1 ? PixelFormat::Grey : PixelFormat::Rgb ; break ;
+    }
+
+    info.scale_num   = 1 ;
+    info.scale_denom = 1u << halvings( info.image_width, info.image_height, width, height ) ;
+
+    jpeg_start_decompress( &info ) ;
+
+    stride = static_cast<std::size_t>( info.output_width ) * info.output_components ;
+    pixels = static_cast<unsigned char*>( std::malloc( stride * info.output_height ) ) ;
+    if( pixels == nullptr ) error.manager.error_exit( reinterpret_cast<j_common_ptr>( &info ) ) ;
+
+    while( info.output_scanline < info.output_height )
+    {
+      row = pixels + info.output_scanline * stride ;
+      jpeg_read_scanlines( &info, &row, 1 ) ;
+    }
+
+    image.pixels = pixels                                       ;
+    image.width  = info.output_width                            ;
+    image.height = info.output_height                           ;
+    image.source = static_cast<unsigned>( info.num_components ) ;
+
+    jpeg_finish_decompress ( &info ) ;
+    jpeg_destroy_decompress( &info ) ;
+
+    return true ;
+  }
+  #endif
+
+  #ifdef YGGDRASIL_HTTP_SPNG
+  /** Class to decode PNGs with libspng.
+   * It inflates & unfilters considerably faster than STB, & is what PNGs spend most of their time on.
+   */
+  class SpngDecoder : public ImageDecoder
+  {
+    public:
+
+      /** Method to retrieve whether or not this backend can decode an encoding.
+       * @param type The encoding.
+       * @return Whether or not images of this encoding can be decoded.
+       */
+      bool supports( ImageFormat type ) const override ;
+
+      /** Method to decode an encoded image.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to.
+       * @param width Unused, PNGs can only be decoded at full size.
+       * @param height Unused, PNGs can only be decoded at full size.
+       * @param image The decoded pixels to fill in.
+       * @return Whether or not the image could be decoded.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image ) override ;
+  };
+
+  bool SpngDecoder::supports( ImageFormat type ) const
+  {
+    return type == ImageFormat::Png ;
+  }
+
+  bool SpngDecoder::decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image )
+  {
+    spng_ctx*       context ;
+    spng_ihdr       header  ;
+    spng_trns       trns    ;
+    unsigned char*  pixels  ;
+    std::size_t     length  ;
+    int             out     ;
+    bool            alpha   ;
+    bool            result  ;
+
+    static_cast<void>( width  ) ;
+    static_cast<void>( height ) ;
+
+    context = spng_ctx_new( 0 ) ;
+    pixels  = nullptr           ;
+    result  = false             ;
+    if( context == nullptr ) return false ;
+
+    if( spng_set_png_buffer( context, bytes, size ) == 0 && spng_get_ihdr( context, &header ) == 0 )
+    {
+      // Palette & plain images only have alpha if they carry a transparency chunk.
+      alpha        = ( header.color_type & 4 ) != 0 || spng_get_trns( context, &trns ) == 0 ;
+      out          = alpha || pixels::channels( format ) == 4 ? SPNG_FMT_RGBA8 : SPNG_FMT_RGB8 ;
+      image.format = out == SPNG_FMT_RGBA8 ? PixelFormat::Rgba : PixelFormat::Rgb ;
+
+      switch( header.color_type )
+      {
+        case SPNG_COLOR_TYPE_GRAYSCALE       : image.source = alpha ? 2 : 1 ; break ;
+        case SPNG_COLOR_TYPE_GRAYSCALE_ALPHA : image.source = 2             ; break ;
+        default                              : image.source = alpha ? 4 : 3 ; break ;
+      }
+
+      if( format == PixelFormat::Native ) image.format = pixels::standard( image.source ) ;
+
+      if( spng_decoded_image_size( context, out, &length ) == 0 )
+      {
+        pixels = static_cast<unsigned char*>( std::malloc( length ) ) ;
+        result = pixels != nullptr && spng_decode_image( context, pixels, length, out, SPNG_DECODE_TRNS ) == 0 ;
+      }
+    }
+
+    spng_ctx_free( context ) ;
+
+    if( !result )
+    {
+      std::free( pixels ) ;
+      return false ;
+    }
+
+    // Grey sources decoded as RGB(A) are narrowed back down when the source's own channels were asked for.
+    if( format == PixelFormat::Native && image.source <= 2 )
+    {
+      pixels::convert( pixels, pixels::standard( out == SPNG_FMT_RGBA8 ? 4 : 3 ), pixels, image.format, static_cast<std::size_t>( header.width ) * header.height ) ;
+    }
+
+    image.pixels = pixels        ;
+    image.width  = header.width  ;
+    image.height = header.height ;
+
+    return true ;
+  }
+  #endif
+
+  DecodedImage::DecodedImage()
+  {
+    this->pixels = nullptr             ;
+    this->width  = 0                   ;
+    this->height = 0                   ;
+    this->source = 0                   ;
+    this->format = PixelFormat::Native ;
+  }
+
+  namespace decoders
+  {
+    ImageDecoder& stb()
+    {
+      static StbDecoder decoder ;
+      return decoder ;
+    }
+
+    ImageDecoder* libjpeg()
+    {
+      #ifdef YGGDRASIL_HTTP_LIBJPEG
+        static LibjpegDecoder decoder ;
+        return &decoder ;
+      #else
+        return nullptr ;
+      #endif
+    }
+
+    ImageDecoder* spng()
+    {
+      #ifdef YGGDRASIL_HTTP_SPNG
+        static SpngDecoder decoder ;
+        return &decoder ;
+      #else
+        return nullptr ;
+      #endif
+    }
+
+    void set( ImageFormat type, ImageDecoder* decoder )
+    {
+      registered[ static_cast<unsigned>( type ) ] = decoder ;
+    }
+
+    ImageDecoder& find( ImageFormat type )
+    {
+      ImageDecoder* decoder = registered[ static_cast<unsigned>( type ) ] ;
+
+      if( decoder != nullptr                                ) return *decoder   ;
+      if( libjpeg() != nullptr && libjpeg()->supports( type ) ) return *libjpeg() ;
+      if( spng()    != nullptr && spng()   ->supports( type ) ) return *spng()    ;
+      return stb() ;
+    }
+
+    ImageFormat sniff( const unsigned char* bytes, std::size_t size )
+    {
+      auto starts = [&]( const char* magic, std::size_t length )
+      {
+        return size >= length && std::memcmp( bytes, magic, length ) == 0 ;
+      };
+
+      if( starts( "\x89PNG"        , 4  )                              ) return ImageFormat::Png  ;
+      if( starts( "\xFF\xD8\xFF"   , 3  )                              ) return ImageFormat::Jpeg ;
+      if( starts( "GIF8"           , 4  )                              ) return ImageFormat::Gif  ;
+      if( starts( "BM"             , 2  )                              ) return ImageFormat::Bmp  ;
+      if( starts( "8BPS"           , 4  )                              ) return ImageFormat::Psd  ;
+      if( starts( "#?RADIANCE"     , 10 ) || starts( "#?RGBE", 6 )     ) return ImageFormat::Hdr  ;
+      if( starts( "S\x80\xF6\x34"  , 4  )                              ) return ImageFormat::Pic  ;
+      if( starts( "P5"             , 2  ) || starts( "P6"    , 2 )     ) return ImageFormat::Pnm  ;
+      return ImageFormat::Unknown ;
+    }
+
+    ImageFormat type( const char* content_type )
+    {
+      std::string media ;
+
+      if( content_type == nullptr ) return ImageFormat::Unknown ;
+
+      // Only the media type itself matters, not any parameters after it.
+      for( const char* character = content_type; *character != '\0' && *character != ';'; character++ )
+      {
+        if( !std::isspace( static_cast<unsigned char>( *character ) ) ) media += static_cast<char>( std::tolower( static_cast<unsigned char>( *character ) ) ) ;
+      }
+
+      if( media.compare( 0, 6, "image/" ) != 0 ) return ImageFormat::Unknown ;
+      media.erase( 0, 6 ) ;
+
+      if( media == "png"  || media == "apng"                          ) return ImageFormat::Png  ;
+      if( media == "jpeg" || media == "jpg" || media == "pjpeg"       ) return ImageFormat::Jpeg ;
+      if( media == "gif"                                              ) return ImageFormat::Gif  ;
+      if( media == "bmp"  || media == "x-bmp" || media == "x-ms-bmp"  ) return ImageFormat::Bmp  ;
+      if( media == "vnd.adobe.photoshop" || media == "x-photoshop"    ) return ImageFormat::Psd  ;
+      if( media == "vnd.radiance" || media == "x-hdr"                 ) return ImageFormat::Hdr  ;
+      if( media == "x-pict" || media == "x-softimage-pic"             ) return ImageFormat::Pic  ;
+      if( media.compare( 0, 11, "x-portable-" ) == 0                  ) return ImageFormat::Pnm  ;
+      if( media == "x-tga" || media == "x-targa" || media == "tga"    ) return ImageFormat::Tga  ;
+      return ImageFormat::Unknown ;
+    }
+  }
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Decoder.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 20, 2021, 11:15 AM
+ */
+
+#ifndef YGGDRASIL_DECODER_H
+#define YGGDRASIL_DECODER_H
+
+#include "Image.h"
+#include <cstddef>
+
+namespace ygg
+{
+  /** Structure to describe the pixels a decoder backend produced.
+   */
+  struct DecodedImage
+  {
+    unsigned char* pixels ; ///< The pixels, allocated with std::malloc. Released by whoever the image is handed to.
+    unsigned       width  ; ///< The width of the pixels.
+    unsigned       height ; ///< The height of the pixels.
+    unsigned       source ; ///< The number of channels of the encoded image.
+    PixelFormat    format ; ///< The format of the pixels. Never PixelFormat::Native.
+
+    /** Default constructor. Describes no pixels.
+     */
+    DecodedImage() ;
+  };
+
+  /** Class to describe a backend able to decode some encodings.
+   * Backends only need to get close: whatever format & size they produce is converted & shrunk the rest of the way by the image.
+   */
+  class ImageDecoder
+  {
+    public:
+
+      /** Virtual deconstructor.
+       */
+      virtual ~ImageDecoder() = default ;
+
+      /** Pure virtual method to retrieve whether or not this backend can decode an encoding.
+       * @param type The encoding.
+       * @return Whether or not images of this encoding can be decoded.
+       */
+      virtual bool supports( ImageFormat type ) const = 0 ;
+
+      /** Pure virtual method to decode an encoded image.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to, if the backend can. PixelFormat::Native asks for the standard format of the source's channels.
+       * @param width The width the image is going to be shrunk to. Backends may decode smaller than full size, but never narrower than this. 0 for full size.
+       * @param height The height the image is going to be shrunk to. Backends may decode smaller than full size, but never shorter than this. 0 for full size.
+       * @param image The decoded pixels to fill in.
+       * @return Whether or not the image could be decoded.
+       */
+      virtual bool decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned width, unsigned height, DecodedImage& image ) = 0 ;
+  };
+
+  /** Functions to choose the backend each encoding is decoded with.
+   * STB decodes everything by default. Builds with libjpeg-turbo or libspng found decode JPEGs & PNGs with those instead.
+   */
+  namespace decoders
+  {
+    /** Function to retrieve the STB backend, which decodes every encoding.
+     * @return A reference to the STB backend.
+     */
+    ImageDecoder& stb() ;
+
+    /** Function to retrieve the libjpeg-turbo backend, which decodes JPEGs.
+     * @return A pointer to the backend. nullptr if this library was built without libjpeg-turbo.
+     */
+    ImageDecoder* libjpeg() ;
+
+    /** Function to retrieve the libspng backend, which decodes PNGs.
+     * @return A pointer to the backend. nullptr if this library was built without libspng.
+     */
+    ImageDecoder* spng() ;
+
+    /** Function to set the backend to decode an encoding with, in place of the default.
+     * @note The backend must outlive every decode using it. Backends are shared by every thread, so must be safe to call from several at once.
+     * @param type The encoding to decode with the backend.
+     * @param decoder The backend to use. nullptr restores the default.
+     */
+    void set( ImageFormat type, ImageDecoder* decoder ) ;
+
+    /** Function to retrieve the backend an encoding is decoded with.
+     * @param type The encoding.
+     * @return The backend set for it if any, otherwise libjpeg-turbo or libspng if built in & able to, otherwise STB.
+     */
+    ImageDecoder& find( ImageFormat type ) ;
+
+    /** Function to tell the encoding of an image from it's leading bytes.
+     * @param bytes The start of the encoded image.
+     * @param size The amount of bytes available.
+     * @return The encoding of the image. ImageFormat::Unknown if it has no known signature, as TGAs do not.
+     */
+    ImageFormat sniff( const unsigned char* bytes, std::size_t size ) ;
+
+    /** Function to tell the encoding of an image from the media type it was served as.
+     * @param content_type The value of a Content-Type header, e.g. "image/png". Parameters & case are ignored.
+     * @return The encoding named. ImageFormat::Unknown if it is not an image type, or nullptr.
+     */
+    ImageFormat type( const char* content_type ) ;
+  }
+}
+
+#endif /* DECODER_H */
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Decompressor.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on January 25, 2021, 7:40 PM
+ */
+
+#include "Decompressor.h"
+#include <ygg/Yggdrasil.h>
+#include <zlib.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cctype>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The granularity that the output buffer grows by when a block does not fit.
+     */
+    static const unsigned GROWTH_SIZE = 32768 ;
+
+    /** The compression formats understood by the decompressor.
+     */
+    enum class Encoding
+    {
+      Identity,
+      Gzip,
+      Deflate
+    };
+
+    /** Structure to contain a decompressor's data.
+     */
+    struct DecompressorData
+    {
+      using Buffer = std::vector<unsigned char> ;
+
+      z_stream stream      ;
+      Buffer   output      ;
+      Encoding encoding    ;
+      bool     initialized ;
+      bool     done        ;
+      bool     valid       ;
+
+      /** Default constructor.
+       */
+      DecompressorData() ;
+
+      /** Method to start the zlib stream once the stream format is known.
+       * @param first The first byte of the compressed stream.
+       */
+      void start( unsigned char first ) ;
+
+      /** Method to release the zlib stream, if one was started.
+       */
+      void release() ;
+    };
+
+    DecompressorData::DecompressorData()
+    {
+      this->stream      = z_stream()         ;
+      this->encoding    = Encoding::Identity ;
+      this->initialized = false              ;
+      this->done        = false              ;
+      this->valid       = true               ;
+    }
+
+    void DecompressorData::start( unsigned char first )
+    {
+      int window ;
+
+      // 'deflate' is meant to be zlib wrapped, but plenty of servers send raw deflate. A zlib header always starts with method 8 & a window of at most 32K.
+      if( this->encoding == Encoding::Gzip ) window = 15 + 16 ;
+      else                                   window = ( ( first & 0x0F ) == 8 && ( first >> 4 ) <= 7 ) ? 15 : -15 ;
+
+      this->stream = z_stream() ;
+      if( inflateInit2( &this->stream, window ) != Z_OK )
+      {
+        ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+        this->valid = false ;
+        return ;
+      }
+
+      this->initialized = true ;
+    }
+
+    void DecompressorData::release()
+    {
+      if( this->initialized ) inflateEnd( &this->stream ) ;
+      this->initialized = false ;
+    }
+
+    Decompressor::Decompressor()
+    {
+      this->decompressor_data = new DecompressorData() ;
+    }
+
+    Decompressor::~Decompressor()
+    {
+      data().release() ;
+      delete this->decompressor_data ;
+    }
+
+    const char* Decompressor::acceptEncoding()
+    {
+      return "gzip, deflate" ;
+    }
+
+    bool Decompressor::initialize( const char* content_encoding )
+    {
+      std::string encoding = content_encoding ;
+
+      this->reset() ;
+      std::transform( encoding.begin(), encoding.end(), encoding.begin(), []( unsigned char c ) { return std::tolower( c ) ; } ) ;
+
+      if     ( encoding.find( "gzip"    ) != std::string::npos ) data().encoding = Encoding::Gzip     ;
+      else if( encoding.find( "deflate" ) != std::string::npos ) data().encoding = Encoding::Deflate  ;
+      else                                                       data().encoding = Encoding::Identity ;
+
+      return this->active() ;
+    }
+
+    unsigned Decompressor::decompress( const char* input, unsigned size )
+    {
+      unsigned produced ;
+      int      result   ;
+
+      produced = 0 ;
+      if( size == 0 || !this->active() || data().done || !data().valid ) return 0 ;
+      if( !data().initialized ) data().start( static_cast<unsigned char>( input[ 0 ] ) ) ;
+      if( !data().valid       ) return 0 ;
+
+      data().stream.next_in  = reinterpret_cast<Bytef*>( const_cast<char*>( input ) ) ;
+      data().stream.avail_in = size ;
+
+      // Inflate until the whole input is used, growing the reused output buffer only when a block does not fit.
+      do
+      {
+        if( data().output.size() - produced < GROWTH_SIZE / 2 ) data().output.resize( data().output.size() + GROWTH_SIZE ) ;
+
+        data().stream.next_out  = data().output.data() + produced ;
+        data().stream.avail_out = static_cast<uInt>( data().output.size() - produced ) ;
+
+        result    = inflate( &data().stream, Z_NO_FLUSH ) ;
+        produced  = static_cast<unsigned>( data().stream.next_out - data().output.data() ) ;
+
+        if( result == Z_STREAM_END )
+        {
+          data().done = true ;
+          break ;
+        }
+
+        if( result != Z_OK && result != Z_BUF_ERROR )
+        {
+          ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+          data().valid = false ;
+          break ;
+        }
+      } while( data().stream.avail_in != 0 || data().stream.avail_out == 0 ) ;
+
+      return produced ;
+    }
+
+    const unsigned char* Decompressor::output() const
+    {
+      return data().output.data() ;
+    }
+
+    bool Decompressor::active() const
+    {
+      return data().encoding != Encoding::Identity ;
+    }
+
+    bool Decompressor::done() const
+    {
+      return data().done ;
+    }
+
+    bool Decompressor::valid() const
+    {
+      return data().valid ;
+    }
+
+    void Decompressor::reset()
+    {
+      data().release() ;
+      data().encoding = Encoding::Identity ;
+      data().done     = false              ;
+      data().valid    = true               ;
+    }
+
+    DecompressorData& Decompressor::data()
+    {
+      return *this->decompressor_data ;
+    }
+
+    const DecompressorData& Decompressor::data() const
+    {
+      return *this->decompressor_data ;
+    }
+  }
+}
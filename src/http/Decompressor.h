@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Decompressor.h
+ * Author: Jordan Hendl
+ *
+ * Created on January 25, 2021, 7:40 PM
+ */
+
+#ifndef YGGDRASIL_DECOMPRESSOR_H
+#define YGGDRASIL_DECOMPRESSOR_H
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to incrementally decompress a 'Content-Encoding: gzip' or 'Content-Encoding: deflate' HTTP body.
+     * Output is written into a buffer owned by this object, which is reused between calls & between bodies.
+     */
+    class Decompressor
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Decompressor() ;
+
+        /** Default deconstructor.
+         */
+        ~Decompressor() ;
+
+        /** Static method to retrieve the value to send as the 'Accept-Encoding' header when requesting compression.
+         * @return The C-string list of encodings this object can decode.
+         */
+        static const char* acceptEncoding() ;
+
+        /** Method to prepare this object to decode a new body.
+         * @param content_encoding The value of the body's 'Content-Encoding' header. May be empty.
+         * @return Whether or not the body needs to be decompressed.
+         */
+        bool initialize( const char* content_encoding ) ;
+
+        /** Method to decompress the next block of a body.
+         * @param input The compressed data.
+         * @param size The amount of bytes of compressed data.
+         * @return The amount of decompressed bytes available at Decompressor::output().
+         */
+        unsigned decompress( const char* input, unsigned size ) ;
+
+        /** Method to retrieve the output of the last decompression.
+         * @note This is only valid until the next call to Decompressor::decompress().
+         * @return The pointer to the start of the decompressed data.
+         */
+        const unsigned char* output() const ;
+
+        /** Method to retrieve whether or not the body being decoded needs decompression.
+         * @return Whether or not this object is decoding a compressed body.
+         */
+        bool active() const ;
+
+        /** Method to retrieve whether or not the end of the compressed stream has been seen.
+         * @return Whether or not the whole compressed stream has been decoded.
+         */
+        bool done() const ;
+
+        /** Method to retrieve whether or not the compressed stream has been valid so far.
+         * @return Whether or not this object has seen a valid compressed stream.
+         */
+        bool valid() const ;
+
+        /** Method to reset this object and release the current stream.
+         * @note The output buffer is kept, so that it can be reused by the next body.
+         */
+        void reset() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct DecompressorData *decompressor_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        DecompressorData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const DecompressorData& data() const ;
+    };
+  }
+}
+
+#endif /* DECOMPRESSOR_H */
+
@@ -0,0 +1,610 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DiskCache.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 8, 2021, 6:05 PM
+ */
+
+#include "DiskCache.h"
+#include "Cache.h"
+#include "Parser.h"
+#include <ygg/Yggdrasil.h>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <list>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <openssl/sha.h>
+
+namespace ygg
+{
+  namespace http
+  {
+    namespace fs = std::filesystem ;
+
+    /** The name of the index file in the cache directory.
+     */
+    static const char INDEX_NAME[] = "index" ;
+
+    /** The amount of index records allowed beyond twice the entries before the index is compacted.
+     */
+    static const unsigned COMPACT_SLACK = 256 ;
+
+    /** Function to retrieve the current time.
+     * @return The seconds since the epoch.
+     */
+    static long long now() ;
+
+    /** Function to name a body after it's content.
+     * @param body The body bytes.
+     * @param size The amount of bytes in the body.
+     * @return The file name of the body.
+     */
+    static std::string contentName( const unsigned char* body, std::size_t size ) ;
+
+    /** Function to write a whole buffer to a file descriptor.
+     * @param fd The file descriptor to write to.
+     * @param data The bytes to write.
+     * @param size The amount of bytes to write.
+     * @return Whether or not every byte was written.
+     */
+    static bool writeAll( int fd, const void* data, std::size_t size ) ;
+
+    /** Structure to contain a single cached response.
+     */
+    struct DiskEntry
+    {
+      std::string url      ; ///< The URL the response was stored under.
+      std::string name     ; ///< The file name of the body.
+      std::string etag     ; ///< The ETag of the response.
+      std::string modified ; ///< The Last-Modified date of the response.
+      std::size_t size     ; ///< The amount of bytes in the body.
+      long long   expires  ; ///< When the response becomes stale, in seconds since the epoch.
+    };
+
+    /** Structure to contain a disk cache's data.
+     */
+    struct DiskCacheData
+    {
+      using Entries = std::list<DiskEntry>                                ;
+      using Index   = std::unordered_map<std::string, Entries::iterator>  ;
+      using Refs    = std::unordered_map<std::string, unsigned>           ;
+
+      Entries           entries   ; ///< Every entry, most recently used first.
+      Index             index     ; ///< The entries by URL.
+      Refs              refs      ; ///< How many entries share each body file.
+      fs::path          directory ; ///< The cache directory.
+      std::string       lookup    ; ///< The reused key buffer for lookups.
+      std::string       line      ; ///< The reused buffer index records are written into.
+      Entries::iterator current   ; ///< The current entry, or the end of the entries if there is none.
+      void*             map       ; ///< The mapping of the current entry's body.
+      std::size_t       map_size  ; ///< The size of the mapping.
+      std::size_t       budget    ; ///< The maximum amount of bytes all bodies may use.
+      std::size_t       used      ; ///< The amount of bytes all bodies use.
+      unsigned          records   ; ///< The amount of records in the index file.
+      int               index_fd  ; ///< The index file, opened for appending.
+
+      /** Default constructor.
+       */
+      DiskCacheData() ;
+
+      /** Method to unmap the current entry's body.
+       */
+      void unmap() ;
+
+      /** Method to add an entry as the most recently used.
+       * @param entry The entry to add.
+       */
+      void insert( DiskEntry&& entry ) ;
+
+      /** Method to remove an entry, deleting it's body file once no entry uses it.
+       * @param entry The entry to remove.
+       * @param files Whether or not to delete body files.
+       */
+      void remove( Entries::iterator entry, bool files ) ;
+
+      /** Method to append a record to the index.
+       * @param type The type of the record, 'P' to put an entry, 'U' for a use & 'D' to delete.
+       * @param entry The entry of the record.
+       */
+      void append( char type, const DiskEntry& entry ) ;
+
+      /** Method to read the index, rebuilding the entries of the last run.
+       * @return The length of the index up to the end of it's last complete record.
+       */
+      std::size_t replay() ;
+
+      /** Method to rewrite the index with only the live entries.
+       */
+      void compact() ;
+
+      /** Method to remove the least recently used entries until the cache fits it's budget.
+       */
+      void evict() ;
+    };
+
+    long long now()
+    {
+      return std::chrono::duration_cast<std::chrono::seconds>( std::chrono::system_clock::now().time_since_epoch() ).count() ;
+    }
+
+    std::string contentName( const unsigned char* body, std::size_t size )
+    {
+      static const char digits[] = "0123456789abcdef" ;
+
+      unsigned char digest[ SHA256_DIGEST_LENGTH ] ;
+      std::string   name                          ;
+
+      // Bodies from different URLs share a file by name, so it must not be possible to craft a body colliding with another.
+      SHA256( body, size, digest ) ;
+      for( unsigned char byte : digest )
+      {
+        name += digits[ byte >> 4  ] ;
+        name += digits[ byte & 0xF ] ;
+      }
+
+      return name ;
+    }
+
+    bool writeAll( int fd, const void* data, std::size_t size )
+    {
+      const char* bytes = static_cast<const char*>( data ) ;
+      ssize_t     amount ;
+
+      while( size != 0 )
+      {
+        amount = ::write( fd, bytes, size ) ;
+        if( amount <= 0 ) return false ;
+
+        bytes += amount ;
+        size  -= static_cast<std::size_t>( amount ) ;
+      }
+
+      return true ;
+    }
+
+    DiskCacheData::DiskCacheData()
+    {
+      this->current  = this->entries.end() ;
+      this->map      = nullptr             ;
+      this->map_size = 0                   ;
+      this->budget   = 0                   ;
+      this->used     = 0                   ;
+      this->records  = 0                   ;
+      this->index_fd = -1                  ;
+    }
+
+    void DiskCacheData::unmap()
+    {
+      if( this->map != nullptr ) ::munmap( this->map, this->map_size ) ;
+
+      this->map      = nullptr ;
+      this->map_size = 0       ;
+    }
+
+    void DiskCacheData::insert( DiskEntry&& entry )
+    {
+      this->refs[ entry.name ]++ ;
+      this->used += entry.size ;
+      this->entries.push_front( std::move( entry ) ) ;
+      this->index[ this->entries.front().url ] = this->entries.begin() ;
+    }
+
+    void DiskCacheData::remove( Entries::iterator entry, bool files )
+    {
+      if( entry == this->current )
+      {
+        this->unmap() ;
+        this->current = this->entries.end() ;
+      }
+
+      if( --this->refs[ entry->name ] == 0 )
+      {
+        this->refs.erase( entry->name ) ;
+        if( files ) std::remove( ( this->directory / entry->name ).c_str() ) ;
+      }
+
+      this->used -= entry->size ;
+      this->index.erase( entry->url ) ;
+      this->entries.erase( entry ) ;
+    }
+
+    void DiskCacheData::append( char type, const DiskEntry& entry )
+    {
+      if( this->index_fd < 0 ) return ;
+
+      // Every earlier record has been applied to the entries by now, so they can replace the index before this one is added.
+      if( this->records >= this->entries.size() * 2 + COMPACT_SLACK ) this->compact() ;
+
+      this->line.clear() ;
+      this->line += type ;
+      this->line += '\t' ;
+      this->line += entry.url ;
+
+      if( type == 'P' )
+      {
+        this->line += '\t' ; this->line += entry.name                       ;
+        this->line += '\t' ; this->line += std::to_string( entry.size    ) ;
+        this->line += '\t' ; this->line += std::to_string( entry.expires ) ;
+        this->line += '\t' ; this->line += entry.etag                       ;
+        this->line += '\t' ; this->line += entry.modified                   ;
+      }
+
+      // A record is written in one call, so a crash can at worst leave a partial last line, which replay skips & open
+      // cuts off before anything is appended after it.
+      this->line += '\n' ;
+      writeAll( this->index_fd, this->line.data(), this->line.size() ) ;
+      this->records++ ;
+    }
+
+    std::size_t DiskCacheData::replay()
+    {
+      std::ifstream            file( this->directory / INDEX_NAME, std::ios::binary ) ;
+      std::stringstream        contents ;
+      std::string              text     ;
+      std::string              record   ;
+      std::vector<std::string> fields   ;
+      std::size_t              start    ;
+      std::size_t              end      ;
+      std::error_code          error    ;
+
+      contents << file.rdbuf() ;
+      text  = contents.str() ;
+      start = 0 ;
+
+      while( ( end = text.find( '\n', start ) ) != std::string::npos )
+      {
+        record = text.substr( start, end - start ) ;
+        start  = end + 1 ;
+        this->records++ ;
+
+        fields.clear() ;
+        for( std::size_t offset = 0, tab; ; offset = tab + 1 )
+        {
+          tab = record.find( '\t', offset ) ;
+          fields.push_back( record.substr( offset, tab - offset ) ) ;
+          if( tab == std::string::npos ) break ;
+        }
+
+        if( fields.size() < 2 ) continue ;
+
+        const auto iter = this->index.find( fields[ 1 ] ) ;
+
+        if( fields[ 0 ] == "P" && fields.size() == 7 )
+        {
+          if( iter != this->index.end() ) this->remove( iter->second, false ) ;
+
+          DiskEntry entry ;
+          entry.url      = fields[ 1 ] ;
+          entry.name     = fields[ 2 ] ;
+          entry.size     = static_cast<std::size_t>( std::strtoull( fields[ 3 ].c_str(), nullptr, 10 ) ) ;
+          entry.expires  = std::strtoll( fields[ 4 ].c_str(), nullptr, 10 ) ;
+          entry.etag     = fields[ 5 ] ;
+          entry.modified = fields[ 6 ] ;
+          this->insert( std::move( entry ) ) ;
+        }
+        else if( fields[ 0 ] == "U" && iter != this->index.end() )
+        {
+          this->entries.splice( this->entries.begin(), this->entries, iter->second ) ;
+        }
+        else if( fields[ 0 ] == "D" && iter != this->index.end() )
+        {
+          this->remove( iter->second, false ) ;
+        }
+      }
+
+      // Entries whose body went missing are dropped, and files no entry refers to are left over from a crash.
+      for( auto iter = this->entries.begin(); iter != this->entries.end(); )
+      {
+        const auto next = std::next( iter ) ;
+        if( fs::file_size( this->directory / iter->name, error ) != iter->size || error ) this->remove( iter, false ) ;
+        iter = next ;
+      }
+
+      for( const auto& file : fs::directory_iterator( this->directory, error ) )
+      {
+        const std::string name = file.path().filename().string() ;
+        if( name != INDEX_NAME && this->refs.find( name ) == this->refs.end() ) fs::remove( file.path(), error ) ;
+      }
+
+      return start ;
+    }
+
+    void DiskCacheData::compact()
+    {
+      const fs::path path      = this->directory / INDEX_NAME ;
+      const fs::path temporary = this->directory / ( std::string( INDEX_NAME ) + ".tmp" ) ;
+      int            fd        ;
+
+      fd = ::open( temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ;
+      if( fd < 0 ) return ;
+
+      // Oldest first, so that replaying the new index rebuilds the same order.
+      std::swap( fd, this->index_fd ) ;
+      this->records = 0 ;
+      for( auto iter = this->entries.rbegin(); iter != this->entries.rend(); ++iter )
+      {
+        this->line.clear() ;
+        this->line += "P\t" ;
+        this->line += iter->url  ; this->line += '\t' ;
+        this->line += iter->name ; this->line += '\t' ;
+        this->line += std::to_string( iter->size    ) ; this->line += '\t' ;
+        this->line += std::to_string( iter->expires ) ; this->line += '\t' ;
+        this->line += iter->etag ; this->line += '\t' ;
+        this->line += iter->modified ; this->line += '\n' ;
+        writeAll( this->index_fd, this->line.data(), this->line.size() ) ;
+        this->records++ ;
+      }
+
+      ::fsync( this->index_fd ) ;
+      ::close( this->index_fd ) ;
+      if( fd >= 0 ) ::close( fd ) ;
+
+      // The new index replaces the old one in a single step, so a crash leaves one or the other.
+      std::rename( temporary.c_str(), path.c_str() ) ;
+      this->index_fd = ::open( path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644 ) ;
+    }
+
+    void DiskCacheData::evict()
+    {
+      while( this->used > this->budget && !this->entries.empty() )
+      {
+        const auto last = std::prev( this->entries.end() ) ;
+
+        this->append( 'D', *last ) ;
+        this->remove( last, true ) ;
+      }
+    }
+
+    DiskCache::DiskCache()
+    {
+      this->cache_data = new DiskCacheData() ;
+    }
+
+    DiskCache::~DiskCache()
+    {
+      this->close() ;
+      delete this->cache_data ;
+    }
+
+    bool DiskCache::open( const char* directory, std::size_t bytes )
+    {
+      std::error_code error ;
+
+      this->close() ;
+
+      data().directory = directory ;
+      data().budget    = bytes     ;
+
+      fs::create_directories( data().directory, error ) ;
+      if( !fs::is_directory( data().directory, error ) )
+      {
+        ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+        return false ;
+      }
+
+      const std::size_t complete = data().replay() ;
+      data().index_fd = ::open( ( data().directory / INDEX_NAME ).c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644 ) ;
+
+      // A partial last record left by a crash would otherwise be glued to the next one appended.
+      if( data().index_fd < 0 || ::ftruncate( data().index_fd, static_cast<off_t>( complete ) ) != 0 )
+      {
+        ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+        this->close() ;
+        return false ;
+      }
+
+      data().evict() ;
+      if( data().records > data().entries.size() * 2 + COMPACT_SLACK ) data().compact() ;
+
+      return true ;
+    }
+
+    void DiskCache::close()
+    {
+      data().unmap() ;
+      if( data().index_fd >= 0 ) ::close( data().index_fd ) ;
+
+      data().index.clear() ;
+      data().refs.clear() ;
+      data().entries.clear() ;
+      data().current  = data().entries.end() ;
+      data().used     = 0  ;
+      data().records  = 0  ;
+      data().index_fd = -1 ;
+    }
+
+    bool DiskCache::find( std::string_view url )
+    {
+      data().unmap() ;
+      data().current = data().entries.end() ;
+      data().lookup.assign( url.data(), url.size() ) ;
+
+      const auto iter = data().index.find( data().lookup ) ;
+      if( iter == data().index.end() ) return false ;
+
+      data().entries.splice( data().entries.begin(), data().entries, iter->second ) ;
+      data().current = iter->second ;
+      data().append( 'U', *data().current ) ;
+
+      return true ;
+    }
+
+    bool DiskCache::fresh() const
+    {
+      return data().current != data().entries.end() && now() < data().current->expires ;
+    }
+
+    const char* DiskCache::etag() const
+    {
+      return data().current != data().entries.end() ? data().current->etag.c_str() : "" ;
+    }
+
+    const char* DiskCache::lastModified() const
+    {
+      return data().current != data().entries.end() ? data().current->modified.c_str() : "" ;
+    }
+
+    const unsigned char* DiskCache::body()
+    {
+      int   fd      ;
+      void* mapping ;
+
+      if( data().current == data().entries.end() || data().current->size == 0 ) return nullptr ;
+
+      if( data().map == nullptr )
+      {
+        fd = ::open( ( data().directory / data().current->name ).c_str(), O_RDONLY ) ;
+        if( fd < 0 ) return nullptr ;
+
+        mapping = ::mmap( nullptr, data().current->size, PROT_READ, MAP_PRIVATE, fd, 0 ) ;
+        ::close( fd ) ;
+
+        if( mapping == MAP_FAILED ) return nullptr ;
+        data().map      = mapping               ;
+        data().map_size = data().current->size  ;
+      }
+
+      return static_cast<const unsigned char*>( data().map ) ;
+    }
+
+    std::size_t DiskCache::size() const
+    {
+      return data().current != data().entries.end() ? data().current->size : 0 ;
+    }
+
+    bool DiskCache::store( std::string_view url, const Parser& response, const unsigned char* body, std::size_t size )
+    {
+      const long long fresh = Cache::lifetime( response ) ;
+      DiskEntry       entry ;
+      fs::path        path  ;
+      std::string     temporary ;
+      std::error_code error ;
+      int             fd    ;
+
+      if( data().index_fd < 0 ) return false ;
+
+      data().unmap() ;
+      data().current = data().entries.end() ;
+
+      // Without a validator a stale entry could never be reused, so it is only worth keeping while fresh.
+      if( response.status() != 200 || fresh < 0 || size > data().budget ) return false ;
+      if( fresh == 0 && response.value( "ETag" )[ 0 ] == '\0' && response.value( "Last-Modified" )[ 0 ] == '\0' ) return false ;
+
+      entry.url      = std::string( url )                ;
+      entry.name     = contentName( body, size )         ;
+      entry.etag     = response.value( "ETag"          ) ;
+      entry.modified = response.value( "Last-Modified" ) ;
+      entry.size     = size                              ;
+      entry.expires  = now() + fresh                     ;
+
+      // Tabs & newlines would break the index records.
+      for( const std::string* field : { &entry.url, &entry.etag, &entry.modified } )
+      {
+        if( field->find_first_of( "\t\r\n" ) != std::string::npos ) return false ;
+      }
+
+      // Identical bodies share one file. Otherwise it is written & flushed under a temporary name, then renamed into place.
+      path = data().directory / entry.name ;
+      if( data().refs.find( entry.name ) == data().refs.end() )
+      {
+        temporary = path.string() + ".tmp" ;
+        fd        = ::open( temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ;
+        if( fd < 0 ) return false ;
+
+        const bool written = writeAll( fd, body, size ) && ::fsync( fd ) == 0 ;
+        ::close( fd ) ;
+
+        if( !written || std::rename( temporary.c_str(), path.c_str() ) != 0 )
+        {
+          fs::remove( temporary, error ) ;
+          return false ;
+        }
+      }
+
+      data().append( 'P', entry ) ;
+
+      // The body is held while the old entry goes, in case they share it.
+      const auto old = data().index.find( entry.url ) ;
+
+      data().refs[ entry.name ]++ ;
+      if( old != data().index.end() ) data().remove( old->second, true ) ;
+      data().refs[ entry.name ]-- ;
+      data().insert( std::move( entry ) ) ;
+
+      data().evict() ;
+      return true ;
+    }
+
+    void DiskCache::refresh( const Parser& response )
+    {
+      const long long fresh = Cache::lifetime( response ) ;
+
+      if( data().current == data().entries.end() ) return ;
+
+      if( fresh < 0 )
+      {
+        data().append( 'D', *data().current ) ;
+        data().remove( data().current, true ) ;
+        return ;
+      }
+
+      // A 304 may carry a new validator, which replaces the stored one.
+      if( response.value( "ETag"          )[ 0 ] != '\0' ) data().current->etag     = response.value( "ETag"          ) ;
+      if( response.value( "Last-Modified" )[ 0 ] != '\0' ) data().current->modified = response.value( "Last-Modified" ) ;
+      data().current->expires = now() + fresh ;
+      data().append( 'P', *data().current ) ;
+    }
+
+    void DiskCache::erase( std::string_view url )
+    {
+      data().lookup.assign( url.data(), url.size() ) ;
+
+      const auto iter = data().index.find( data().lookup ) ;
+      if( iter == data().index.end() ) return ;
+
+      data().append( 'D', *iter->second ) ;
+      data().remove( iter->second, true ) ;
+    }
+
+    std::size_t DiskCache::used() const
+    {
+      return data().used ;
+    }
+
+    DiskCacheData& DiskCache::data()
+    {
+      return *this->cache_data ;
+    }
+
+    const DiskCacheData& DiskCache::data() const
+    {
+      return *this->cache_data ;
+    }
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   DiskCache.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 8, 2021, 6:05 PM
+ */
+
+#ifndef YGGDRASIL_DISK_CACHE_H
+#define YGGDRASIL_DISK_CACHE_H
+
+#include <string_view>
+#include <cstddef>
+
+namespace ygg
+{
+  namespace http
+  {
+    class Parser ;
+
+    /** Class to keep HTTP response bodies on disk, so they outlive the process.
+     * Bodies are stored in files named after their content, and the URL, validators & freshness of each entry go in an append-only index that is replayed on open.
+     * A body is completely written before the index refers to it, so a crash at any point leaves the cache consistent. Entries are evicted least recently used first once the cache grows past it's byte budget.
+     * Hits are memory-mapped, so they can be decoded without being read into memory first.
+     */
+    class DiskCache
+    {
+      public:
+
+        /** Default constructor.
+         */
+        DiskCache() ;
+
+        /** Default deconstructor.
+         */
+        ~DiskCache() ;
+
+        /** Method to open a cache directory, creating it if needed. Until a directory is opened, the cache stores nothing.
+         * @param directory The C-string path of the directory to keep the cache in.
+         * @param bytes The maximum amount of bytes of all stored bodies.
+         * @return Whether or not the directory could be used.
+         */
+        bool open( const char* directory, std::size_t bytes ) ;
+
+        /** Method to close the cache directory.
+         */
+        void close() ;
+
+        /** Method to look up an entry, making it the current entry & the most recently used.
+         * @param url The URL the entry was stored under.
+         * @return Whether or not an entry exists, fresh or stale.
+         */
+        bool find( std::string_view url ) ;
+
+        /** Method to retrieve whether or not the current entry can be used without asking the server.
+         * @return Whether or not the current entry is fresh.
+         */
+        bool fresh() const ;
+
+        /** Method to retrieve the ETag of the current entry, for If-None-Match.
+         * @return The C-string ETag, or an empty string if the server sent none.
+         */
+        const char* etag() const ;
+
+        /** Method to retrieve the Last-Modified date of the current entry, for If-Modified-Since.
+         * @return The C-string date, or an empty string if the server sent none.
+         */
+        const char* lastModified() const ;
+
+        /** Method to retrieve the memory-mapped body of the current entry.
+         * @note This is only valid until the next call to DiskCache::find() or the cache is changed.
+         * @return The pointer to the start of the body bytes, or nullptr if the body could not be mapped.
+         */
+        const unsigned char* body() ;
+
+        /** Method to retrieve the size of the body of the current entry.
+         * @return The amount of bytes in the body.
+         */
+        std::size_t size() const ;
+
+        /** Method to store a response, replacing any entry of the same URL. Responses that may not be cached are ignored.
+         * @param url The URL to store the response under.
+         * @param response The parsed header of the response.
+         * @param body The decoded body of the response.
+         * @param size The amount of bytes in the body.
+         * @return Whether or not the response was stored.
+         */
+        bool store( std::string_view url, const Parser& response, const unsigned char* body, std::size_t size ) ;
+
+        /** Method to renew the freshness of the current entry after the server answered a revalidation with 304 Not Modified.
+         * @param response The parsed header of the 304 response.
+         */
+        void refresh( const Parser& response ) ;
+
+        /** Method to remove an entry.
+         * @param url The URL the entry was stored under.
+         */
+        void erase( std::string_view url ) ;
+
+        /** Method to retrieve the amount of disk used by all bodies.
+         * @return The amount of bytes used.
+         */
+        std::size_t used() const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct DiskCacheData *cache_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        DiskCacheData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const DiskCacheData& data() const ;
+    };
+  }
+}
+
+#endif /* DISK_CACHE_H */
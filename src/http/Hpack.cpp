@@ -0,0 +1,769 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Hpack.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 2, 2021, 8:15 PM
+ */
+
+#include "Hpack.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <utility>
+#include <cstring>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** A single code of the HPACK Huffman code (RFC 7541, Appendix B).
+     */
+    struct HuffmanCode
+    {
+      unsigned code ;
+      unsigned bits ;
+    };
+
+    /** A single entry of the HPACK static table (RFC 7541, Appendix A).
+     */
+    struct StaticEntry
+    {
+      const char* name  ;
+      const char* value ;
+    };
+
+    /** The amount of bytes every table entry costs on top of it's name & value.
+     */
+    static const unsigned ENTRY_OVERHEAD = 32 ;
+
+    /** The dynamic table size both sides start with.
+     */
+    static const unsigned DEFAULT_TABLE_SIZE = 4096 ;
+
+    /** The symbol of the Huffman code that marks the end of a string.
+     */
+    static const unsigned HUFFMAN_EOS = 256 ;
+
+    /** The HPACK Huffman code, indexed by symbol.
+     */
+    static const HuffmanCode HUFFMAN_CODES[ 257 ] =
+    {
+      { 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+      { 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+      { 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+      { 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+      { 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+      { 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+      { 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+      { 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+      { 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+      { 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+      { 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+      { 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+      { 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+      { 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+      { 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+      { 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+      { 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+      { 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+      { 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+      { 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+      { 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+      { 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+      { 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+      { 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+      { 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+      { 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+      { 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+      { 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+      { 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+      { 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+      { 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+      { 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+      { 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+      { 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+      { 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+      { 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+      { 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+      { 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+      { 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+      { 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+      { 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+      { 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+      { 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+      { 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+      { 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+      { 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+      { 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+      { 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+      { 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+      { 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+      { 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+      { 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+      { 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+      { 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+      { 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+      { 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+      { 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+      { 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+      { 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+      { 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+      { 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+      { 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+      { 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+      { 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+      { 0x3fffffff, 30 }
+    };
+
+    /** The HPACK static table. HPACK indices start at 1, so entry N is at index N - 1.
+     */
+    static const StaticEntry STATIC_TABLE[ 61 ] =
+    {
+      { ":authority"                 , ""                                },
+      { ":method"                    , "GET"                             },
+      { ":method"                    , "POST"                            },
+      { ":path"                      , "/"                               },
+      { ":path"                      , "/index.html"                     },
+      { ":scheme"                    , "http"                            },
+      { ":scheme"                    , "https"                           },
+      { ":status"                    , "200"                             },
+      { ":status"                    , "204"                             },
+      { ":status"                    , "206"                             },
+      { ":status"                    , "304"                             },
+      { ":status"                    , "400"                             },
+      { ":status"                    , "404"                             },
+      { ":status"                    , "500"                             },
+      { "accept-charset"             , ""                                },
+      { "accept-encoding"            , "gzip, deflate"                   },
+      { "accept-language"            , ""                                },
+      { "accept-ranges"              , ""                                },
+      { "accept"                     , ""                                },
+      { "access-control-allow-origin", ""                                },
+      { "age"                        , ""                                },
+      { "allow"                      , ""                                },
+      { "authorization"              , ""                                },
+      { "cache-control"              , ""                                },
+      { "content-disposition"        , ""                                },
+      { "content-encoding"           , ""                                },
+      { "content-language"           , ""                                },
+      { "content-length"             , ""                                },
+      { "content-location"           , ""                                },
+      { "content-range"              , ""                                },
+      { "content-type"               , ""                                },
+      { "cookie"                     , ""                                },
+      { "date"                       , ""                                },
+      { "etag"                       , ""                                },
+      { "expect"                     , ""                                },
+      { "expires"                    , ""                                },
+      { "from"                       , ""                                },
+      { "host"                       , ""                                },
+      { "if-match"                   , ""                                },
+      { "if-modified-since"          , ""                                },
+      { "if-none-match"              , ""                                },
+      { "if-range"                   , ""                                },
+      { "if-unmodified-since"        , ""                                },
+      { "last-modified"              , ""                                },
+      { "link"                       , ""                                },
+      { "location"                   , ""                                },
+      { "max-forwards"               , ""                                },
+      { "proxy-authenticate"         , ""                                },
+      { "proxy-authorization"        , ""                                },
+      { "range"                      , ""                                },
+      { "referer"                    , ""                                },
+      { "refresh"                    , ""                                },
+      { "retry-after"                , ""                                },
+      { "server"                     , ""                                },
+      { "set-cookie"                 , ""                                },
+      { "strict-transport-security"  , ""                                },
+      { "transfer-encoding"          , ""                                },
+      { "user-agent"                 , ""                                },
+      { "vary"                       , ""                                },
+      { "via"                        , ""                                },
+      { "www-authenticate"           , ""                                }
+    };
+
+    /** Structure to contain the Huffman code as a binary tree, for decoding.
+     */
+    struct HuffmanTree
+    {
+      using Children = std::vector<int> ;
+
+      Children zero   ; ///< The node reached on a zero bit from each node.
+      Children one    ; ///< The node reached on a one bit from each node.
+      Children symbol ; ///< The symbol of each node, or -1 for inner nodes.
+
+      /** Default constructor. Builds the tree from the code table.
+       */
+      HuffmanTree() ;
+    };
+
+    /** Structure to contain an HPACK dynamic table.
+     */
+    struct DynamicTable
+    {
+      using Entry   = std::pair<std::string, std::string> ;
+      using Entries = std::deque<Entry>                   ;
+
+      Entries  entries ; ///< The entries of the table, newest first.
+      unsigned size    ; ///< The current size of the table, as defined by HPACK.
+      unsigned max     ; ///< The maximum size of the table.
+
+      /** Default constructor.
+       */
+      DynamicTable() ;
+
+      /** Method to add an entry to the table, evicting the oldest entries to make room.
+       * @param name The name of the entry.
+       * @param value The value of the entry.
+       */
+      void add( const std::string& name, const std::string& value ) ;
+
+      /** Method to change the maximum size of the table, evicting entries that no longer fit.
+       * @param max The new maximum size.
+       */
+      void resize( unsigned max ) ;
+
+      /** Method to find the HPACK index of a header.
+       * @param name The name to look for.
+       * @param value The value to look for.
+       * @param name_index Output for the index of the first entry with a matching name, or 0.
+       * @return The index of an entry matching both name & value, or 0.
+       */
+      unsigned find( const std::string& name, const std::string& value, unsigned& name_index ) const ;
+
+      /** Method to look up an entry by it's HPACK index, in either the static or dynamic table.
+       * @param index The HPACK index of the entry.
+       * @param entry Output for the found entry.
+       * @return Whether or not the index was valid.
+       */
+      bool lookup( unsigned index, Entry& entry ) const ;
+    };
+
+    /** Function to retrieve the Huffman decoding tree.
+     * @return Reference to the tree, built on first use.
+     */
+    static const HuffmanTree& huffmanTree() ;
+
+    /** Function to write an HPACK integer.
+     * @param out The buffer to append to.
+     * @param prefix The amount of bits available in the first byte.
+     * @param flags The bits above the prefix in the first byte.
+     * @param value The integer to write.
+     */
+    static void encodeInteger( std::vector<unsigned char>& out, unsigned prefix, unsigned char flags, unsigned value ) ;
+
+    /** Function to write an HPACK string literal, Huffman coded when it is shorter.
+     * @param out The buffer to append to.
+     * @param str The string to write.
+     */
+    static void encodeString( std::vector<unsigned char>& out, const std::string& str ) ;
+
+    /** Function to read an HPACK integer.
+     * @param cur The read position, advanced past the integer.
+     * @param end The end of the block.
+     * @param prefix The amount of bits available in the first byte.
+     * @param value Output for the integer.
+     * @return Whether or not a valid integer was read.
+     */
+    static bool decodeInteger( const unsigned char*& cur, const unsigned char* end, unsigned prefix, unsigned& value ) ;
+
+    /** Function to read an HPACK string literal.
+     * @param cur The read position, advanced past the string.
+     * @param end The end of the block.
+     * @param out Output for the string.
+     * @return Whether or not a valid string was read.
+     */
+    static bool decodeString( const unsigned char*& cur, const unsigned char* end, std::string& out ) ;
+
+    /** Structure to contain an HPACK encoder's data.
+     */
+    struct HpackEncoderData
+    {
+      using Block = std::vector<unsigned char> ;
+
+      DynamicTable table   ; ///< The encoder's view of the dynamic table.
+      Block        block   ; ///< The header block being encoded.
+      unsigned     pending ; ///< A table size change to signal in the next block, or the table size if there is none.
+      bool         resized ; ///< Whether or not a table size change must be signalled.
+
+      /** Default constructor.
+       */
+      HpackEncoderData() ;
+    };
+
+    /** Structure to contain an HPACK decoder's data.
+     */
+    struct HpackDecoderData
+    {
+      using Header  = std::pair<std::string, std::string> ;
+      using Headers = std::vector<Header>                 ;
+
+      DynamicTable table   ; ///< The decoder's view of the dynamic table.
+      Headers      headers ; ///< The headers of the last decoded block.
+      unsigned     limit   ; ///< The largest table size the peer may switch to.
+
+      /** Default constructor.
+       */
+      HpackDecoderData() ;
+    };
+
+    HuffmanTree::HuffmanTree()
+    {
+      unsigned node ;
+      unsigned bit  ;
+
+      this->zero  .push_back( -1 ) ;
+      this->one   .push_back( -1 ) ;
+      this->symbol.push_back( -1 ) ;
+
+      for( unsigned sym = 0; sym < 257; sym++ )
+      {
+        node = 0 ;
+        for( unsigned index = HUFFMAN_CODES[ sym ].bits; index > 0; index-- )
+        {
+          bit = ( HUFFMAN_CODES[ sym ].code >> ( index - 1 ) ) & 1 ;
+          Children& next = bit ? this->one : this->zero ;
+
+          if( next[ node ] < 0 )
+          {
+            next[ node ] = static_cast<int>( this->symbol.size() ) ;
+            this->zero  .push_back( -1 ) ;
+            this->one   .push_back( -1 ) ;
+            this->symbol.push_back( -1 ) ;
+          }
+
+          node = static_cast<unsigned>( ( bit ? this->one : this->zero )[ node ] ) ;
+        }
+
+        this->symbol[ node ] = static_cast<int>( sym ) ;
+      }
+    }
+
+    DynamicTable::DynamicTable()
+    {
+      this->size = 0                  ;
+      this->max  = DEFAULT_TABLE_SIZE ;
+    }
+
+    void DynamicTable::add( const std::string& name, const std::string& value )
+    {
+      const unsigned cost = static_cast<unsigned>( name.size() + value.size() ) + ENTRY_OVERHEAD ;
+
+      // An entry larger than the whole table empties it & is not added.
+      while( !this->entries.empty() && this->size + cost > this->max )
+      {
+        this->size -= static_cast<unsigned>( this->entries.back().first.size() + this->entries.back().second.size() ) + ENTRY_OVERHEAD ;
+        this->entries.pop_back() ;
+      }
+
+      if( cost <= this->max )
+      {
+        this->entries.emplace_front( name, value ) ;
+        this->size += cost ;
+      }
+    }
+
+    void DynamicTable::resize( unsigned max )
+    {
+      this->max = max ;
+      while( !this->entries.empty() && this->size > this->max )
+      {
+        this->size -= static_cast<unsigned>( this->entries.back().first.size() + this->entries.back().second.size() ) + ENTRY_OVERHEAD ;
+        this->entries.pop_back() ;
+      }
+    }
+
+    unsigned DynamicTable::find( const std::string& name, const std::string& value, unsigned& name_index ) const
+    {
+      name_index = 0 ;
+      for( unsigned index = 0; index < 61; index++ )
+      {
+        if( name != STATIC_TABLE[ index ].name ) continue ;
+        if( value == STATIC_TABLE[ index ].value ) return index + 1 ;
+        if( name_index == 0 ) name_index = index + 1 ;
+      }
+
+      for( unsigned index = 0; index < this->entries.size(); index++ )
+      {
+        if( name != this->entries[ index ].first ) continue ;
+        if( value == this->entries[ index ].second ) return index + 62 ;
+        if( name_index == 0 ) name_index = index + 62 ;
+      }
+
+      return 0 ;
+    }
+
+    bool DynamicTable::lookup( unsigned index, Entry& entry ) const
+    {
+      if( index == 0 ) return false ;
+
+      if( index <= 61 )
+      {
+        entry.first  = STATIC_TABLE[ index - 1 ].name  ;
+        entry.second = STATIC_TABLE[ index - 1 ].value ;
+        return true ;
+      }
+
+      if( index - 62 >= this->entries.size() ) return false ;
+
+      entry = this->entries[ index - 62 ] ;
+      return true ;
+    }
+
+    const HuffmanTree& huffmanTree()
+    {
+      static const HuffmanTree tree ;
+
+      return tree ;
+    }
+
+    void encodeInteger( std::vector<unsigned char>& out, unsigned prefix, unsigned char flags, unsigned value )
+    {
+      const unsigned max = ( 1u << prefix ) - 1 ;
+
+      if( value < max )
+      {
+        out.push_back( static_cast<unsigned char>( flags | value ) ) ;
+        return ;
+      }
+
+      out.push_back( static_cast<unsigned char>( flags | max ) ) ;
+      value -= max ;
+      while( value >= 128 )
+      {
+        out.push_back( static_cast<unsigned char>( ( value & 0x7F ) | 0x80 ) ) ;
+        value >>= 7 ;
+      }
+      out.push_back( static_cast<unsigned char>( value ) ) ;
+    }
+
+    void encodeString( std::vector<unsigned char>& out, const std::string& str )
+    {
+      unsigned long long bits    ;
+      unsigned long long buffer  ;
+      unsigned           pending ;
+
+      bits = 0 ;
+      for( unsigned char token : str ) bits += HUFFMAN_CODES[ token ].bits ;
+
+      if( ( bits + 7 ) / 8 >= str.size() )
+      {
+        encodeInteger( out, 7, 0x00, static_cast<unsigned>( str.size() ) ) ;
+        out.insert( out.end(), str.begin(), str.end() ) ;
+        return ;
+      }
+
+      encodeInteger( out, 7, 0x80, static_cast<unsigned>( ( bits + 7 ) / 8 ) ) ;
+
+      buffer  = 0 ;
+      pending = 0 ;
+      for( unsigned char token : str )
+      {
+        buffer   = ( buffer << HUFFMAN_CODES[ token ].bits ) | HUFFMAN_CODES[ token ].code ;
+        pending += HUFFMAN_CODES[ token ].bits ;
+        while( pending >= 8 )
+        {
+          pending -= 8 ;
+          out.push_back( static_cast<unsigned char>( buffer >> pending ) ) ;
+        }
+      }
+
+      // The last byte is padded with the most significant bits of EOS, which are all ones.
+      if( pending > 0 )
+      {
+        out.push_back( static_cast<unsigned char>( ( buffer << ( 8 - pending ) ) | ( 0xFF >> pending ) ) ) ;
+      }
+    }
+
+    bool decodeInteger( const unsigned char*& cur, const unsigned char* end, unsigned prefix, unsigned& value )
+    {
+      const unsigned max = ( 1u << prefix ) - 1 ;
+      unsigned       shift ;
+
+      if( cur >= end ) return false ;
+
+      value = *cur++ & max ;
+      if( value < max ) return true ;
+
+      shift = 0 ;
+      while( cur < end )
+      {
+        // Anything past 28 bits of continuation cannot be a sane length or index.
+        if( shift > 21 ) return false ;
+
+        value += static_cast<unsigned>( *cur & 0x7F ) << shift ;
+        shift += 7 ;
+        if( ( *cur++ & 0x80 ) == 0 ) return true ;
+      }
+
+      return false ;
+    }
+
+    bool decodeString( const unsigned char*& cur, const unsigned char* end, std::string& out )
+    {
+      const HuffmanTree& tree = huffmanTree() ;
+      bool               huffman ;
+      unsigned           length  ;
+      unsigned           node    ;
+      unsigned           depth   ;
+      bool               ones    ;
+      int                next    ;
+
+      if( cur >= end ) return false ;
+
+      huffman = ( *cur & 0x80 ) != 0 ;
+      if( !decodeInteger( cur, end, 7, length ) || length > static_cast<unsigned>( end - cur ) ) return false ;
+
+      out.clear() ;
+      if( !huffman )
+      {
+        out.assign( reinterpret_cast<const char*>( cur ), length ) ;
+        cur += length ;
+        return true ;
+      }
+
+      node  = 0    ;
+      depth = 0    ;
+      ones  = true ;
+      for( const unsigned char* byte = cur; byte < cur + length; byte++ )
+      {
+        for( int bit = 7; bit >= 0; bit-- )
+        {
+          const bool set = ( ( *byte >> bit ) & 1 ) != 0 ;
+
+          next = set ? tree.one[ node ] : tree.zero[ node ] ;
+          if( next < 0 ) return false ;
+
+          node   = static_cast<unsigned>( next ) ;
+          ones   = ones && set ;
+          depth++ ;
+
+          if( tree.symbol[ node ] >= 0 )
+          {
+            if( tree.symbol[ node ] == static_cast<int>( HUFFMAN_EOS ) ) return false ;
+
+            out.push_back( static_cast<char>( tree.symbol[ node ] ) ) ;
+            node  = 0    ;
+            depth = 0    ;
+            ones  = true ;
+          }
+        }
+      }
+
+      cur += length ;
+
+      // Padding must be shorter than a byte & be a prefix of EOS.
+      return depth < 8 && ones ;
+    }
+
+    HpackEncoderData::HpackEncoderData()
+    {
+      this->pending = DEFAULT_TABLE_SIZE ;
+      this->resized = false              ;
+    }
+
+    HpackDecoderData::HpackDecoderData()
+    {
+      this->limit = DEFAULT_TABLE_SIZE ;
+    }
+
+    HpackEncoder::HpackEncoder()
+    {
+      this->encoder_data = new HpackEncoderData() ;
+    }
+
+    HpackEncoder::~HpackEncoder()
+    {
+      delete this->encoder_data ;
+    }
+
+    void HpackEncoder::setMaxSize( unsigned size )
+    {
+      data().pending = size ;
+      data().resized = true ;
+    }
+
+    void HpackEncoder::begin()
+    {
+      data().block.clear() ;
+
+      if( data().resized )
+      {
+        data().table.resize( data().pending ) ;
+        encodeInteger( data().block, 5, 0x20, data().pending ) ;
+        data().resized = false ;
+      }
+    }
+
+    void HpackEncoder::add( const char* name, const char* value, bool sensitive )
+    {
+      const std::string key   = name  ;
+      const std::string entry = value ;
+      unsigned          name_index ;
+      unsigned          index      ;
+
+      index = data().table.find( key, entry, name_index ) ;
+
+      if( index != 0 && !sensitive )
+      {
+        encodeInteger( data().block, 7, 0x80, index ) ;
+        return ;
+      }
+
+      if( sensitive )
+      {
+        encodeInteger( data().block, 4, 0x10, name_index ) ;
+      }
+      else if( key == ":path" || entry.size() * 4 > data().table.max )
+      {
+        // Paths change with every request, so indexing them would only churn the table.
+        encodeInteger( data().block, 4, 0x00, name_index ) ;
+      }
+      else
+      {
+        encodeInteger( data().block, 6, 0x40, name_index ) ;
+        data().table.add( key, entry ) ;
+      }
+
+      if( name_index == 0 ) encodeString( data().block, key ) ;
+      encodeString( data().block, entry ) ;
+    }
+
+    const unsigned char* HpackEncoder::block() const
+    {
+      return data().block.data() ;
+    }
+
+    unsigned HpackEncoder::size() const
+    {
+      return static_cast<unsigned>( data().block.size() ) ;
+    }
+
+    HpackEncoderData& HpackEncoder::data()
+    {
+      return *this->encoder_data ;
+    }
+
+    const HpackEncoderData& HpackEncoder::data() const
+    {
+      return *this->encoder_data ;
+    }
+
+    HpackDecoder::HpackDecoder()
+    {
+      this->decoder_data = new HpackDecoderData() ;
+    }
+
+    HpackDecoder::~HpackDecoder()
+    {
+      delete this->decoder_data ;
+    }
+
+    void HpackDecoder::setMaxSize( unsigned size )
+    {
+      data().limit = size ;
+      if( data().table.max > size ) data().table.resize( size ) ;
+    }
+
+    bool HpackDecoder::decode( const unsigned char* block, unsigned size )
+    {
+      const unsigned char* cur = block        ;
+      const unsigned char* end = block + size ;
+      DynamicTable::Entry  entry ;
+      unsigned             index ;
+      bool                 indexing ;
+
+      data().headers.clear() ;
+      while( cur < end )
+      {
+        if( *cur & 0x80 )
+        {
+          // Indexed header field.
+          if( !decodeInteger( cur, end, 7, index ) || !data().table.lookup( index, entry ) ) return false ;
+          data().headers.push_back( entry ) ;
+          continue ;
+        }
+
+        if( ( *cur & 0xE0 ) == 0x20 )
+        {
+          // Dynamic table size update. Only allowed at the start of a block, before any header field.
+          if( !data().headers.empty() || !decodeInteger( cur, end, 5, index ) || index > data().limit ) return false ;
+          data().table.resize( index ) ;
+          continue ;
+        }
+
+        // Literal header field, with incremental indexing, without indexing or never indexed.
+        indexing = ( *cur & 0xC0 ) == 0x40 ;
+        if( !decodeInteger( cur, end, indexing ? 6 : 4, index ) ) return false ;
+
+        if( index != 0 )
+        {
+          if( !data().table.lookup( index, entry ) ) return false ;
+        }
+        else if( !decodeString( cur, end, entry.first ) )
+        {
+          return false ;
+        }
+
+        if( !decodeString( cur, end, entry.second ) ) return false ;
+
+        if( indexing ) data().table.add( entry.first, entry.second ) ;
+        data().headers.push_back( entry ) ;
+      }
+
+      return true ;
+    }
+
+    unsigned HpackDecoder::count() const
+    {
+      return static_cast<unsigned>( data().headers.size() ) ;
+    }
+
+    const char* HpackDecoder::name( unsigned index ) const
+    {
+      return index < data().headers.size() ? data().headers[ index ].first.c_str() : "" ;
+    }
+
+    const char* HpackDecoder::value( unsigned index ) const
+    {
+      return index < data().headers.size() ? data().headers[ index ].second.c_str() : "" ;
+    }
+
+    const char* HpackDecoder::value( const char* name ) const
+    {
+      for( const auto& header : data().headers )
+      {
+        if( header.first == name ) return header.second.c_str() ;
+      }
+
+      return "" ;
+    }
+
+    HpackDecoderData& HpackDecoder::data()
+    {
+      return *this->decoder_data ;
+    }
+
+    const HpackDecoderData& HpackDecoder::data() const
+    {
+      return *this->decoder_data ;
+    }
+  }
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Hpack.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 2, 2021, 8:15 PM
+ */
+
+#ifndef YGGDRASIL_HPACK_H
+#define YGGDRASIL_HPACK_H
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to compress header lists into HPACK (RFC 7541) header blocks.
+     * Headers are indexed into a dynamic table, so headers repeated between blocks shrink to a single byte.
+     */
+    class HpackEncoder
+    {
+      public:
+
+        /** Default constructor.
+         */
+        HpackEncoder() ;
+
+        /** Default deconstructor.
+         */
+        ~HpackEncoder() ;
+
+        /** Method to set the size of the dynamic table, as allowed by the peer's SETTINGS_HEADER_TABLE_SIZE.
+         * @note The change is signalled at the start of the next header block.
+         * @param size The maximum size in bytes of the dynamic table.
+         */
+        void setMaxSize( unsigned size ) ;
+
+        /** Method to start a new header block, discarding the last one.
+         */
+        void begin() ;
+
+        /** Method to add a header to the current header block.
+         * @param name The C-string lower-case name of the header.
+         * @param value The C-string value of the header.
+         * @param sensitive Whether or not the header must never be indexed, e.g. for cookies or credentials.
+         */
+        void add( const char* name, const char* value, bool sensitive = false ) ;
+
+        /** Method to retrieve the encoded header block.
+         * @return The pointer to the start of the encoded block.
+         */
+        const unsigned char* block() const ;
+
+        /** Method to retrieve the size of the encoded header block.
+         * @return The amount of bytes in the encoded block.
+         */
+        unsigned size() const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct HpackEncoderData *encoder_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        HpackEncoderData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const HpackEncoderData& data() const ;
+    };
+
+    /** Class to decompress HPACK (RFC 7541) header blocks into header lists.
+     */
+    class HpackDecoder
+    {
+      public:
+
+        /** Default constructor.
+         */
+        HpackDecoder() ;
+
+        /** Default deconstructor.
+         */
+        ~HpackDecoder() ;
+
+        /** Method to set the largest dynamic table size the peer is allowed to use, as advertised in our SETTINGS_HEADER_TABLE_SIZE.
+         * @param size The maximum size in bytes of the dynamic table.
+         */
+        void setMaxSize( unsigned size ) ;
+
+        /** Method to decode a whole header block, replacing the last decoded header list.
+         * @param block The header block to decode.
+         * @param size The amount of bytes in the header block.
+         * @return Whether or not the block was valid. An invalid block is a connection error, as the dynamic table can no longer be trusted.
+         */
+        bool decode( const unsigned char* block, unsigned size ) ;
+
+        /** Method to retrieve the amount of headers in the last decoded block.
+         * @return The amount of decoded headers.
+         */
+        unsigned count() const ;
+
+        /** Method to retrieve the name of a decoded header.
+         * @param index The index of the header in the block.
+         * @return The C-string name of the header.
+         */
+        const char* name( unsigned index ) const ;
+
+        /** Method to retrieve the value of a decoded header.
+         * @param index The index of the header in the block.
+         * @return The C-string value of the header.
+         */
+        const char* value( unsigned index ) const ;
+
+        /** Method to retrieve the value of a decoded header by name.
+         * @param name The name of the header to find.
+         * @return The C-string value of the first header with that name, or an empty string if there is none.
+         */
+        const char* value( const char* name ) const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct HpackDecoderData *decoder_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        HpackDecoderData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const HpackDecoderData& data() const ;
+    };
+  }
+}
+
+#endif /* HPACK_H */
+
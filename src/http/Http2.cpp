@@ -0,0 +1,916 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Http2.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 3, 2021, 10:41 PM
+ */
+
+#include "Http2.h"
+#include "Hpack.h"
+#include <ygg/Yggdrasil.h>
+#include <ygg/Connection.h>
+#ifdef _WIN32
+  #include <win32/Win32.h>
+  using Impl = ygg::win32::Win32 ;
+#elif __linux__
+  #include <linux/Linux.h>
+  using Impl = ygg::lx::Linux ;
+#endif
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The connection preface every HTTP/2 client starts with.
+     */
+    static const char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" ;
+
+    /** The size of every frame header.
+     */
+    static const unsigned FRAME_HEADER_SIZE = 9 ;
+
+    /** The largest frame we accept, which is the protocol default.
+     */
+    static const unsigned LOCAL_MAX_FRAME = 16384 ;
+
+    /** The receive window we give every stream. Large enough that a whole image rarely waits on a WINDOW_UPDATE.
+     */
+    static const unsigned LOCAL_STREAM_WINDOW = 8u << 20 ;
+
+    /** The receive window we give the connection as a whole.
+     */
+    static const unsigned LOCAL_CONNECTION_WINDOW = 32u << 20 ;
+
+    /** The window every stream & the connection start with, before any settings or updates.
+     */
+    static const unsigned DEFAULT_WINDOW = 65535 ;
+
+    /** The largest window allowed by the protocol.
+     */
+    static const long long MAX_WINDOW = 0x7FFFFFFF ;
+
+    /** The HTTP/2 frame types.
+     */
+    enum FrameType
+    {
+      Data         = 0x0,
+      Headers      = 0x1,
+      Priority     = 0x2,
+      RstStream    = 0x3,
+      Settings     = 0x4,
+      PushPromise  = 0x5,
+      Ping         = 0x6,
+      GoAway       = 0x7,
+      WindowUpdate = 0x8,
+      Continuation = 0x9
+    };
+
+    /** The HTTP/2 frame flags.
+     */
+    enum FrameFlag
+    {
+      EndStream   = 0x1,
+      Ack         = 0x1,
+      EndHeaders  = 0x4,
+      Padded      = 0x8,
+      PriorityFlag = 0x20
+    };
+
+    /** The HTTP/2 settings parameters.
+     */
+    enum SettingsParameter
+    {
+      HeaderTableSize      = 0x1,
+      EnablePush           = 0x2,
+      MaxConcurrentStreams = 0x3,
+      InitialWindowSize    = 0x4,
+      MaxFrameSize         = 0x5,
+      MaxHeaderListSize    = 0x6
+    };
+
+    /** The HTTP/2 error codes used by the client.
+     */
+    enum ErrorCode
+    {
+      NoError            = 0x0,
+      ProtocolError      = 0x1,
+      FlowControlError   = 0x3,
+      FrameSizeError     = 0x6,
+      CompressionError   = 0x9
+    };
+
+    /** Function to read a big-endian integer.
+     * @param data The bytes to read from.
+     * @param bytes The size of the integer in bytes.
+     * @return The integer.
+     */
+    static unsigned readInteger( const unsigned char* data, unsigned bytes ) ;
+
+    /** Function to append a big-endian integer.
+     * @param out The buffer to append to.
+     * @param value The integer to write.
+     * @param bytes The size of the integer in bytes.
+     */
+    static void writeInteger( std::vector<char>& out, unsigned value, unsigned bytes ) ;
+
+    /** Structure to contain a single stream of a session.
+     */
+    struct Stream
+    {
+      using Header  = std::pair<std::string, std::string> ;
+      using Headers = std::vector<Header>                 ;
+      using Body    = std::vector<unsigned char>          ;
+
+      Headers   request    ; ///< The request headers, until the stream is opened.
+      Headers   headers    ; ///< The response headers.
+      Body      upload     ; ///< The request body.
+      Body      body       ; ///< The response body.
+      long long send_window ; ///< How much more of the request body the server allows.
+      unsigned  consumed   ; ///< How much of the receive window has been used since the last WINDOW_UPDATE.
+      unsigned  sent       ; ///< How much of the request body has been sent.
+      unsigned  status     ; ///< The response status code.
+      unsigned  weight     ; ///< The priority weight of the stream.
+      unsigned  dependency ; ///< The stream this stream depends on.
+      bool      exclusive  ; ///< Whether or not this stream's dependency is exclusive.
+      bool      open       ; ///< Whether or not the stream has been opened.
+      bool      finished   ; ///< Whether or not the stream has finished, successfully or not.
+
+      /** Default constructor.
+       */
+      Stream() ;
+    };
+
+    /** Structure to contain a HTTP/2 session's data.
+     */
+    struct Http2SessionData
+    {
+      using Streams = std::map<unsigned, Stream>   ;
+      using Queue   = std::deque<unsigned>          ;
+      using Bytes   = std::vector<char>             ;
+      using Block   = std::vector<unsigned char>    ;
+
+      HpackEncoder encoder         ; ///< The compressor for request headers.
+      HpackDecoder decoder         ; ///< The decompressor for response headers.
+      Streams      streams         ; ///< Every stream that has not been released.
+      Queue        queued          ; ///< Streams waiting for the server to allow more concurrent streams.
+      Queue        finished        ; ///< Streams that finished but have not been reported yet.
+      Bytes        input           ; ///< Received bytes that do not make up a whole frame yet.
+      Bytes        output          ; ///< Bytes waiting to be sent.
+      Block        block           ; ///< A header block being reassembled from CONTINUATION frames.
+      long long    send_window     ; ///< How much more request body the server allows on the connection.
+      unsigned     consumed        ; ///< How much of the connection receive window has been used since the last WINDOW_UPDATE.
+      unsigned     next_id         ; ///< The id of the next stream to create.
+      unsigned     opened          ; ///< The amount of open streams.
+      unsigned     peer_streams    ; ///< The server's limit of concurrent streams.
+      unsigned     peer_window     ; ///< The server's initial window for new streams.
+      unsigned     peer_frame      ; ///< The largest frame the server accepts.
+      unsigned     block_stream    ; ///< The stream the header block being reassembled belongs to.
+      bool         block_end       ; ///< Whether or not the header block being reassembled ends it's stream.
+      bool         valid           ; ///< Whether or not the connection is usable.
+
+      /** Default constructor.
+       */
+      Http2SessionData() ;
+
+      /** Method to append a frame to the output.
+       * @param type The type of the frame.
+       * @param flags The flags of the frame.
+       * @param stream The stream id of the frame.
+       * @param payload The payload of the frame.
+       * @param size The amount of bytes in the payload.
+       */
+      void frame( unsigned type, unsigned flags, unsigned stream, const void* payload, unsigned size ) ;
+
+      /** Method to end the connection because of a protocol violation.
+       * @param code The HTTP/2 error code to send.
+       */
+      void fail( unsigned code ) ;
+
+      /** Method to mark a stream as finished.
+       * @param id The id of the stream.
+       * @param success Whether or not the stream finished successfully.
+       */
+      void finish( unsigned id, bool success ) ;
+
+      /** Method to open queued streams & send request bodies, as far as the server's limits allow.
+       */
+      void pump() ;
+
+      /** Method to handle a single received frame.
+       * @param type The type of the frame.
+       * @param flags The flags of the frame.
+       * @param id The stream id of the frame.
+       * @param payload The payload of the frame.
+       * @param size The amount of bytes in the payload.
+       */
+      void handle( unsigned type, unsigned flags, unsigned id, const unsigned char* payload, unsigned size ) ;
+
+      /** Method to handle a complete header block.
+       * @param id The stream the block belongs to.
+       * @param end Whether or not the block ends the stream.
+       */
+      void headers( unsigned id, bool end ) ;
+
+      /** Method to give back receive window that has been used up.
+       * @param id The stream that received the data.
+       * @param amount The amount of flow-controlled bytes received.
+       */
+      void replenish( unsigned id, unsigned amount ) ;
+    };
+
+    /** Structure to contain a HTTP/2 client's data.
+     */
+    struct Http2ClientData
+    {
+      ygg::Connection<Impl> connection ; ///< The connection the session runs over.
+      Http2Session          session    ; ///< The HTTP/2 session.
+      std::string           host       ; ///< The host every request is made to.
+      std::string           scheme     ; ///< The scheme every request is made with.
+      unsigned              current    ; ///< The stream that last finished.
+
+      /** Default constructor.
+       */
+      Http2ClientData() ;
+
+      /** Method to send everything the session has queued.
+       */
+      void flush() ;
+    };
+
+    unsigned readInteger( const unsigned char* data, unsigned bytes )
+    {
+      unsigned value = 0 ;
+
+      for( unsigned index = 0; index < bytes; index++ ) value = ( value << 8 ) | data[ index ] ;
+      return value ;
+    }
+
+    void writeInteger( std::vector<char>& out, unsigned value, unsigned bytes )
+    {
+      for( unsigned index = bytes; index > 0; index-- ) out.push_back( static_cast<char>( ( value >> ( ( index - 1 ) * 8 ) ) & 0xFF ) ) ;
+    }
+
+    Stream::Stream()
+    {
+      this->send_window = DEFAULT_WINDOW ;
+      this->consumed    = 0              ;
+      this->sent        = 0              ;
+      this->status      = 0              ;
+      this->weight      = 16             ;
+      this->dependency  = 0              ;
+      this->exclusive   = false          ;
+      this->open        = false          ;
+      this->finished    = false          ;
+    }
+
+    Http2SessionData::Http2SessionData()
+    {
+      this->send_window  = DEFAULT_WINDOW  ;
+      this->consumed     = 0               ;
+      this->next_id      = 1               ;
+      this->opened       = 0               ;
+      this->peer_streams = 100             ;
+      this->peer_window  = DEFAULT_WINDOW  ;
+      this->peer_frame   = LOCAL_MAX_FRAME ;
+      this->block_stream = 0               ;
+      this->block_end    = false           ;
+      this->valid        = false           ;
+    }
+
+    void Http2SessionData::frame( unsigned type, unsigned flags, unsigned stream, const void* payload, unsigned size )
+    {
+      writeInteger( this->output, size                , 3 ) ;
+      writeInteger( this->output, type                , 1 ) ;
+      writeInteger( this->output, flags               , 1 ) ;
+      writeInteger( this->output, stream & 0x7FFFFFFF , 4 ) ;
+
+      if( size != 0 ) this->output.insert( this->output.end(), static_cast<const char*>( payload ), static_cast<const char*>( payload ) + size ) ;
+    }
+
+    void Http2SessionData::fail( unsigned code )
+    {
+      std::vector<char> payload ;
+
+      if( !this->valid ) return ;
+
+      writeInteger( payload, 0   , 4 ) ;
+      writeInteger( payload, code, 4 ) ;
+      this->frame( FrameType::GoAway, 0, 0, payload.data(), static_cast<unsigned>( payload.size() ) ) ;
+      this->valid = false ;
+
+      ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidRead ) ;
+      for( auto& stream : this->streams ) this->finish( stream.first, false ) ;
+    }
+
+    void Http2SessionData::finish( unsigned id, bool success )
+    {
+      auto iter = this->streams.find( id ) ;
+
+      if( iter == this->streams.end() || iter->second.finished ) return ;
+
+      if( !success ) iter->second.status = 0 ;
+      if( iter->second.open ) this->opened-- ;
+
+      iter->second.finished = true ;
+      iter->second.upload.clear() ;
+      this->queued.erase( std::remove( this->queued.begin(), this->queued.end(), id ), this->queued.end() ) ;
+      this->finished.push_back( id ) ;
+    }
+
+    void Http2SessionData::pump()
+    {
+      std::vector<char> payload ;
+      unsigned          offset  ;
+      unsigned          amount  ;
+      unsigned          flags   ;
+      unsigned          id      ;
+
+      if( !this->valid ) return ;
+
+      // Open queued streams, in order so that stream ids always increase on the wire.
+      while( !this->queued.empty() && this->opened < this->peer_streams )
+      {
+        id = this->queued.front() ;
+        this->queued.pop_front() ;
+
+        Stream& stream = this->streams[ id ] ;
+
+        this->encoder.begin() ;
+        for( const auto& header : stream.request ) this->encoder.add( header.first.c_str(), header.second.c_str() ) ;
+        stream.request.clear() ;
+
+        payload.clear() ;
+        flags = stream.upload.empty() ? FrameFlag::EndStream : 0 ;
+        if( stream.weight != 16 || stream.dependency != 0 )
+        {
+          flags |= FrameFlag::PriorityFlag ;
+          writeInteger( payload, stream.dependency | ( stream.exclusive ? 0x80000000u : 0u ), 4 ) ;
+          writeInteger( payload, stream.weight - 1, 1 ) ;
+        }
+
+        // A header block larger than a frame continues in CONTINUATION frames.
+        offset = std::min( this->encoder.size(), this->peer_frame - static_cast<unsigned>( payload.size() ) ) ;
+        payload.insert( payload.end(), this->encoder.block(), this->encoder.block() + offset ) ;
+        if( offset == this->encoder.size() ) flags |= FrameFlag::EndHeaders ;
+        this->frame( FrameType::Headers, flags, id, payload.data(), static_cast<unsigned>( payload.size() ) ) ;
+
+        while( offset < this->encoder.size() )
+        {
+          amount  = std::min( this->encoder.size() - offset, this->peer_frame ) ;
+          this->frame( FrameType::Continuation, offset + amount == this->encoder.size() ? FrameFlag::EndHeaders : 0, id, this->encoder.block() + offset, amount ) ;
+          offset += amount ;
+        }
+
+        stream.open        = true                ;
+        stream.send_window = this->peer_window   ;
+        this->opened++ ;
+      }
+
+      // Send as much of each request body as both windows allow.
+      for( auto& entry : this->streams )
+      {
+        Stream& stream = entry.second ;
+
+        while( stream.open && !stream.finished && stream.sent < stream.upload.size() && stream.send_window > 0 && this->send_window > 0 )
+        {
+          amount = static_cast<unsigned>( std::min<long long>( { static_cast<long long>( stream.upload.size() - stream.sent ), stream.send_window, this->send_window, static_cast<long long>( this->peer_frame ) } ) ) ;
+          flags  = stream.sent + amount == stream.upload.size() ? FrameFlag::EndStream : 0 ;
+
+          this->frame( FrameType::Data, flags, entry.first, stream.upload.data() + stream.sent, amount ) ;
+          stream.sent        += amount ;
+          stream.send_window -= amount ;
+          this->send_window  -= amount ;
+        }
+      }
+    }
+
+    void Http2SessionData::replenish( unsigned id, unsigned amount )
+    {
+      std::vector<char> payload ;
+      Streams::iterator iter    ;
+
+      this->consumed += amount ;
+      if( this->consumed >= LOCAL_CONNECTION_WINDOW / 2 )
+      {
+        writeInteger( payload, this->consumed, 4 ) ;
+        this->frame( FrameType::WindowUpdate, 0, 0, payload.data(), 4 ) ;
+        this->consumed = 0 ;
+      }
+
+      iter = this->streams.find( id ) ;
+      if( iter == this->streams.end() || iter->second.finished ) return ;
+
+      iter->second.consumed += amount ;
+      if( iter->second.consumed >= LOCAL_STREAM_WINDOW / 2 )
+      {
+        payload.clear() ;
+        writeInteger( payload, iter->second.consumed, 4 ) ;
+        this->frame( FrameType::WindowUpdate, 0, id, payload.data(), 4 ) ;
+        iter->second.consumed = 0 ;
+      }
+    }
+
+    void Http2SessionData::headers( unsigned id, bool end )
+    {
+      auto iter = this->streams.find( id ) ;
+
+      // The block has to be decoded even for unknown streams, as it changes the decoder's table.
+      if( !this->decoder.decode( this->block.data(), static_cast<unsigned>( this->block.size() ) ) )
+      {
+        this->fail( ErrorCode::CompressionError ) ;
+        return ;
+      }
+
+      this->block.clear() ;
+      if( iter == this->streams.end() || iter->second.finished ) return ;
+
+      Stream& stream = iter->second ;
+
+      // The first final header block is the response, a later one is trailers which are not kept. Informational responses are skipped.
+      if( stream.status == 0 || stream.status < 200 )
+      {
+        stream.status = static_cast<unsigned>( std::atoi( this->decoder.value( ":status" ) ) ) ;
+        stream.headers.clear() ;
+        for( unsigned index = 0; index < this->decoder.count(); index++ )
+        {
+          if( this->decoder.name( index )[ 0 ] != ':' ) stream.headers.emplace_back( this->decoder.name( index ), this->decoder.value( index ) ) ;
+        }
+      }
+
+      if( end ) this->finish( id, stream.status >= 200 ) ;
+    }
+
+    void Http2SessionData::handle( unsigned type, unsigned flags, unsigned id, const unsigned char* payload, unsigned size )
+    {
+      std::vector<char> reply ;
+      unsigned          padding ;
+      unsigned          skip    ;
+      unsigned          value   ;
+      long long         delta   ;
+
+      // Nothing may come between a HEADERS frame & it's CONTINUATION frames.
+      if( this->block_stream != 0 && ( type != FrameType::Continuation || id != this->block_stream ) )
+      {
+        this->fail( ErrorCode::ProtocolError ) ;
+        return ;
+      }
+
+      switch( type )
+      {
+        case FrameType::Data :
+          padding = ( flags & FrameFlag::Padded ) && size > 0 ? payload[ 0 ] + 1u : 0u ;
+          if( id == 0 || padding > size ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+
+          if( this->streams.count( id ) && !this->streams[ id ].finished )
+          {
+            Stream& stream = this->streams[ id ] ;
+            const unsigned char* start = payload + ( padding ? 1 : 0 ) ;
+
+            stream.body.insert( stream.body.end(), start, start + ( size - padding ) ) ;
+          }
+
+          this->replenish( id, size ) ;
+          if( flags & FrameFlag::EndStream ) this->finish( id, this->streams.count( id ) && this->streams[ id ].status >= 200 ) ;
+          break ;
+
+        case FrameType::Headers :
+          padding = ( flags & FrameFlag::Padded ) && size > 0 ? payload[ 0 ] : 0u ;
+          skip    = ( flags & FrameFlag::Padded ? 1u : 0u ) + ( flags & FrameFlag::PriorityFlag ? 5u : 0u ) ;
+          if( id == 0 || skip + padding > size ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+
+          this->block.assign( payload + skip, payload + size - padding ) ;
+          this->block_end = ( flags & FrameFlag::EndStream ) != 0 ;
+
+          if( flags & FrameFlag::EndHeaders ) this->headers( id, this->block_end ) ;
+          else                                this->block_stream = id ;
+          break ;
+
+        case FrameType::Continuation :
+          if( id == 0 || id != this->block_stream ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+
+          this->block.insert( this->block.end(), payload, payload + size ) ;
+          if( flags & FrameFlag::EndHeaders )
+          {
+            this->block_stream = 0 ;
+            this->headers( id, this->block_end ) ;
+          }
+          break ;
+
+        case FrameType::RstStream :
+          if( id == 0 || size != 4 ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+          this->finish( id, false ) ;
+          break ;
+
+        case FrameType::Settings :
+          if( id != 0 || size % 6 != 0 ) { this->fail( ErrorCode::FrameSizeError ) ; return ; }
+          if( flags & FrameFlag::Ack ) break ;
+
+          for( unsigned offset = 0; offset < size; offset += 6 )
+          {
+            value = readInteger( payload + offset + 2, 4 ) ;
+            switch( readInteger( payload + offset, 2 ) )
+            {
+              case SettingsParameter::HeaderTableSize      : this->encoder.setMaxSize( std::min( value, 4096u ) ) ; break ;
+              case SettingsParameter::MaxConcurrentStreams : this->peer_streams = value ; break ;
+              case SettingsParameter::MaxFrameSize :
+                if( value < LOCAL_MAX_FRAME || value > 0xFFFFFF ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+                this->peer_frame = value ;
+                break ;
+              case SettingsParameter::InitialWindowSize :
+                if( value > MAX_WINDOW ) { this->fail( ErrorCode::FlowControlError ) ; return ; }
+
+                // A new initial window applies to every open stream, by the difference from the old one.
+                delta = static_cast<long long>( value ) - this->peer_window ;
+                for( auto& stream : this->streams ) if( stream.second.open ) stream.second.send_window += delta ;
+                this->peer_window = value ;
+                break ;
+              default : break ;
+            }
+          }
+
+          this->frame( FrameType::Settings, FrameFlag::Ack, 0, nullptr, 0 ) ;
+          break ;
+
+        case FrameType::PushPromise :
+          // Push is disabled in our settings, so a promise is a protocol error.
+          this->fail( ErrorCode::ProtocolError ) ;
+          return ;
+
+        case FrameType::Ping :
+          if( id != 0 || size != 8 ) { this->fail( ErrorCode::FrameSizeError ) ; return ; }
+          if( !( flags & FrameFlag::Ack ) ) this->frame( FrameType::Ping, FrameFlag::Ack, 0, payload, size ) ;
+          break ;
+
+        case FrameType::GoAway :
+          if( id != 0 || size < 8 ) { this->fail( ErrorCode::FrameSizeError ) ; return ; }
+
+          // Streams past the last one the server processed were never handled.
+          value = readInteger( payload, 4 ) & 0x7FFFFFFF ;
+          for( auto& stream : this->streams ) if( stream.first > value ) this->finish( stream.first, false ) ;
+          this->valid = false ;
+          break ;
+
+        case FrameType::WindowUpdate :
+          if( size != 4 ) { this->fail( ErrorCode::FrameSizeError ) ; return ; }
+
+          value = readInteger( payload, 4 ) & 0x7FFFFFFF ;
+          if( value == 0 ) { this->fail( ErrorCode::ProtocolError ) ; return ; }
+
+          if( id == 0 ) this->send_window += value ;
+          else if( this->streams.count( id ) ) this->streams[ id ].send_window += value ;
+          break ;
+
+        default : break ;
+      }
+    }
+
+    Http2ClientData::Http2ClientData()
+    {
+      this->current = 0 ;
+    }
+
+    void Http2ClientData::flush()
+    {
+      if( this->session.outputSize() == 0 ) return ;
+
+      this->connection.send( this->session.output(), this->session.outputSize() ) ;
+      this->session.clearOutput() ;
+    }
+
+    Http2Session::Http2Session()
+    {
+      this->session_data = new Http2SessionData() ;
+    }
+
+    Http2Session::~Http2Session()
+    {
+      delete this->session_data ;
+    }
+
+    void Http2Session::start()
+    {
+      std::vector<char> payload ;
+
+      delete this->session_data ;
+      this->session_data = new Http2SessionData() ;
+      data().valid = true ;
+
+      // Push is turned off, and streams get a window big enough for most images.
+      writeInteger( payload, SettingsParameter::EnablePush       , 2 ) ;
+      writeInteger( payload, 0                                   , 4 ) ;
+      writeInteger( payload, SettingsParameter::InitialWindowSize, 2 ) ;
+      writeInteger( payload, LOCAL_STREAM_WINDOW                 , 4 ) ;
+
+      data().output.insert( data().output.end(), PREFACE, PREFACE + sizeof( PREFACE ) - 1 ) ;
+      data().frame( FrameType::Settings, 0, 0, payload.data(), static_cast<unsigned>( payload.size() ) ) ;
+
+      payload.clear() ;
+      writeInteger( payload, LOCAL_CONNECTION_WINDOW - DEFAULT_WINDOW, 4 ) ;
+      data().frame( FrameType::WindowUpdate, 0, 0, payload.data(), 4 ) ;
+    }
+
+    unsigned Http2Session::request( const char* method, const char* scheme, const char* authority, const char* path, const unsigned char* body, unsigned size )
+    {
+      const unsigned id = data().next_id ;
+
+      Stream& stream = data().streams[ id ] ;
+
+      data().next_id += 2 ;
+      stream.request.emplace_back( ":method"   , method    ) ;
+      stream.request.emplace_back( ":scheme"   , scheme    ) ;
+      stream.request.emplace_back( ":authority", authority ) ;
+      stream.request.emplace_back( ":path"     , path      ) ;
+      if( body != nullptr ) stream.upload.assign( body, body + size ) ;
+
+      data().queued.push_back( id ) ;
+      if( data().valid ) data().pump() ;
+      else               data().finish( id, false ) ;
+
+      return id ;
+    }
+
+    void Http2Session::setPriority( unsigned stream, unsigned weight, unsigned dependency, bool exclusive )
+    {
+      std::vector<char> payload ;
+      auto              iter    = data().streams.find( stream ) ;
+
+      if( iter == data().streams.end() || iter->second.finished || dependency == stream ) return ;
+
+      iter->second.weight     = std::min( std::max( weight, 1u ), 256u ) ;
+      iter->second.dependency = dependency                                ;
+      iter->second.exclusive  = exclusive                                 ;
+
+      // Queued streams carry their priority in their HEADERS frame instead.
+      if( iter->second.open && data().valid )
+      {
+        writeInteger( payload, dependency | ( exclusive ? 0x80000000u : 0u ), 4 ) ;
+        writeInteger( payload, iter->second.weight - 1, 1 ) ;
+        data().frame( FrameType::Priority, 0, stream, payload.data(), 5 ) ;
+      }
+    }
+
+    void Http2Session::feed( const char* bytes, unsigned size )
+    {
+      const unsigned char* input  ;
+      std::size_t          offset ;
+      unsigned             length ;
+
+      if( !data().valid ) return ;
+
+      data().input.insert( data().input.end(), bytes, bytes + size ) ;
+      input  = reinterpret_cast<const unsigned char*>( data().input.data() ) ;
+      offset = 0 ;
+
+      while( data().valid && data().input.size() - offset >= FRAME_HEADER_SIZE )
+      {
+        length = readInteger( input + offset, 3 ) ;
+        if( length > LOCAL_MAX_FRAME )
+        {
+          data().fail( ErrorCode::FrameSizeError ) ;
+          break ;
+        }
+
+        if( data().input.size() - offset < FRAME_HEADER_SIZE + length ) break ;
+
+        data().handle( input[ offset + 3 ], input[ offset + 4 ], readInteger( input + offset + 5, 4 ) & 0x7FFFFFFF, input + offset + FRAME_HEADER_SIZE, length ) ;
+        offset += FRAME_HEADER_SIZE + length ;
+      }
+
+      data().input.erase( data().input.begin(), data().input.begin() + std::min( offset, data().input.size() ) ) ;
+      data().pump() ;
+    }
+
+    void Http2Session::close()
+    {
+      data().valid = false ;
+      for( auto& stream : data().streams ) data().finish( stream.first, false ) ;
+    }
+
+    const char* Http2Session::output() const
+    {
+      return data().output.data() ;
+    }
+
+    unsigned Http2Session::outputSize() const
+    {
+      return static_cast<unsigned>( data().output.size() ) ;
+    }
+
+    void Http2Session::clearOutput()
+    {
+      data().output.clear() ;
+    }
+
+    unsigned Http2Session::next()
+    {
+      unsigned id ;
+
+      if( data().finished.empty() ) return 0 ;
+
+      id = data().finished.front() ;
+      data().finished.pop_front() ;
+      return id ;
+    }
+
+    unsigned Http2Session::active() const
+    {
+      unsigned count = 0 ;
+
+      for( const auto& stream : data().streams ) if( !stream.second.finished ) count++ ;
+      return count ;
+    }
+
+    unsigned Http2Session::status( unsigned stream ) const
+    {
+      const auto iter = data().streams.find( stream ) ;
+
+      return iter != data().streams.end() ? iter->second.status : 0 ;
+    }
+
+    const char* Http2Session::value( unsigned stream, const char* key ) const
+    {
+      const auto iter = data().streams.find( stream ) ;
+
+      if( iter == data().streams.end() ) return "" ;
+      for( const auto& header : iter->second.headers )
+      {
+        if( header.first == key ) return header.second.c_str() ;
+      }
+
+      return "" ;
+    }
+
+    const unsigned char* Http2Session::body( unsigned stream ) const
+    {
+      const auto iter = data().streams.find( stream ) ;
+
+      return iter != data().streams.end() ? iter->second.body.data() : nullptr ;
+    }
+
+    unsigned Http2Session::size( unsigned stream ) const
+    {
+      const auto iter = data().streams.find( stream ) ;
+
+      return iter != data().streams.end() ? static_cast<unsigned>( iter->second.body.size() ) : 0 ;
+    }
+
+    void Http2Session::release( unsigned stream )
+    {
+      const auto iter = data().streams.find( stream ) ;
+
+      if( iter != data().streams.end() && iter->second.finished ) data().streams.erase( iter ) ;
+    }
+
+    bool Http2Session::valid() const
+    {
+      return data().valid ;
+    }
+
+    Http2SessionData& Http2Session::data()
+    {
+      return *this->session_data ;
+    }
+
+    const Http2SessionData& Http2Session::data() const
+    {
+      return *this->session_data ;
+    }
+
+    Http2Client::Http2Client()
+    {
+      this->client_data = new Http2ClientData() ;
+    }
+
+    Http2Client::~Http2Client()
+    {
+      data().connection.reset() ;
+      delete this->client_data ;
+    }
+
+    bool Http2Client::connect( const char* host, unsigned port, bool secure )
+    {
+      data().host    = host                        ;
+      data().scheme  = secure ? "https" : "http"   ;
+      data().current = 0                           ;
+
+      if( ( secure && port != 443 ) || ( !secure && port != 80 ) ) data().host += ":" + std::to_string( port ) ;
+
+      data().connection.setProtocols( "h2" ) ;
+      data().connection.connect( host, ygg::ConnectionType::Client, port, secure ) ;
+
+      if( !data().connection.valid() ) return false ;
+
+      // Over TLS the server has to agree to HTTP/2 through ALPN, otherwise it is assumed with prior knowledge.
+      if( secure && std::string( data().connection.protocol() ) != "h2" )
+      {
+        data().connection.reset() ;
+        return false ;
+      }
+
+      data().session.start() ;
+      data().flush() ;
+      return data().connection.valid() ;
+    }
+
+    unsigned Http2Client::get( const char* path, unsigned weight )
+    {
+      unsigned id ;
+
+      id = data().session.request( "GET", data().scheme.c_str(), data().host.c_str(), path ) ;
+      if( weight != 16 ) data().session.setPriority( id, weight ) ;
+
+      return id ;
+    }
+
+    bool Http2Client::next()
+    {
+      ygg::Packet packet ;
+      unsigned    id     ;
+
+      if( data().current != 0 ) data().session.release( data().current ) ;
+      data().current = 0 ;
+
+      while( ( id = data().session.next() ) == 0 )
+      {
+        if( data().session.active() == 0 ) return false ;
+
+        data().flush() ;
+        packet = data().connection.recieve() ;
+
+        if( packet.size() == 0 ) data().session.close() ;
+        else                     data().session.feed( packet.payload(), packet.size() ) ;
+      }
+
+      // Acknowledgements & window updates caused by the last frames go out right away.
+      data().flush() ;
+      data().current = id ;
+      return true ;
+    }
+
+    unsigned Http2Client::stream() const
+    {
+      return data().current ;
+    }
+
+    unsigned Http2Client::status() const
+    {
+      return data().session.status( data().current ) ;
+    }
+
+    const char* Http2Client::value( const char* key ) const
+    {
+      return data().session.value( data().current, key ) ;
+    }
+
+    const unsigned char* Http2Client::body() const
+    {
+      return data().session.body( data().current ) ;
+    }
+
+    unsigned Http2Client::size() const
+    {
+      return data().session.size( data().current ) ;
+    }
+
+    Http2Session& Http2Client::session()
+    {
+      return data().session ;
+    }
+
+    Http2ClientData& Http2Client::data()
+    {
+      return *this->client_data ;
+    }
+
+    const Http2ClientData& Http2Client::data() const
+    {
+      return *this->client_data ;
+    }
+  }
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Http2.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 3, 2021, 10:41 PM
+ */
+
+#ifndef YGGDRASIL_HTTP2_H
+#define YGGDRASIL_HTTP2_H
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to manage the client side of an HTTP/2 (RFC 7540) connection, without doing any I/O itself.
+     * Received bytes are handed to Http2Session::feed(), and bytes to send are taken from Http2Session::output().
+     * Many requests run at once as separate streams, each with it's own flow-control window & priority.
+     */
+    class Http2Session
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Http2Session() ;
+
+        /** Default deconstructor.
+         */
+        ~Http2Session() ;
+
+        /** Method to start a new connection, queueing the connection preface & our settings to send.
+         * @note This drops every stream of the last connection.
+         */
+        void start() ;
+
+        /** Method to queue a request. It is opened as soon as the server's concurrent stream limit allows.
+         * @param method The C-string request method, e.g. "GET".
+         * @param scheme The C-string scheme of the target, "http" or "https".
+         * @param authority The C-string host (and port, if not the default) of the target.
+         * @param path The C-string path & query of the target.
+         * @param body The request body to send, if any.
+         * @param size The amount of bytes in the request body.
+         * @return The id of the stream the request is made on.
+         */
+        unsigned request( const char* method, const char* scheme, const char* authority, const char* path, const unsigned char* body = nullptr, unsigned size = 0 ) ;
+
+        /** Method to set the priority of a stream. Streams that have not been opened yet carry it in their HEADERS frame.
+         * @param stream The id of the stream to prioritize.
+         * @param weight The weight of the stream among it's siblings, from 1 to 256.
+         * @param dependency The id of the stream this stream depends on, or 0 for none.
+         * @param exclusive Whether or not this stream becomes the only dependency of it's parent.
+         */
+        void setPriority( unsigned stream, unsigned weight, unsigned dependency = 0, bool exclusive = false ) ;
+
+        /** Method to process bytes received from the server.
+         * @param data The received bytes. Frames may be split across calls in any way.
+         * @param size The amount of received bytes.
+         */
+        void feed( const char* data, unsigned size ) ;
+
+        /** Method to fail every unfinished stream because the connection was lost.
+         */
+        void close() ;
+
+        /** Method to retrieve the bytes waiting to be sent to the server.
+         * @return The pointer to the start of the bytes to send.
+         */
+        const char* output() const ;
+
+        /** Method to retrieve the amount of bytes waiting to be sent to the server.
+         * @return The amount of bytes to send.
+         */
+        unsigned outputSize() const ;
+
+        /** Method to mark all of the output as sent.
+         */
+        void clearOutput() ;
+
+        /** Method to retrieve the next finished stream, in the order they finished.
+         * @return The id of a finished stream, or 0 if none have finished since the last call.
+         */
+        unsigned next() ;
+
+        /** Method to retrieve the amount of streams that have not finished yet.
+         * @return The amount of open or queued streams.
+         */
+        unsigned active() const ;
+
+        /** Method to retrieve the status code of a finished stream.
+         * @param stream The id of the stream.
+         * @return The HTTP status code, or 0 if the stream failed or was reset.
+         */
+        unsigned status( unsigned stream ) const ;
+
+        /** Method to retrieve a response header of a stream.
+         * @param stream The id of the stream.
+         * @param key The lower-case name of the header.
+         * @return The C-string value of the header, or an empty string if it was not sent.
+         */
+        const char* value( unsigned stream, const char* key ) const ;
+
+        /** Method to retrieve the response body of a stream.
+         * @param stream The id of the stream.
+         * @return The pointer to the start of the body bytes.
+         */
+        const unsigned char* body( unsigned stream ) const ;
+
+        /** Method to retrieve the size of the response body of a stream.
+         * @param stream The id of the stream.
+         * @return The amount of bytes in the body.
+         */
+        unsigned size( unsigned stream ) const ;
+
+        /** Method to release the memory of a finished stream.
+         * @param stream The id of the stream.
+         */
+        void release( unsigned stream ) ;
+
+        /** Method to retrieve whether or not the connection is still usable.
+         * @return False once either side has sent GOAWAY or a connection error occured.
+         */
+        bool valid() const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct Http2SessionData *session_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        Http2SessionData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const Http2SessionData& data() const ;
+    };
+
+    /** Class to make many concurrent requests to one host over a single HTTP/2 connection.
+     * Secure connections negotiate HTTP/2 through ALPN, plain connections assume the server speaks HTTP/2 (h2c with prior knowledge).
+     */
+    class Http2Client
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Http2Client() ;
+
+        /** Default deconstructor.
+         */
+        ~Http2Client() ;
+
+        /** Method to connect to a host.
+         * @param host The C-string host name to connect to.
+         * @param port The port to connect on.
+         * @param secure Whether or not to connect over TLS.
+         * @return Whether or not an HTTP/2 connection was made. False if the server did not agree to HTTP/2.
+         */
+        bool connect( const char* host, unsigned port = 443, bool secure = true ) ;
+
+        /** Method to queue a GET request on the connected host.
+         * @param path The C-string path & query to request.
+         * @param weight The priority weight of the stream, from 1 to 256.
+         * @return The id of the stream the request is made on.
+         */
+        unsigned get( const char* path, unsigned weight = 16 ) ;
+
+        /** Method to wait for the next stream to finish.
+         * @return Whether or not a stream finished. False when there are no streams left.
+         */
+        bool next() ;
+
+        /** Method to retrieve the id of the stream that last finished.
+         * @return The id of the current stream.
+         */
+        unsigned stream() const ;
+
+        /** Method to retrieve the status code of the current stream.
+         * @return The HTTP status code, or 0 if the stream failed.
+         */
+        unsigned status() const ;
+
+        /** Method to retrieve a response header of the current stream.
+         * @param key The lower-case name of the header.
+         * @return The C-string value of the header, or an empty string if it was not sent.
+         */
+        const char* value( const char* key ) const ;
+
+        /** Method to retrieve the response body of the current stream.
+         * @note This is only valid until the next call to Http2Client::next().
+         * @return The pointer to the start of the body bytes.
+         */
+        const unsigned char* body() const ;
+
+        /** Method to retrieve the size of the response body of the current stream.
+         * @return The amount of bytes in the body.
+         */
+        unsigned size() const ;
+
+        /** Method to retrieve the underlying session, e.g. to change stream priorities.
+         * @return Reference to this object's HTTP/2 session.
+         */
+        Http2Session& session() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct Http2ClientData *client_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        Http2ClientData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const Http2ClientData& data() const ;
+    };
+  }
+}
+
+#endif /* HTTP2_H */
+
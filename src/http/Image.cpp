@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Image.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 14, 2021, 4:22 PM
+ */
+
+#include "Image.h"
+#include "Resample.h"
+#include "Decoder.h"
+#include "stb_image.h"
+
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+namespace ygg
+{
+  /** Function to find the size an image shrinks to, to fit in a box without changing it's aspect ratio.
+   * @param width The width of the image.
+   * @param height The height of the image.
+   * @param max_width The width of the box. 0 for no limit.
+   * @param max_height The height of the box. 0 for no limit.
+   * @param out_width Set to the width to shrink to.
+   * @param out_height Set to the height to shrink to.
+   */
+  static void fit( unsigned width, unsigned height, unsigned max_width, unsigned max_height, unsigned& out_width, unsigned& out_height )
+  {
+    const std::uint64_t wide = width  ;
+    const std::uint64_t tall = height ;
+
+    out_width  = width  ;
+    out_height = height ;
+
+    if( ( max_width == 0 || width <= max_width ) && ( max_height == 0 || height <= max_height ) ) return ;
+
+    // Whichever side overflows it's limit by the larger factor decides the scale.
+    if( max_width != 0 && ( max_height == 0 || wide * max_height >= tall * max_width ) )
+    {
+      out_width  = max_width ;
+      out_height = static_cast<unsigned>( std::max<std::uint64_t>( 1, ( tall * max_width + wide / 2 ) / wide ) ) ;
+    }
+    else
+    {
+      out_height = max_height ;
+      out_width  = static_cast<unsigned>( std::max<std::uint64_t>( 1, ( wide * max_height + tall / 2 ) / tall ) ) ;
+    }
+  }
+
+  DecodeOptions::DecodeOptions()
+  {
+    this->format     = PixelFormat::Rgba    ;
+    this->max_width  = 0                    ;
+    this->max_height = 0                    ;
+    this->type       = ImageFormat::Unknown ;
+  }
+
+  ImageInfo::ImageInfo()
+  {
+    this->clear() ;
+  }
+
+  bool ImageInfo::probe( const unsigned char* bytes, std::size_t size )
+  {
+    int width  ;
+    int height ;
+    int chan   ;
+
+    this->clear() ;
+    if( bytes == nullptr || size == 0 || size > static_cast<std::size_t>( std::numeric_limits<int>::max() ) ) return false ;
+
+    // STB reads just far enough into the image to find it's dimensions.
+    if( stbi_info_from_memory( bytes, static_cast<int>( size ), &width, &height, &chan ) == 0 ) return false ;
+
+    this->info_width    = static_cast<unsigned>( width  ) ;
+    this->info_height   = static_cast<unsigned>( height ) ;
+    this->info_channels = static_cast<unsigned>( chan   ) ;
+    this->info_format   = decoders::sniff( bytes, size )  ;
+
+    // TGA has no signature, so anything else STB understands is assumed to be one.
+    if( this->info_format == ImageFormat::Unknown ) this->info_format = ImageFormat::Tga ;
+
+    return true ;
+  }
+
+  void ImageInfo::clear()
+  {
+    this->info_width    = 0                    ;
+    this->info_height   = 0                    ;
+    this->info_channels = 0                    ;
+    this->info_format   = ImageFormat::Unknown ;
+  }
+
+  bool ImageInfo::valid() const
+  {
+    return this->info_format != ImageFormat::Unknown ;
+  }
+
+  unsigned ImageInfo::width() const
+  {
+    return this->info_width ;
+  }
+
+  unsigned ImageInfo::height() const
+  {
+    return this->info_height ;
+  }
+
+  unsigned ImageInfo::channels() const
+  {
+    return this->info_channels ;
+  }
+
+  ImageFormat ImageInfo::format() const
+  {
+    return this->info_format ;
+  }
+
+  void Image::Release::operator()( unsigned char* pixels ) const
+  {
+    std::free( pixels ) ;
+  }
+
+  Image::Image()
+  {
+    this->image_size     = 0                   ;
+    this->image_width    = 0                   ;
+    this->image_height   = 0                   ;
+    this->image_channels = 0                   ;
+    this->image_source   = 0                   ;
+    this->image_format   = PixelFormat::Native ;
+  }
+
+  Image::Image( const Image& image )
+  {
+    this->image_size     = 0                   ;
+    this->image_width    = 0                   ;
+    this->image_height   = 0                   ;
+    this->image_channels = 0                   ;
+    this->image_source   = 0                   ;
+    this->image_format   = PixelFormat::Native ;
+
+    *this = image ;
+  }
+
+  Image::Image( Image&& image ) noexcept
+  {
+    this->image_size     = 0                   ;
+    this->image_width    = 0                   ;
+    this->image_height   = 0                   ;
+    this->image_channels = 0                   ;
+    this->image_source   = 0                   ;
+    this->image_format   = PixelFormat::Native ;
+
+    *this = std::move( image ) ;
+  }
+
+  Image& Image::operator=( const Image& image )
+  {
+    unsigned char* pixels ;
+
+    if( this == &image ) return *this ;
+
+    this->clear() ;
+    if( !image.valid() ) return *this ;
+
+    // Copies are allocated with malloc like the decoder's, so every image releases it's pixels alike.
+    pixels = static_cast<unsigned char*>( std::malloc( image.image_size ) ) ;
+    if( pixels == nullptr ) return *this ;
+
+    std::memcpy( pixels, image.image_pixels.get(), image.image_size ) ;
+    this->image_pixels.reset( pixels ) ;
+    this->image_size     = image.image_size     ;
+    this->image_width    = image.image_width    ;
+    this->image_height   = image.image_height   ;
+    this->image_channels = image.image_channels ;
+    this->image_source   = image.image_source   ;
+    this->image_format   = image.image_format   ;
+
+    return *this ;
+  }
+
+  Image& Image::operator=( Image&& image ) noexcept
+  {
+    if( this == &image ) return *this ;
+
+    this->image_pixels   = std::move( image.image_pixels ) ;
+    this->image_size     = image.image_size     ;
+    this->image_width    = image.image_width    ;
+    this->image_height   = image.image_height   ;
+    this->image_channels = image.image_channels ;
+    this->image_source   = image.image_source   ;
+    this->image_format   = image.image_format   ;
+
+    image.image_size     = 0                   ;
+    image.image_width    = 0                   ;
+    image.image_height   = 0                   ;
+    image.image_channels = 0                   ;
+    image.image_source   = 0                   ;
+    image.image_format   = PixelFormat::Native ;
+
+    return *this ;
+  }
+
+  bool Image::decode( const unsigned char* bytes, std::size_t size, unsigned channels, unsigned max_width, unsigned max_height )
+  {
+    if( channels > 4 )
+    {
+      this->clear() ;
+      return false ;
+    }
+
+    return this->decode( bytes, size, pixels::standard( channels ), max_width, max_height ) ;
+  }
+
+  bool Image::decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned max_width, unsigned max_height )
+  {
+    DecodeOptions options ;
+
+    options.format     = format     ;
+    options.max_width  = max_width  ;
+    options.max_height = max_height ;
+
+    return this->decode( bytes, size, options ) ;
+  }
+
+  bool Image::decode( const unsigned char* bytes, std::size_t size, const DecodeOptions& options )
+  {
+    static thread_local Resampler resampler ;
+
+    const bool     shrink = options.max_width != 0 || options.max_height != 0 ;
+    ImageInfo      info       ;
+    DecodedImage   decoded    ;
+    ImageFormat    type       ;
+    PixelFormat    format     ;
+    unsigned char* shrunk     ;
+    unsigned       out_width  ;
+    unsigned       out_height ;
+
+    out_width  = 0 ;
+    out_height = 0 ;
+
+    this->clear() ;
+    if( bytes == nullptr || size == 0 ) return false ;
+
+    // Knowing the size to shrink to up front lets backends decode at a fraction of full size.
+    if( shrink && info.probe( bytes, size ) ) fit( info.width(), info.height(), options.max_width, options.max_height, out_width, out_height ) ;
+
+    // The bytes themselves are trusted over whatever the image was served as, which only decides for encodings without a signature.
+    type = decoders::sniff( bytes, size ) ;
+    if( type == ImageFormat::Unknown ) type = options.type != ImageFormat::Unknown ? options.type : ImageFormat::Tga ;
+
+    if( !decoders::find( type ).decode( bytes, size, options.format, out_width, out_height, decoded ) ) return false ;
+    if( decoded.pixels == nullptr || decoded.format == PixelFormat::Native ) return false ;
+
+    // The decoder's buffer is adopted as is, rather than copied into one of our own.
+    this->image_pixels.reset( decoded.pixels ) ;
+    this->image_source   = decoded.source                        ;
+    this->image_format   = decoded.format                        ;
+    this->image_channels = pixels::channels( decoded.format )    ;
+    this->image_width    = decoded.width                         ;
+    this->image_height   = decoded.height                        ;
+    this->image_size     = static_cast<std::size_t>( decoded.width ) * decoded.height * this->image_channels ;
+
+    // Whatever the backend could not produce is converted in place while the pixels are still warm, & before shrinking so premultiplied colours are what gets averaged.
+    // Sources without alpha are opaque, so they never need multiplying.
+    format = options.format != PixelFormat::Native ? options.format : decoded.format ;
+    if( !this->convert( decoded.source % 2 == 1 ? pixels::straight( format ) : format ) )
+    {
+      this->clear() ;
+      return false ;
+    }
+
+    // Backends given no size to aim for decoded at full size, which still has to fit in the box.
+    if( shrink && out_width == 0 ) fit( this->image_width, this->image_height, options.max_width, options.max_height, out_width, out_height ) ;
+
+    // Whatever the decoder could not shrink is area averaged the rest of the way into the box.
+    if( shrink && ( out_width != this->image_width || out_height != this->image_height ) )
+    {
+      shrunk = static_cast<unsigned char*>( std::malloc( static_cast<std::size_t>( out_width ) * out_height * this->image_channels ) ) ;
+      if( shrunk == nullptr || !resampler.resize( this->image_pixels.get(), this->image_width, this->image_height, this->image_channels, shrunk, out_width, out_height ) )
+      {
+        std::free( shrunk ) ;
+        this->clear() ;
+        return false ;
+      }
+
+      this->image_pixels.reset( shrunk ) ;
+      this->image_width  = out_width  ;
+      this->image_height = out_height ;
+      this->image_size   = static_cast<std::size_t>( out_width ) * out_height * this->image_channels ;
+    }
+
+    this->image_format = format ;
+
+    return true ;
+  }
+
+  bool Image::convert( PixelFormat format )
+  {
+    const PixelFormat target = format != PixelFormat::Native ? format : pixels::standard( this->image_source ) ;
+    const std::size_t count  = static_cast<std::size_t>( this->image_width ) * this->image_height ;
+    unsigned char*    converted ;
+
+    if( !this->valid()               ) return false ;
+    if( target == this->image_format ) return true  ;
+
+    // Growing needs a bigger buffer. Otherwise the pixels are rewritten where they are.
+    if( pixels::channels( target ) > this->image_channels )
+    {
+      converted = static_cast<unsigned char*>( std::malloc( count * pixels::channels( target ) ) ) ;
+      if( converted == nullptr ) return false ;
+
+      pixels::convert( this->image_pixels.get(), this->image_format, converted, target, count ) ;
+      this->image_pixels.reset( converted ) ;
+    }
+    else
+    {
+      pixels::convert( this->image_pixels.get(), this->image_format, this->image_pixels.get(), target, count ) ;
+    }
+
+    this->image_format   = target                       ;
+    this->image_channels = pixels::channels( target )   ;
+    this->image_size     = count * this->image_channels ;
+
+    return true ;
+  }
+
+  void Image::clear()
+  {
+    this->image_pixels.reset() ;
+    this->image_size     = 0                   ;
+    this->image_width    = 0                   ;
+    this->image_height   = 0                   ;
+    this->image_channels = 0                   ;
+    this->image_source   = 0                   ;
+    this->image_format   = PixelFormat::Native ;
+  }
+
+  bool Image::valid() const
+  {
+    return this->image_pixels != nullptr ;
+  }
+
+  unsigned Image::width() const
+  {
+    return this->image_width ;
+  }
+
+  unsigned Image::height() const
+  {
+    return this->image_height ;
+  }
+
+  unsigned Image::channels() const
+  {
+    return this->image_channels ;
+  }
+
+  PixelFormat Image::format() const
+  {
+    return this->image_format ;
+  }
+
+  unsigned Image::sourceChannels() const
+  {
+    return this->image_source ;
+  }
+
+  const unsigned char* Image::pixels() const
+  {
+    return this->image_pixels.get() ;
+  }
+
+  std::size_t Image::size() const
+  {
+    return this->image_size ;
+  }
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Image.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 14, 2021, 4:22 PM
+ */
+
+#ifndef YGGDRASIL_IMAGE_H
+#define YGGDRASIL_IMAGE_H
+
+#include "Pixels.h"
+#include <memory>
+#include <cstddef>
+
+namespace ygg
+{
+  /** The encodings an image can be in.
+   */
+  enum class ImageFormat
+  {
+    Unknown,
+    Png,
+    Jpeg,
+    Gif,
+    Bmp,
+    Psd,
+    Hdr,
+    Pic,
+    Pnm,
+    Tga
+  };
+
+  /** Structure to describe how to decode an image. Every decoder backend is held to the same options.
+   */
+  struct DecodeOptions
+  {
+    PixelFormat format     ; ///< The format to decode to. PixelFormat::Native keeps the channels of the source.
+    unsigned    max_width  ; ///< The widest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+    unsigned    max_height ; ///< The tallest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+    ImageFormat type       ; ///< The encoding the image was served as, e.g. from it's Content-Type. Only used when the bytes have no signature.
+
+    /** Default constructor. Decodes to RGBA at full size.
+     */
+    DecodeOptions() ;
+  };
+
+  /** Class to describe an encoded image from it's header alone, without decoding it.
+   */
+  class ImageInfo
+  {
+    public:
+
+      /** Default constructor. Creates an empty description.
+       */
+      ImageInfo() ;
+
+      /** Method to read the header of an encoded image into this object, replacing it's contents.
+       * @note Only the start of the image is needed, usually no more than a few hundred bytes.
+       * @param bytes The start of the encoded image bytes.
+       * @param size The amount of encoded bytes available.
+       * @return Whether or not the header could be read. On failure this description is left empty.
+       */
+      bool probe( const unsigned char* bytes, std::size_t size ) ;
+
+      /** Method to empty this description.
+       */
+      void clear() ;
+
+      /** Method to retrieve whether or not this object describes an image.
+       * @return Whether or not a header was read successfully.
+       */
+      bool valid() const ;
+
+      /** Method to retrieve the width of the image.
+       * @return The width of the image in pixels.
+       */
+      unsigned width() const ;
+
+      /** Method to retrieve the height of the image.
+       * @return The height of the image in pixels.
+       */
+      unsigned height() const ;
+
+      /** Method to retrieve the number of channels the image is encoded with.
+       * @return The amount of channels of the image.
+       */
+      unsigned channels() const ;
+
+      /** Method to retrieve the encoding of the image.
+       * @return The format the image is encoded in.
+       */
+      ImageFormat format() const ;
+
+    private:
+
+      unsigned    info_width    ; ///< The width of the image.
+      unsigned    info_height   ; ///< The height of the image.
+      unsigned    info_channels ; ///< The number of channels of the image.
+      ImageFormat info_format   ; ///< The encoding of the image.
+  };
+
+  /** Class to hold a decoded image.
+   * Pixels are in whichever format was asked for when decoding, with each channel being represented by a single byte.
+   * Decoding is handed to the backend registered for the image's encoding, STB unless another is set or built in. See decoders::find().
+   * Reordering & premultiplying is done as the decoder writes each row of a JPEG, & in one pass over the freshly decoded pixels otherwise.
+   * Images shrunk while decoding never exist at full size: JPEGs are decoded at 1/2, 1/4 or 1/8 scale, & the rest is area averaged.
+   * The decoder's own allocation is adopted, so decoded pixels are written exactly once & never copied afterwards.
+   */
+  class Image
+  {
+    public:
+
+      /** Default constructor. Creates an empty image.
+       */
+      Image() ;
+
+      /** Copy constructor. Copies the pixels of the input image.
+       * @param image The image to copy.
+       */
+      Image( const Image& image ) ;
+
+      /** Move constructor. Takes the pixels of the input image, leaving it empty.
+       * @param image The image to move from.
+       */
+      Image( Image&& image ) noexcept ;
+
+      /** Default deconstructor.
+       */
+      ~Image() = default ;
+
+      /** Assignment operator. Copies the pixels of the input image.
+       * @param image The image to copy.
+       * @return A reference to this object after assignment.
+       */
+      Image& operator=( const Image& image ) ;
+
+      /** Move assignment operator. Takes the pixels of the input image, leaving it empty.
+       * @param image The image to move from.
+       * @return A reference to this object after assignment.
+       */
+      Image& operator=( Image&& image ) noexcept ;
+
+      /** Method to decode an encoded .png/jpeg/whatever image into this object, replacing it's contents.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param channels The amount of channels to decode to: 1 grey, 2 grey-alpha, 3 RGB or 4 RGBA. 0 keeps the channels of the source.
+       * @param max_width The widest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+       * @param max_height The tallest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+       * @return Whether or not the image could be decoded. On failure this image is left empty.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, unsigned channels = 4, unsigned max_width = 0, unsigned max_height = 0 ) ;
+
+      /** Method to decode an encoded .png/jpeg/whatever image into this object in a specific pixel format, replacing it's contents.
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param format The format to decode to, e.g. PixelFormat::BgraPremultiplied to hand straight to a compositor.
+       * @param max_width The widest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+       * @param max_height The tallest the decoded image may be, shrinking it to fit while keeping it's aspect ratio. 0 for no limit.
+       * @return Whether or not the image could be decoded. On failure this image is left empty.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, PixelFormat format, unsigned max_width = 0, unsigned max_height = 0 ) ;
+
+      /** Method to decode an encoded image into this object with the backend registered for it's encoding, replacing it's contents.
+       * @note Whichever backend decodes the image, the pixels end up in the asked for format & size. See decoders::set().
+       * @param bytes The encoded image bytes.
+       * @param size The amount of encoded bytes.
+       * @param options The format, size limits & encoding hint to decode with.
+       * @return Whether or not the image could be decoded. On failure this image is left empty.
+       */
+      bool decode( const unsigned char* bytes, std::size_t size, const DecodeOptions& options ) ;
+
+      /** Method to convert the pixels of this image to another format.
+       * @note Formats with no more channels than the current one are converted in place, without allocating.
+       * @param format The format to convert to. PixelFormat::Native converts back to the standard format of the source's channels.
+       * @return Whether or not the image could be converted. An empty image can not be.
+       */
+      bool convert( PixelFormat format ) ;
+
+      /** Method to empty this image, releasing it's pixels.
+       */
+      void clear() ;
+
+      /** Method to retrieve whether or not this image holds any pixels.
+       * @return Whether or not this image was decoded successfully.
+       */
+      bool valid() const ;
+
+      /** Method to retrieve the width of this image.
+       * @return The width of the image in pixels.
+       */
+      unsigned width() const ;
+
+      /** Method to retrieve the height of this image.
+       * @return The height of the image in pixels.
+       */
+      unsigned height() const ;
+
+      /** Method to retrieve the number of channels of each pixel.
+       * @return The amount of channels of this image.
+       */
+      unsigned channels() const ;
+
+      /** Method to retrieve the format of the pixels of this image.
+       * @return The layout of each pixel. PixelFormat::Native for an empty image.
+       */
+      PixelFormat format() const ;
+
+      /** Method to retrieve the number of channels the encoded image had, before any conversion.
+       * @return The amount of channels of the source image.
+       */
+      unsigned sourceChannels() const ;
+
+      /** Method to retrieve the pixels of this image.
+       * @return The pointer to the start of the pixel bytes.
+       */
+      const unsigned char* pixels() const ;
+
+      /** Method to retrieve the size of the pixels of this image.
+       * @return The amount of bytes of pixels.
+       */
+      std::size_t size() const ;
+
+    private:
+
+      /** Structure to release pixels allocated by the decoder.
+       */
+      struct Release
+      {
+        /** Operator to release pixels.
+         * @param pixels The pixels to release.
+         */
+        void operator()( unsigned char* pixels ) const ;
+      };
+
+      using Pixels = std::unique_ptr<unsigned char, Release> ;
+
+      Pixels      image_pixels   ; ///< The pixels of the image, as allocated by the decoder.
+      std::size_t image_size     ; ///< The amount of bytes of pixels.
+      unsigned    image_width    ; ///< The width of the image.
+      unsigned    image_height   ; ///< The height of the image.
+      unsigned    image_channels ; ///< The number of channels of the image.
+      unsigned    image_source   ; ///< The number of channels of the encoded image.
+      PixelFormat image_format   ; ///< The format of the pixels.
+  };
+}
+
+#endif /* IMAGE_H */
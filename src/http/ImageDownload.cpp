@@ -24,7 +24,18 @@
 
 #include "ImageDownload.h"
 #include "Parser.h"
-#include "stb_image.h"
+#include "Chunked.h"
+#include "Decompressor.h"
+#include "Url.h"
+#include "Request.h"
+#include "Cache.h"
+#include "DiskCache.h"
+#include "Pool.h"
+#include "Segmented.h"
+#include "Client.h"
+#include "Image.h"
+#include "Decoder.h"
+#include "DecodePool.h"
 #include <ygg/Yggdrasil.h>
 #include <ygg/Connection.h>
 #ifdef _WIN32
@@ -36,79 +47,209 @@
 #endif
 
 #include <vector>
+#include <array>
 #include <string>
-#include <sstream>
 #include <fstream>
 #include <ostream>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <future>
   
 namespace ygg
 {
   
+  /** The default minimum size of a body worth fetching in segments.
+   */
+  static const std::size_t DEFAULT_SEGMENT_THRESHOLD = 1024 * 1024 ;
+  
+  /** The most bytes reserved for a body before it arrives, whatever it's Content-Length claims. Bigger bodies grow as they arrive.
+   */
+  static const std::size_t RESERVE_LIMIT = 16 * 1024 * 1024 ;
+  
+  /** The biggest body fetched in segments, which needs the whole body allocated up front.
+   */
+  static const std::size_t SEGMENT_LIMIT = 256 * 1024 * 1024 ;
+  
+  /** The amount of times a dropped body is resumed before giving up on it.
+   */
+  static const unsigned RESUME_ATTEMPTS = 3 ;
+  
+  /** The amount of bytes first asked for when probing an image. Enough for the header of nearly any image.
+   */
+  static const std::size_t PROBE_BYTES = 4096 ;
+  
+  /** The most bytes read while probing an image, e.g. for JPEGs with large metadata before their header.
+   */
+  static const std::size_t PROBE_LIMIT = 64 * 1024 ;
+  
+  /** Sink to collect the start of an image, stopping the transfer once it's header can be read.
+   */
+  struct ProbeSink : public http::Sink
+  {
+    std::vector<unsigned char> bytes ; ///< The bytes of the image received so far.
+    ImageInfo                  info  ; ///< The description of the image, once it's header is read.
+    
+    /** Method to collect body bytes, trying to read the image's header after each block.
+     * @param bytes The body bytes.
+     * @param amount The amount of body bytes.
+     * @return Whether or not more of the body is needed.
+     */
+    bool write( const unsigned char* bytes, std::size_t amount ) override ;
+  };
+
   struct ImageDownloaderData
   {
-    using ImageData = std::vector<unsigned char> ;
-    
-    ygg::Connection<Impl> connection ; ///< The connection to make to the server.
-    ygg::http::Parser     parser     ; ///< The parser for the HTTP header.
-    ImageData             data       ; ///< The data container of the image bytes.
-    ImageData             img_bytes  ; ///< The data container of the image bytes.
-    std::string           host       ; ///< The hostname of the image provider.
-    std::string           location   ; ///< The location in the hostname the image is held.
-    unsigned              width      ; ///< The width of the image.
-    unsigned              height     ; ///< The height of the image.
-    unsigned              channels   ; ///< The number of channels in the image.
+    using ImageData = std::vector<unsigned char>         ;
+    using Scratch   = std::array<char, ygg::PACKET_SIZE> ;
+    using Decoding  = std::future<bool>                  ;
+    
+    ygg::Connection<Impl>   connection ; ///< The connection to make to the server.
+    ygg::http::Parser       parser     ; ///< The parser for the HTTP header.
+    http::ChunkedDecoder    decoder    ; ///< The decoder for chunked HTTP bodies.
+    http::Decompressor      inflater   ; ///< The decompressor for gzip/deflate HTTP bodies.
+    Scratch                 scratch    ; ///< The reused buffer for chunk-decoded data awaiting decompression.
+    ImageData               data       ; ///< The data container of the image bytes.
+    ImageData               img_bytes  ; ///< The data container of the image bytes.
+    http::Url               url        ; ///< The parsed URL of the image being downloaded.
+    http::Request           request    ; ///< The builder of the request message.
+    http::Cache             cache      ; ///< The responses of earlier downloads.
+    http::DiskCache         disk       ; ///< The responses of earlier runs.
+    http::Pool              pool       ; ///< The idle connections used for segmented bodies.
+    http::SegmentedDownload segmented  ; ///< The parallel fetch of the rest of a segmented body.
+    http::Client            client     ; ///< The client used to probe images.
+    unsigned                segments   ; ///< The amount of connections to fetch a large body over.
+    std::size_t             threshold  ; ///< The minimum size of a body worth segmenting.
+    std::string             host       ; ///< The hostname of the image provider, kept null-terminated for connecting.
+    Image                   image      ; ///< The decoded image.
+    DecodePool*             decoders   ; ///< The pool to decode images on, if any.
+    DecodeOptions           options    ; ///< The format & size limits to decode images with.
+    mutable Decoding        decoding   ; ///< The decode in progress on the pool, if any.
 
     /** Default constructor.
      */
     ImageDownloaderData() ;
     
-    /** Method to build the HTTP image request message to send.
+    /** Method to append received body bytes to the image data, decompressing them if needed.
+     * @param bytes The body bytes, with any transfer framing already removed.
+     * @param amount The amount of body bytes.
      */
-    std::string message() const ;
+    void append( const char* bytes, unsigned amount ) ;
     
+    /** Method to decode an encoded image, reporting an error if it could not be.
+     * @param bytes The encoded .png/jpeg/whatever bytes.
+     * @param size The amount of encoded bytes.
+     * @param type The encoding the image was served as, for images without a signature. ImageFormat::Unknown if not known.
+     */
+    void decode( const unsigned char* bytes, std::size_t size, ImageFormat type = ImageFormat::Unknown ) ;
+    
+    /** Method to wait for a decode in progress on the pool, reporting an error if it failed.
+     */
+    void finish() const ;
     
-    /** Method to parse the incoming URL into host name and location.
-     * @param url The C-string url to parse.
+    /** Method to reconnect after the connection dropped mid-body, & ask for the rest of the body.
+     * @param offset The offset of the first body byte not yet received.
+     * @param validator The C-string ETag or Last-Modified date the body must still match.
+     * @param packet The packet to fill with any body bytes received along with the header.
+     * @return Whether or not the server is sending the rest of the same body.
      */
-    void parseURL( const char* url ) ;
+    bool resume( std::size_t offset, const char* validator, ygg::Packet& packet ) ;
   };
   
-  std::string ImageDownloaderData::message() const
+  ImageDownloaderData::ImageDownloaderData()
   {
-    std::string       ret    ;
-    std::stringstream stream ;
+    this->host       = ""                        ;
+    this->segments   = 1                         ;
+    this->threshold  = DEFAULT_SEGMENT_THRESHOLD ;
+    this->decoders   = nullptr                   ;
+    this->segmented.setPool( this->pool ) ;
+    this->client   .setPool( this->pool ) ;
+  }
+  
+  bool ProbeSink::write( const unsigned char* bytes, std::size_t amount )
+  {
+    amount = std::min( amount, PROBE_LIMIT - this->bytes.size() ) ;
+    this->bytes.insert( this->bytes.end(), bytes, bytes + amount ) ;
+    
+    // Stopping early closes the connection, so a server sending the whole body does not get to.
+    return !this->info.probe( this->bytes.data(), this->bytes.size() ) && this->bytes.size() < PROBE_LIMIT ;
+  }
+  
+  void ImageDownloaderData::append( const char* bytes, unsigned amount )
+  {
+    unsigned produced ;
     
-    stream << "GET "   << this->location << " HTTP/1.1\r\n" ;
-    stream << "HOST: " << this->host     << "\r\n\r\n"      ;
+    if( this->inflater.active() )
+    {
+      produced = this->inflater.decompress( bytes, amount ) ;
+      this->data.insert( this->data.end(), this->inflater.output(), this->inflater.output() + produced ) ;
+    }
+    else
+    {
+      this->data.insert( this->data.end(), bytes, bytes + amount ) ;
+    }
+  }
+  
+  void ImageDownloaderData::decode( const unsigned char* bytes, std::size_t size, ImageFormat type )
+  {
+    this->options.type = type ;
 
-    ret = stream.str() ;
-    return ret ;
+    // The bytes stay untouched until the next download, which waits for this decode first.
+    if( this->decoders != nullptr )
+    {
+      this->decoding = this->decoders->decode( this->image, bytes, size, this->options ) ;
+      return ;
+    }
+    
+    if( !this->image.decode( bytes, size, this->options ) ) ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidImage ) ;
   }
-  ImageDownloaderData::ImageDownloaderData()
+  
+  void ImageDownloaderData::finish() const
   {
-    this->width    = 0  ;
-    this->height   = 0  ;
-    this->host     = "" ;
-    this->location = "" ;
+    if( this->decoding.valid() && !this->decoding.get() ) ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidImage ) ;
   }
   
-  void ImageDownloaderData::parseURL( const char* url )
+  bool ImageDownloaderData::resume( std::size_t offset, const char* validator, ygg::Packet& packet )
   {
-    std::string full  ;
-    std::size_t begin ;
-    std::size_t end   ;
+    http::Parser parser  ;
+    std::string  range   ;
+    const char*  content ;
+    
+    // Without a validator, a changed body could be spliced onto the old one.
+    if( validator[ 0 ] == '\0' ) return false ;
     
-    full  = url                 ;
-    begin = full.find( "://"  ) ;
-    end   = full.find( ".com" ) ;
+    this->connection.reset() ;
+    this->connection.connect( this->host.c_str(), ygg::ConnectionType::Client, this->url.port(), this->url.secure() ) ;
+    if( !this->connection.valid() ) return false ;
     
-    if( begin != std::string::npos ) begin += 3 ; else begin = 0 ;
-    if( end   != std::string::npos ) end   += 4 ; else end   = 0 ;
+    range  = "bytes=" ;
+    range += std::to_string( offset ) ;
+    range += '-' ;
     
-    this->host     = full.substr( begin, end - begin ) ;
-    this->location = full.substr( end, full.size()   ) ;
+    this->request.clear() ;
+    this->request.begin( "GET", this->url.path(), this->url.query() ) ;
+    this->request.add( "Range"   , range     ) ;
+    this->request.add( "If-Range", validator ) ;
+    this->request.end() ;
+    this->connection.send( this->request.payload(), this->request.size() ) ;
+    
+    while( !parser.parsed() )
+    {
+      packet = this->connection.recieve() ;
+      if( packet.size() == 0 ) return false ;
+      parser.parse( packet ) ;
+    }
+    
+    // A 200 means the body changed or ranges are not supported, & the bytes already received are useless.
+    content = parser.value( "Content-Range" ) ;
+    if( parser.status() != 206 || std::strncmp( content, "bytes ", 6 ) != 0 || std::strtoull( content + 6, nullptr, 10 ) != offset ) return false ;
+    
+    packet = parser.leftover() ;
+    return true ;
   }
-
+  
   ImageDownloader::ImageDownloader()
   {
     this->image_data = new ImageDownloaderData() ;
@@ -116,100 +257,362 @@ namespace ygg
   
   ImageDownloader::~ImageDownloader()
   {
+    data().finish() ;
     delete this->image_data ;
   }
   
   void ImageDownloader::download( const char* image_url )
   {
-    ygg::Packet    packet       ;
-    unsigned       content_size ;
-    unsigned       request_amt  ;
-    int            width        ;
-    int            height       ;
-    int            chan         ;
-    unsigned char* bytes        ;
+    ygg::Packet      packet       ;
+    const char*      length       ;
+    std::size_t      offset       ;
+    unsigned         content_size ;
+    unsigned         request_amt  ;
+    unsigned         received     ;
+    unsigned         amount       ;
+    bool             chunked      ;
+    bool             cached       ;
+    bool             stored       ;
+    bool             success      ;
+    bool             complete     ;
+    const char*      etag         ;
+    const char*      modified     ;
+    const char*      validator    ;
+    std::string_view key          ;
+    unsigned         first        ;
+    unsigned         segments     ;
+    unsigned         attempts     ;
 
+    data().finish() ;
     data().connection.reset() ;
-    data().width    = 0 ;
-    data().height   = 0 ;
-    data().channels = 0 ;
-    width           = 0 ;
-    height          = 0 ;
-    chan            = 0 ;
+    data().image.clear() ;
     data().data.clear() ;
-    data().data.shrink_to_fit() ;
     data().parser.reset() ;
-    data().parseURL( image_url ) ;
-    data().connection.connect( data().host.c_str() ) ;        
-    data().connection.send( data().message().c_str(), data().message().size() ) ;
+    
+    if( !data().url.parse( image_url ) )
+    {
+      ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidUrl ) ;
+      return ;
+    }
+    
+    // Fresh responses are served from the cache. Stale ones are revalidated, so an unchanged body is not sent again.
+    key    = std::string_view( image_url, std::strcspn( image_url, "#" ) ) ;
+    cached = data().cache.find( key ) ;
+    if( cached && data().cache.fresh() )
+    {
+      data().decode( data().cache.body(), data().cache.size() ) ;
+      return ;
+    }
+    
+    // Disk hits are memory-mapped & decoded in place.
+    stored = data().disk.find( key ) && data().disk.body() != nullptr ;
+    if( stored && data().disk.fresh() )
+    {
+      data().decode( data().disk.body(), data().disk.size() ) ;
+      return ;
+    }
+    
+    etag     = cached ? data().cache.etag()         : stored ? data().disk.etag()         : "" ;
+    modified = cached ? data().cache.lastModified() : stored ? data().disk.lastModified() : "" ;
+    
+    // The scheme decides the default port & whether the connection is secure.
+    data().host.assign( data().url.host().data(), data().url.host().size() ) ;
+    data().connection.connect( data().host.c_str(), ygg::ConnectionType::Client, data().url.port(), data().url.secure() ) ;
+    
+    data().request.setHost( data().url.authority() ) ;
+    data().request.clear() ;
+    data().request.begin( "GET", data().url.path(), data().url.query() ) ;
+    if( etag[ 0 ]     != '\0' ) data().request.add( "If-None-Match"    , etag     ) ;
+    if( modified[ 0 ] != '\0' ) data().request.add( "If-Modified-Since", modified ) ;
+    data().request.end() ;
+    data().connection.send( data().request.payload(), data().request.size() ) ;
     
     // Parse the HTTP header.
     while( !data().parser.parsed() ) 
     {
       packet = data().connection.recieve() ;
+      if( packet.size() == 0 ) break ;
       data().parser.parse( packet ) ;
     }
     
-    // Find out how big our image is & reserve that much data.
-    content_size = std::atoi( data().parser.value( "Content-Length" ) ) ;
-    data().data.reserve( content_size ) ;
+    if( !data().parser.parsed() )
+    {
+      ygg::Yggdrasil::addError( Yggdrasil::Error::ConnectionFailure ) ;
+      return ;
+    }
     
-    // Grab any data accidentally grabbed from the header packets.
-    packet = data().parser.leftover() ;
-    for( unsigned i = 0; i < packet.size(); i++ )
+    if( ( cached || stored ) && data().parser.status() == 304 )
     {
-      data().data.push_back( packet.payload()[ i ] ) ;
+      if( cached ) data().decode( data().cache.body(), data().cache.size() ) ;
+      else         data().decode( data().disk.body() , data().disk.size()  ) ;
+      
+      // A refresh may drop the entry, & with it the body a pooled decode is still reading, so that decode is waited on first.
+      data().finish() ;
+      if( cached ) data().cache.refresh( data().parser ) ;
+      if( stored ) data().disk .refresh( data().parser ) ;
+      return ;
     }
     
-    // Now, keep requesting until we've gotten all our data.
-    request_amt = content_size - data().data.size() ;
-    while( data().data.size() < content_size && packet.size() != 0 )
+    // Grab any data accidentally grabbed from the header packets.
+    packet   = data().parser.leftover() ;
+    received = 0 ;
+    attempts = 0 ;
+    chunked  = std::string( data().parser.value( "Transfer-Encoding" ) ).find( "chunked" ) != std::string::npos ;
+    data().inflater.initialize( data().parser.value( "Content-Encoding" ) ) ;
+    
+    if( chunked )
+    {
+      data().decoder.reset() ;
+      while( true )
+      {
+        if( data().inflater.active() )
+        {
+          // Compressed chunks are unframed into the scratch buffer, then inflated into the image buffer.
+          amount = data().decoder.decode( packet.payload(), packet.size(), data().scratch.data() ) ;
+          data().append( data().scratch.data(), amount ) ;
+        }
+        else
+        {
+          // Chunk framing is stripped straight into the image buffer as each packet arrives.
+          offset = data().data.size() ;
+          data().data.resize( offset + packet.size() ) ;
+          data().data.resize( offset + data().decoder.decode( packet.payload(), packet.size(), reinterpret_cast<char*>( data().data.data() + offset ) ) ) ;
+        }
+        
+        if( data().decoder.done() || !data().decoder.valid() ) break ;
+        
+        packet = data().connection.recieve() ;
+        if( packet.size() == 0 ) break ;
+      }
+      
+      complete = data().decoder.done() && data().decoder.valid() ;
+    }
+    else
     {
-      packet = data().connection.recieve( std::min( request_amt, PACKET_SIZE ) ) ;
+      // Find out how big our image is & reserve that much data. Without a length, the body runs until the server closes.
+      length       = data().parser.value( "Content-Length" ) ;
+      // The length is only the server's word, so lengths too big to count are clamped & only so much is allocated up front.
+      content_size = length[ 0 ] != '\0' ? static_cast<unsigned>( std::min<unsigned long long>( std::strtoull( length, nullptr, 10 ), std::numeric_limits<unsigned>::max() - 1 ) ) : std::numeric_limits<unsigned>::max() ;
+      if( content_size != std::numeric_limits<unsigned>::max() && !data().inflater.active() ) data().data.reserve( std::min<std::size_t>( content_size, RESERVE_LIMIT ) ) ;
+      
+      // Ranges are only trusted to continue the same body if it has a strong ETag or a Last-Modified date.
+      etag      = data().parser.value( "ETag" ) ;
+      validator = etag[ 0 ] != '\0' && std::strncmp( etag, "W/", 2 ) != 0 ? etag : data().parser.value( "Last-Modified" ) ;
       
-      for( unsigned i = 0; i < packet.size(); i++ )
+      if( data().segments > 1 && data().parser.status() == 200 && content_size != std::numeric_limits<unsigned>::max() && content_size >= data().threshold && content_size <= SEGMENT_LIMIT && !data().inflater.active() &&
+          std::string( data().parser.value( "Accept-Ranges" ) ).find( "bytes" ) != std::string::npos )
       {
-        data().data.push_back( packet.payload()[ i ] ) ;
-        request_amt-- ;
+        // This response carries the first segment. The rest are fetched as ranges in parallel, straight into their place in the body.
+        data().data.resize( content_size ) ;
+        first = content_size / data().segments ;
+        data().segmented.start( data().url, validator, content_size, data().data.data(), first, content_size, data().segments - 1 ) ;
+        
+        amount = std::min( packet.size(), first ) ;
+        std::memcpy( data().data.data(), packet.payload(), amount ) ;
+        received += amount ;
+        
+        while( received < first )
+        {
+          request_amt = std::min( first - received, PACKET_SIZE ) ;
+          packet      = data().connection.recieve( request_amt ) ;
+          
+          if( packet.size() == 0 ) break ;
+          std::memcpy( data().data.data() + received, packet.payload(), packet.size() ) ;
+          received += packet.size() ;
+        }
+        
+        // The rest of this response is already being fetched by the ranges, so drop it instead of reading it.
+        data().connection.reset() ;
+        success = data().segmented.wait() ;
+        
+        // If this connection dropped before the first segment was done, fetch what's missing of it as a range too.
+        if( success && received < first )
+        {
+          data().segmented.start( data().url, validator, content_size, data().data.data(), received, first, 1 ) ;
+          success = data().segmented.wait() ;
+        }
+        
+        if( !success )
+        {
+          // Servers may ignore ranges even after advertising them, so fall back to a single download.
+          segments        = data().segments ;
+          data().segments = 1 ;
+          this->download( image_url ) ;
+          data().segments = segments ;
+          return ;
+        }
+        
+        complete = true ;
+      }
+      else
+      {
+        amount    = std::min( packet.size(), content_size ) ;
+        received += amount ;
+        data().append( packet.payload(), amount ) ;
+        
+        // Now, keep requesting until we've gotten all our data. A dropped connection picks up where it left off instead of starting over.
+        while( received < content_size )
+        {
+          request_amt = std::min( content_size - received, PACKET_SIZE ) ;
+          packet      = data().connection.recieve( request_amt ) ;
+          
+          if( packet.size() == 0 )
+          {
+            if( content_size == std::numeric_limits<unsigned>::max() || attempts++ == RESUME_ATTEMPTS || !data().resume( received, validator, packet ) ) break ;
+          }
+          
+          amount    = std::min( packet.size(), content_size - received ) ;
+          received += amount ;
+          data().append( packet.payload(), amount ) ;
+        }
+        
+        // A body ended by the server closing can't be told from a dropped connection, unless it's compressed stream ended.
+        complete = received == content_size || ( content_size == std::numeric_limits<unsigned>::max() && data().inflater.done() ) ;
       }
     }
     
-    // Now we have the .png/jpeg/whatever data, use STB to generate raw bytes * channels from it.
-    bytes = stbi_load_from_memory( data().data.data(), data().data.size(), &width, &height, &chan, 4 ) ;
+    // Only bodies known to be whole are kept, so a cut off or corrupt one is fetched again next time instead of served.
+    if( data().inflater.active() ) complete = complete && data().inflater.done() && data().inflater.valid() ;
     
-    if( bytes != nullptr )
+    if( data().parser.status() == 200 && complete )
     {
-      data().data = ImageDownloaderData::ImageData( bytes, bytes + ( width * height * 4 ) ) ;
-      free ( bytes ) ;
+      data().cache.store( key, data().parser, data().data.data(), data().data.size() ) ;
+      data().disk .store( key, data().parser, data().data.data(), data().data.size() ) ;
     }
-    else
+    
+    // Now we have the .png/jpeg/whatever data, decode it. What it was served as only matters for images without a signature.
+    data().decode( data().data.data(), data().data.size(), decoders::type( data().parser.value( "Content-Type" ) ) ) ;
+  }
+  
+  ImageInfo ImageDownloader::probe( const char* image_url )
+  {
+    ProbeSink        sink   ;
+    std::string      range  ;
+    std::string_view key    ;
+    unsigned         status ;
+    
+    status = 0 ;
+    
+    // A pooled decode may still be reading a cached body that the lookups below could evict.
+    data().finish() ;
+    
+    // A fresh response already at hand answers without touching the network.
+    key = std::string_view( image_url, std::strcspn( image_url, "#" ) ) ;
+    if( data().cache.find( key ) && data().cache.fresh() )
+    {
+      sink.info.probe( data().cache.body(), data().cache.size() ) ;
+      return sink.info ;
+    }
+    
+    if( data().disk.find( key ) && data().disk.body() != nullptr && data().disk.fresh() )
     {
-      ygg::Yggdrasil::addError( Yggdrasil::Error::RecieveFailure ) ;
+      sink.info.probe( data().disk.body(), data().disk.size() ) ;
+      return sink.info ;
     }
     
-    data().width    = static_cast<unsigned>( width  ) ;
-    data().height   = static_cast<unsigned>( height ) ;
-    data().channels = static_cast<unsigned>( 4      ) ;
-   }
+    // Each range carries on from the last one, in case the header lies further in than first asked for.
+    for( std::size_t size = PROBE_BYTES; size <= PROBE_LIMIT; size *= 4 )
+    {
+      range  = "bytes=" ;
+      range += std::to_string( sink.bytes.size() ) ;
+      range += '-' ;
+      range += std::to_string( size - 1 ) ;
+      
+      data().client.setHeader( "Range", range.c_str() ) ;
+      data().client.get( image_url, sink ) ;
+      
+      status = data().client.status() ;
+      if( sink.info.valid() || status != 206 || sink.bytes.size() < size ) break ;
+    }
+    
+    // Without a status the server was never reached, & that was already reported.
+    if( !sink.info.valid() && status != 0 )
+    {
+      ygg::Yggdrasil::addError( status == 200 || status == 206 ? Yggdrasil::Error::InvalidImage : Yggdrasil::Error::InvalidStatus ) ;
+    }
+    
+    return sink.info ;
+  }
+  
+  void ImageDownloader::setCacheSize( std::size_t bytes )
+  {
+    data().finish() ;
+    data().cache.setBudget( bytes ) ;
+  }
+  
+  bool ImageDownloader::setDiskCache( const char* directory, std::size_t bytes )
+  {
+    data().finish() ;
+    return data().disk.open( directory, bytes ) ;
+  }
+  
+  void ImageDownloader::setSegments( unsigned count, std::size_t threshold )
+  {
+    data().segments  = std::max( 1u, count ) ;
+    data().threshold = threshold ;
+  }
+  
+  void ImageDownloader::setDecodePool( DecodePool* pool )
+  {
+    data().finish() ;
+    data().decoders = pool ;
+  }
+  
+  void ImageDownloader::setChannels( unsigned amount )
+  {
+    data().options.format = pixels::standard( std::min( 4u, amount ) ) ;
+  }
+  
+  void ImageDownloader::setFormat( PixelFormat format )
+  {
+    data().options.format = format ;
+  }
+  
+  void ImageDownloader::setMaxSize( unsigned width, unsigned height )
+  {
+    data().options.max_width  = width  ;
+    data().options.max_height = height ;
+  }
+  
+  void ImageDownloader::setCompression( bool value )
+  {
+    data().request.setHeader( "Accept-Encoding", value ? http::Decompressor::acceptEncoding() : "" ) ;
+  }
   
   unsigned ImageDownloader::width() const
   {
-    return data().width ;
+    data().finish() ;
+    return data().image.width() ;
   }
   
   unsigned ImageDownloader::height() const
   {
-    return data().height ;
+    data().finish() ;
+    return data().image.height() ;
   }
   
   unsigned ImageDownloader::channels() const
   {
-    return data().channels ;
+    data().finish() ;
+    return data().image.channels() ;
+  }
+  
+  PixelFormat ImageDownloader::format() const
+  {
+    data().finish() ;
+    return data().image.format() ;
+  }
+  
+  unsigned ImageDownloader::sourceChannels() const
+  {
+    data().finish() ;
+    return data().image.sourceChannels() ;
   }
   
   const unsigned char* ImageDownloader::image() const
   {
-    return data().data.data() ;
+    data().finish() ;
+    return data().image.pixels() ;
   }
   
   ImageDownloaderData& ImageDownloader::data()
@@ -25,8 +25,13 @@
 #ifndef YGGDRASIL_IMAGE_DOWNLOAD_H
 #define YGGDRASIL_IMAGE_DOWNLOAD_H
 
+#include "Image.h"
+#include <cstddef>
+
 namespace ygg
 {
+  class DecodePool ;
+
   /** Class to download an image from an HTTP/HTTPS webserver.
    */
   class ImageDownloader
@@ -42,10 +47,69 @@ namespace ygg
       ~ImageDownloader() ;
       
       /** Method to download the image.
+       * @note With a decode pool set, this returns once the body is received & the image decodes in the background.
        * @param image_url The URL associated with the image.
        */
       void download( const char* image_url ) ;
       
+      /** Method to find the dimensions & format of an image without downloading or decoding all of it.
+       * @note Only the first few KB are requested. Servers ignoring the range have their connection closed as soon as the header is read.
+       * @param image_url The URL associated with the image.
+       * @return The description of the image. Empty if it could not be read.
+       */
+      ImageInfo probe( const char* image_url ) ;
+      
+      /** Method to set whether or not to ask the server to compress the response body with gzip/deflate.
+       * @note Most image formats are already compressed, so this is off by default.
+       * @param value Whether or not to request a compressed body.
+       */
+      void setCompression( bool value ) ;
+      
+      /** Method to set how much memory to keep earlier responses in, so repeated downloads of the same URL are answered locally.
+       * @note Responses are kept as long as the server's Cache-Control, Expires & Last-Modified headers allow, and revalidated after.
+       * @param bytes The maximum amount of bytes of cached responses. 0 disables the cache.
+       */
+      void setCacheSize( std::size_t bytes ) ;
+      
+      /** Method to keep responses in a directory as well, so they are reused across runs. Disk hits are memory-mapped & decoded in place.
+       * @param directory The C-string path of the directory to keep responses in. It is created if needed.
+       * @param bytes The maximum amount of bytes of responses to keep on disk.
+       * @return Whether or not the directory could be used.
+       */
+      bool setDiskCache( const char* directory, std::size_t bytes ) ;
+      
+      /** Method to split large bodies into byte ranges fetched in parallel over separate connections.
+       * @note Only used when the server advertises byte ranges & the body is not compressed. Off by default.
+       * @param count The amount of connections to fetch a body over. 1 disables segmenting.
+       * @param threshold The minimum size in bytes of a body worth segmenting.
+       */
+      void setSegments( unsigned count, std::size_t threshold ) ;
+      
+      /** Method to decode images on a pool of decoding threads instead of the thread downloading them.
+       * @note The image accessors wait for a decode in progress. The pool must outlive this object, or be unset first.
+       * @param pool The pool to queue decodes on. nullptr decodes on the downloading thread, the default.
+       */
+      void setDecodePool( DecodePool* pool ) ;
+      
+      /** Method to set the amount of channels images are decoded to.
+       * @note Asking for fewer channels than RGBA shrinks the decoded image, e.g. to a quarter for grey thumbnails.
+       * @param amount 1 grey, 2 grey-alpha, 3 RGB or 4 RGBA, the default. 0 keeps the channels of each source image.
+       */
+      void setChannels( unsigned amount ) ;
+      
+      /** Method to set the format images are decoded to, so they can be handed on without converting them again.
+       * @note Replaces whatever ImageDownloader::setChannels() set, & the other way round. Reordering & premultiplying happen as each row of a JPEG is decoded.
+       * @param format The format to decode to, e.g. PixelFormat::Bgra for Windows & Vulkan surfaces. PixelFormat::Rgba by default.
+       */
+      void setFormat( PixelFormat format ) ;
+      
+      /** Method to set the largest size images are decoded at, shrinking larger ones to fit while keeping their aspect ratio.
+       * @note JPEGs are shrunk inside the decoder, so a thumbnail of a large photo costs a fraction of the time & memory of the full image.
+       * @param width The widest a decoded image may be. 0 for no limit, the default.
+       * @param height The tallest a decoded image may be. 0 for no limit, the default.
+       */
+      void setMaxSize( unsigned width, unsigned height ) ;
+      
       /** Method to retrieve the width of the input image.
        * @return The image width in pixels.
        */
@@ -60,9 +124,19 @@ namespace ygg
        * @return The amount of channels ( R, RG, RGB, RGBA ) of this image.
        */
       unsigned channels() const ;
+      
+      /** Method to retrieve the format of the downloaded image's pixels.
+       * @return The layout of each pixel, as set by ImageDownloader::setFormat() or ImageDownloader::setChannels().
+       */
+      PixelFormat format() const ;
+      
+      /** Method to retrieve the number of channels the downloaded image was encoded with.
+       * @return The amount of channels of the source image, before any conversion.
+       */
+      unsigned sourceChannels() const ;
 
       /** Method to retrieve the bytes associated with the image.
-       * @note The image is default in RGB/RGBA with each channel being represented by a single byte.
+       * @note The image is in the format ImageDownloader::setFormat() or ImageDownloader::setChannels() asked for, RGBA by default, with each channel being represented by a single byte.
        * @return The byte data of the downloaded image.
        */
       const unsigned char* image() const ;
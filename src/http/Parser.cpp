@@ -25,6 +25,9 @@
 #include "Parser.h"
 #include <ygg/Connection.h>
 #include <map>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -52,44 +55,55 @@ namespace ygg
      */
     static std::string getValue( std::stringstream& stream ) ;
     
+    /** Comparator to order header keys without regard to case, as HTTP header names are case-insensitive.
+     */
+    struct CaseInsensitiveLess
+    {
+      bool operator()( const std::string& first, const std::string& second ) const ;
+    };
+    
     /** Data structure to contain a http parser's data.
      */
     struct ParserData
     {
-      using HeaderTokenMap = std::map<std::string, std::string> ;
+      using HeaderTokenMap = std::map<std::string, std::string, CaseInsensitiveLess> ;
       
       HeaderTokenMap    map           ;
-      std::stringstream header_stream ;
+      std::string       header        ;
       std::string       version       ;
       std::string       command       ;
+      std::string       target        ;
       std::string       code_desc     ;
-      Packet            packet        ;
+      Packet            leftover      ;
       unsigned          code          ;
-      unsigned          offset        ;
-      unsigned          total_size    ;
-      const char*       body_ptr      ;
+      bool              parsed        ;
 
       ParserData() ;
       
       /** Method to parse the starting line of the HTTP message.
-       * @param data The data to parse.
-       * @return The index of the buffer to start reading the rest of the header data from.
+       * @param line The first line of the HTTP message, without the line break.
        */
-      unsigned parseStart( const char* data ) ;
+      void parseStart( const std::string& line ) ;
       
-      /** Helper function to parse the input HTTP data buffer.
-       * @param data The HTTP data buffer to parse.
+      /** Helper function to parse the accumulated HTTP header.
+       * @param end The index in the accumulated header of the blank line ending the header.
        */
-      void parse() ;
+      void parse( std::size_t end ) ;
     };
 
+    bool CaseInsensitiveLess::operator()( const std::string& first, const std::string& second ) const
+    {
+      return std::lexicographical_compare( first.begin(), first.end(), second.begin(), second.end(), 
+        []( unsigned char a, unsigned char b ) { return std::tolower( a ) < std::tolower( b ) ; } ) ;
+    }
+
     std::string getKey( std::stringstream& instream )
     {
       std::stringstream stream ;
       char              val    ;
       
       val = '\0' ;
-      while( !instream.eof() && ( val = instream.get() ) != instream.eof() && val != '\r' && val != '\n' && val != ':' )
+      while( instream.get( val ) && val != '\r' && val != '\n' && val != ':' )
       {
         stream << val ;
       }
@@ -103,7 +117,7 @@ namespace ygg
       char              val    ;
       
       val = '\0' ;
-      while( !instream.eof() && ( val = instream.get() ) != instream.eof() && val != '\r' && val != '\n' )
+      while( instream.get( val ) && val != '\r' && val != '\n' )
       {
         stream << val ;
       }
@@ -117,113 +131,78 @@ namespace ygg
 
       val = '\0' ;
       // While not eof, not whitespace, and not a line break.
-      while( !stream.eof() && ( val = stream.get() ) != stream.eof() && val != -1 && ( val == ' ' || val == '\n' || val == '\r' || val == '#' || val == ':' ) )
+      while( stream.get( val ) && ( val == ' ' || val == '\n' || val == '\r' || val == '#' || val == ':' ) )
       { 
         
       }
-      if( !stream.eof() )
+      if( stream )
       stream.putback( val ) ;
       return val ;
     }
     
     ParserData::ParserData()
     {
-      this->version    = "" ;
-      this->command    = "" ;
-      this->code_desc  = "" ;
-      this->code       = 0  ;
-      this->offset     = 0  ;
-      this->total_size = 0  ;
+      this->version    = ""    ;
+      this->command    = ""    ;
+      this->target     = ""    ;
+      this->code_desc  = ""    ;
+      this->code       = 0     ;
+      this->parsed     = false ;
     }
 
-    unsigned ParserData::parseStart( const char* data )
+    void ParserData::parseStart( const std::string& line )
     {
-      std::stringstream stream  ;
-      char              token   ;
+      std::stringstream stream( line ) ;
+      std::string       first          ;
+      std::string       second         ;
       
-      while( ( token = data[ this->offset ] ) != '\r' && token != '\n' && token != '\0' )
-      {
-        if( token == ' ' && this->offset != 0 )
-        {
-          if( stream.str() == std::string( "HTTP/1.1" ) )
-          {
-            this->version = stream.str() ;
-            stream.str( std::string() ) ;
-          }
-          else if( isdigit( stream.str().at( 0 ) ) && this->version != std::string( "" ) )
-          {
-            this->code = std::atoi( stream.str().c_str() ) ;
-            stream.str( std::string() ) ;
-          }
-          else if( this->version != std::string( "" ) )
-          {
-            this->code_desc = stream.str() ;
-            stream.str( std::string() ) ;
-          }
-          else
-          {
-            this->command = stream.str() ;
-            stream.str( std::string() ) ;
-          }
-        }
-        else
-        {
-          stream << token ;
-        }
-        
-        this->offset++ ;
-      }
+      stream >> first >> second ;
+      std::getline( stream >> std::ws, this->code_desc ) ;
       
-      if( this->version != std::string( "" ) )
+      // A response starts with the version, a request ends with it.
+      if( first.compare( 0, 5, "HTTP/" ) == 0 )
       {
-        this->code_desc = stream.str() ;
+        this->version = first ;
+        this->code    = static_cast<unsigned>( std::atoi( second.c_str() ) ) ;
       }
       else
       {
-        this->command = stream.str() ;
+        this->command   = first           ;
+        this->target    = second          ;
+        this->version   = this->code_desc ;
+        this->code_desc = ""              ;
       }
-      
-      this->body_ptr  = data         ;
-      this->body_ptr += this->offset ;
-      return offset ;
     }
     
-    void ParserData::parse()
+    void ParserData::parse( std::size_t end )
     {
       std::stringstream header    ;
       std::stringstream stream    ;
       std::string       line      ;
       std::string       key       ;
       std::string       value     ;
-      bool              in_header ;
-      unsigned          index     ;
 
-      header << this->body_ptr ;
-      std::size_t pos = header.str().find( "\r\n\r\n") ;
-      in_header = true ;
-      index     = 0    ;
-      while( std::getline( header, line ) && in_header )
+      header.str( this->header.substr( 0, end + 2 ) ) ;
+      std::getline( header, line ) ;
+      this->parseStart( line.substr( 0, line.find( '\r' ) ) ) ;
+      
+      while( std::getline( header, line ) )
       {
         stream.clear() ;
-        stream.str( std::string() ) ;
-        stream << line ;
+        stream.str( line ) ;
 
         // Trim off any leftover invalid characters.
         key   = getKey( stream ) ;
         getNextValidCharacter( stream ) ;
         value = getValue( stream ) ;
         
-        this->map[ key ] = value ;
-        
-        index += line.size() + 1 ;
-        if( index > pos )
-        {
-          in_header      = false                   ;
-          this->offset   = this->offset + pos + 4  ;
-          this->body_ptr = ( this->packet.payload() + this->offset ) ;
-          return ;
-        }
+        if( !key.empty() ) this->map[ key ] = value ;
       }
+      
+      // Whatever came after the blank line belongs to the body, or even the next message.
+      this->leftover = ygg::makePacket( this->header.data() + end + 4, static_cast<unsigned>( this->header.size() - end - 4 ) ) ;
+      this->parsed   = true ;
+      this->header.clear() ;
     }
 
     Parser::Parser()
@@ -238,34 +217,43 @@ namespace ygg
     
     void Parser::parse( const ygg::Packet& packet )
     {
-      const std::string line = packet.payload()       ;
-      const std::size_t pos  = line.find( "\r\n\r\n") ;
+      std::size_t start ;
+      std::size_t pos   ;
+      
+      if( data().parsed ) return ;
+      
+      // The terminator may straddle packets, so search from just before the new data.
+      start = data().header.size() > 3 ? data().header.size() - 3 : 0 ;
+      data().header.append( packet.payload(), packet.size() ) ;
+      pos = data().header.find( "\r\n\r\n", start ) ;
       
-      data().packet = packet ;
-      data().header_stream << line ;
       if( pos != std::string::npos )
       {
-        const auto string = data().header_stream.str() ;
-        data().parseStart( string.c_str() ) ;
-        data().parse     () ;
-        data().total_size = packet.size() ;
-        data().header_stream.str( std::string() ) ; 
+        data().parse( pos ) ;
       }
     }
     
     void Parser::reset()
     {
-      data().version   = "" ;
-      data().command   = "" ;
-      data().code_desc = "" ;
-      data().code      = 0  ;
-      data().offset    = 0  ;
+      data().version   = ""    ;
+      data().command   = ""    ;
+      data().target    = ""    ;
+      data().code_desc = ""    ;
+      data().code      = 0     ;
+      data().parsed    = false ;
+      data().leftover  = ygg::Packet() ;
+      data().header.clear() ;
       data().map.clear() ;
     }
 
     bool Parser::parsed() const
     {
-      return data().offset != 0 ;
+      return data().parsed ;
+    }
+    
+    unsigned Parser::status() const
+    {
+      return data().code ;
     }
 
     const char* Parser::value( const char* key ) const
@@ -279,10 +267,7 @@ namespace ygg
     
     ygg::Packet Parser::leftover() const
     {
-      ygg::Packet packet ;
-        
-      packet = ygg::makePacket( data().body_ptr, data().total_size - data().offset ) ;
-      return packet ;
+      return data().leftover ;
     }
     
     ParserData& Parser::data()
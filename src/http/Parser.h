@@ -47,8 +47,8 @@ namespace ygg
          */
         ~Parser() ;
         
-        /** Method to initialize this object.
-         * @param data The input HTTP data block to parse.
+        /** Method to parse the next block of an HTTP message. The header may span any number of blocks.
+         * @param packet The input HTTP data block to parse.
          */
         void parse( const ygg::Packet& packet ) ;
         
@@ -63,6 +63,11 @@ namespace ygg
          */
         bool parsed() const ;
         
+        /** Method to retrieve the status code of a parsed HTTP response.
+         * @return The status code of the response, or 0 if this was not a response.
+         */
+        unsigned status() const ;
+        
         /** Method to reset this object and clear all parsed data.
          */
         void reset() ;
@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pipeline.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on January 27, 2021, 9:02 PM
+ */
+
+#include "Pipeline.h"
+#include "Parser.h"
+#include "Chunked.h"
+#include "Request.h"
+#include <ygg/Yggdrasil.h>
+#include <ygg/Connection.h>
+#ifdef _WIN32
+  #include <win32/Win32.h>
+  using Impl = ygg::win32::Win32 ;
+#elif __linux__
+  #include <linux/Linux.h>
+  using Impl = ygg::lx::Linux ;
+#endif
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The default amount of requests allowed on the wire at once.
+     */
+    static const unsigned DEFAULT_DEPTH = 8 ;
+
+    /** Structure to contain a pipeline's data.
+     */
+    struct PipelineData
+    {
+      using Body    = std::vector<unsigned char> ;
+      using Targets = std::deque<std::string>    ;
+
+      ygg::Connection<Impl> connection ; ///< The connection every request is made over.
+      Parser                parser     ; ///< The parser for each response header.
+      ChunkedDecoder        decoder    ; ///< The decoder for chunked response bodies.
+      Request               request    ; ///< The builder of the requests to send.
+      Packet                pending    ; ///< Received bytes that have not been claimed by a response yet.
+      Body                  body       ; ///< The body of the current response.
+      Targets               targets    ; ///< The targets of every unanswered request, oldest first.
+      std::string           host       ; ///< The host every request is made to.
+      unsigned              port       ; ///< The port to connect to.
+      unsigned              depth      ; ///< The maximum amount of requests on the wire.
+      unsigned              limit      ; ///< The depth in use for the current host, lowered if the host fails to pipeline.
+      unsigned              sent       ; ///< How many of the oldest targets have been sent on the current connection.
+      unsigned              answered   ; ///< The amount of responses read so far.
+      unsigned              index      ; ///< The request index of the current response.
+      unsigned              status     ; ///< The status code of the current response.
+      bool                  connected  ; ///< Whether or not the connection is open.
+      bool                  closing    ; ///< Whether or not the server will close after the current response.
+
+      /** Default constructor.
+       */
+      PipelineData() ;
+
+      /** Method to send every queued request that fits within the pipeline depth.
+       */
+      void flush() ;
+
+      /** Method to make sure there are unclaimed bytes available, recieving more if needed.
+       * @return Whether or not bytes are available. False if the connection closed.
+       */
+      bool fill() ;
+
+      /** Method to claim bytes from the front of the pending data.
+       * @param amount The amount of bytes claimed.
+       */
+      void claim( unsigned amount ) ;
+
+      /** Method to read one whole response from the connection.
+       * @return Whether or not the response was read. False if the connection dropped first.
+       */
+      bool read() ;
+
+      /** Method to close the connection, so that unanswered requests are resent on the next one.
+       */
+      void close() ;
+    };
+
+    PipelineData::PipelineData()
+    {
+      this->port      = 80            ;
+      this->depth     = DEFAULT_DEPTH ;
+      this->limit     = DEFAULT_DEPTH ;
+      this->sent      = 0             ;
+      this->answered  = 0             ;
+      this->index     = 0             ;
+      this->status    = 0             ;
+      this->connected = false         ;
+      this->closing   = false         ;
+    }
+
+    void PipelineData::flush()
+    {
+      const unsigned amount = std::min<unsigned>( this->limit, static_cast<unsigned>( this->targets.size() ) ) ;
+
+      if( this->sent >= amount ) return ;
+
+      if( !this->connected )
+      {
+        this->connection.connect( this->host.c_str(), ygg::ConnectionType::Client, this->port ) ;
+        this->connected = true ;
+        this->sent      = 0    ;
+      }
+
+      // Every request that fits is written in one send, so they leave in as few segments as possible.
+      this->request.setHost( this->host ) ;
+      this->request.clear() ;
+      for( ; this->sent < amount; this->sent++ )
+      {
+        this->request.begin( "GET", this->targets[ this->sent ] ) ;
+        this->request.end() ;
+      }
+
+      this->connection.send( this->request.payload(), this->request.size() ) ;
+    }
+
+    bool PipelineData::fill()
+    {
+      if( this->pending.size() != 0 ) return true ;
+      if( !this->connected          ) return false ;
+
+      this->pending = this->connection.recieve() ;
+      return this->pending.size() != 0 ;
+    }
+
+    void PipelineData::claim( unsigned amount )
+    {
+      this->pending = ygg::makePacket( this->pending.payload() + amount, this->pending.size() - amount ) ;
+    }
+
+    bool PipelineData::read()
+    {
+      std::size_t offset       ;
+      const char* length       ;
+      unsigned    content_size ;
+      unsigned    amount       ;
+
+      this->body.clear() ;
+
+      // Parse the header, skipping any informational responses.
+      do
+      {
+        this->parser.reset() ;
+        while( !this->parser.parsed() )
+        {
+          if( !this->fill() ) return false ;
+          this->parser.parse( this->pending ) ;
+          this->pending = ygg::Packet() ;
+        }
+
+        this->pending = this->parser.leftover() ;
+        this->status  = this->parser.status()   ;
+      } while( this->status >= 100 && this->status < 200 ) ;
+
+      this->closing = std::string( this->parser.value( "Connection" ) ).find( "close" ) != std::string::npos ;
+      length        = this->parser.value( "Content-Length" ) ;
+
+      if( this->status == 204 || this->status == 304 )
+      {
+        return true ;
+      }
+
+      if( std::string( this->parser.value( "Transfer-Encoding" ) ).find( "chunked" ) != std::string::npos )
+      {
+        this->decoder.reset() ;
+        while( true )
+        {
+          if( !this->fill() ) return false ;
+
+          offset = this->body.size() ;
+          this->body.resize( offset + this->pending.size() ) ;
+          this->body.resize( offset + this->decoder.decode( this->pending.payload(), this->pending.size(), reinterpret_cast<char*>( this->body.data() + offset ) ) ) ;
+          this->claim( this->decoder.consumed() ) ;
+
+          if( this->decoder.done()   ) return true  ;
+          if( !this->decoder.valid() ) return false ;
+        }
+      }
+
+      if( length[ 0 ] != '\0' )
+      {
+        content_size = static_cast<unsigned>( std::strtoul( length, nullptr, 10 ) ) ;
+        this->body.reserve( content_size ) ;
+        while( this->body.size() < content_size )
+        {
+          if( !this->fill() ) return false ;
+
+          amount = std::min( content_size - static_cast<unsigned>( this->body.size() ), this->pending.size() ) ;
+          this->body.insert( this->body.end(), this->pending.payload(), this->pending.payload() + amount ) ;
+          this->claim( amount ) ;
+        }
+
+        return true ;
+      }
+
+      // Without any framing the body runs until the server closes, which also ends the pipeline.
+      while( this->fill() )
+      {
+        this->body.insert( this->body.end(), this->pending.payload(), this->pending.payload() + this->pending.size() ) ;
+        this->pending = ygg::Packet() ;
+      }
+
+      this->closing = true ;
+      return true ;
+    }
+
+    void PipelineData::close()
+    {
+      this->connection.reset() ;
+      this->pending   = ygg::Packet() ;
+      this->connected = false ;
+      this->sent      = 0     ;
+    }
+
+    Pipeline::Pipeline()
+    {
+      this->pipeline_data = new PipelineData() ;
+    }
+
+    Pipeline::~Pipeline()
+    {
+      data().close() ;
+      delete this->pipeline_data ;
+    }
+
+    void Pipeline::connect( const char* host, unsigned port )
+    {
+      this->reset() ;
+      data().host  = host         ;
+      data().port  = port         ;
+      data().limit = data().depth ;
+    }
+
+    void Pipeline::setDepth( unsigned depth )
+    {
+      data().depth = std::max( depth, 1u ) ;
+      data().limit = data().depth          ;
+    }
+
+    unsigned Pipeline::get( const char* target )
+    {
+      data().targets.emplace_back( target ) ;
+
+      return data().answered + static_cast<unsigned>( data().targets.size() ) - 1 ;
+    }
+
+    bool Pipeline::next()
+    {
+      bool success ;
+
+      if( data().targets.empty() ) return false ;
+
+      success = false ;
+      for( unsigned attempt = 0; attempt < 2 && !success; attempt++ )
+      {
+        data().flush() ;
+        success = data().read() ;
+
+        if( !success )
+        {
+          // The server dropped the connection with requests in flight, so it may not handle pipelining. Resend them one at a time.
+          data().close() ;
+          data().limit = 1 ;
+        }
+      }
+
+      if( !success )
+      {
+        ygg::Yggdrasil::addError( Yggdrasil::Error::ConnectionFailure ) ;
+        data().status = 0 ;
+        data().body.clear() ;
+      }
+
+      data().index = data().answered++ ;
+      data().targets.pop_front() ;
+      if( data().sent > 0 ) data().sent-- ;
+
+      // Requests that went out after a 'Connection: close' response will never be answered on this connection.
+      if( data().closing ) data().close() ;
+
+      return true ;
+    }
+
+    unsigned Pipeline::pending() const
+    {
+      return static_cast<unsigned>( data().targets.size() ) ;
+    }
+
+    unsigned Pipeline::index() const
+    {
+      return data().index ;
+    }
+
+    unsigned Pipeline::status() const
+    {
+      return data().status ;
+    }
+
+    const char* Pipeline::value( const char* key ) const
+    {
+      return data().parser.value( key ) ;
+    }
+
+    const unsigned char* Pipeline::body() const
+    {
+      return data().body.data() ;
+    }
+
+    unsigned Pipeline::size() const
+    {
+      return static_cast<unsigned>( data().body.size() ) ;
+    }
+
+    void Pipeline::reset()
+    {
+      data().close() ;
+      data().targets.clear() ;
+      data().body.clear() ;
+      data().answered = 0     ;
+      data().index    = 0     ;
+      data().status   = 0     ;
+      data().closing  = false ;
+    }
+
+    PipelineData& Pipeline::data()
+    {
+      return *this->pipeline_data ;
+    }
+
+    const PipelineData& Pipeline::data() const
+    {
+      return *this->pipeline_data ;
+    }
+  }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pipeline.h
+ * Author: Jordan Hendl
+ *
+ * Created on January 27, 2021, 9:02 PM
+ */
+
+#ifndef YGGDRASIL_PIPELINE_H
+#define YGGDRASIL_PIPELINE_H
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to pipeline many HTTP/1.1 GET requests over a single connection to one host.
+     * Requests are written back-to-back without waiting for responses, and responses are read back in the order they were requested.
+     * If the server closes the connection, any unanswered requests are resent on a new connection without pipelining.
+     */
+    class Pipeline
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Pipeline() ;
+
+        /** Default deconstructor.
+         */
+        ~Pipeline() ;
+
+        /** Method to set the host that all requests of this pipeline are made to.
+         * @note This drops any queued requests & the current connection.
+         * @param host The C-string host name to connect to.
+         * @param port The port to connect on.
+         */
+        void connect( const char* host, unsigned port = 80 ) ;
+
+        /** Method to set the maximum amount of requests allowed on the wire without a response.
+         * @param depth The maximum amount of outstanding requests. Clamped to at least 1.
+         */
+        void setDepth( unsigned depth ) ;
+
+        /** Method to queue a GET request of the given target.
+         * @param target The C-string path & query to request from the host.
+         * @return The index of the request, which is the index the matching response will report.
+         */
+        unsigned get( const char* target ) ;
+
+        /** Method to read the response to the oldest unanswered request, sending queued requests as needed.
+         * @note If the request could not be completed, the response has a status of 0 and no body.
+         * @return Whether or not a response was read. False when there are no requests left to answer.
+         */
+        bool next() ;
+
+        /** Method to retrieve the amount of requests that have not been answered yet.
+         * @return The amount of queued or outstanding requests.
+         */
+        unsigned pending() const ;
+
+        /** Method to retrieve which request the current response answers.
+         * @return The index of the request returned by Pipeline::get().
+         */
+        unsigned index() const ;
+
+        /** Method to retrieve the status code of the current response.
+         * @return The HTTP status code of the current response.
+         */
+        unsigned status() const ;
+
+        /** Method to retrieve the value of a header of the current response.
+         * @param key The header name to look up.
+         * @return The value of the header, or an empty string if it was not sent.
+         */
+        const char* value( const char* key ) const ;
+
+        /** Method to retrieve the body of the current response.
+         * @note This is only valid until the next call to Pipeline::next().
+         * @return The pointer to the start of the body bytes.
+         */
+        const unsigned char* body() const ;
+
+        /** Method to retrieve the size of the body of the current response.
+         * @return The amount of bytes in the body.
+         */
+        unsigned size() const ;
+
+        /** Method to reset this object, closing the connection & dropping all requests.
+         */
+        void reset() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct PipelineData *pipeline_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        PipelineData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const PipelineData& data() const ;
+    };
+  }
+}
+
+#endif /* PIPELINE_H */
+
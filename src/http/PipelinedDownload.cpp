@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   PipelinedDownload.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 16, 2021, 7:15 PM
+ */
+
+#include "PipelinedDownload.h"
+#include "Image.h"
+#include "Client.h"
+#include "Response.h"
+#include "Queue.h"
+
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+namespace ygg
+{
+  /** The default amount of images in the pipeline at once.
+   */
+  static const unsigned DEFAULT_DEPTH = 4 ;
+
+  /** The amount of times a stage yields on an empty or full queue before it starts sleeping.
+   */
+  static const unsigned SPIN_LIMIT = 64 ;
+
+  /** Structure to carry one image through the pipeline. Slots are recycled, so their buffers are reused between images.
+   */
+  struct Slot
+  {
+    std::size_t    index    ; ///< The index of the image's URL.
+    http::Response response ; ///< The response the body is received into.
+    Image          image    ; ///< The decoded image.
+    bool           fetched  ; ///< Whether or not the body was received successfully.
+  };
+
+  /** Structure to contain a pipelined downloader's data.
+   */
+  struct PipelinedDownloaderData
+  {
+    using Slots = std::unique_ptr<Slot[]> ;
+
+    http::Client client    ; ///< The client the receiving stage makes requests with.
+    Slots        slots     ; ///< The slots carried through the pipeline.
+    unsigned     allocated ; ///< The amount of slots allocated.
+    unsigned     depth     ; ///< The amount of slots to use.
+
+    /** Default constructor.
+     */
+    PipelinedDownloaderData() ;
+
+    /** Function to wait a moment on an empty or full queue, spinning at first & sleeping if the wait drags on.
+     * @param spins The amount of times this wait has already been retried. Incremented by this call.
+     */
+    static void backoff( unsigned& spins ) ;
+  };
+
+  PipelinedDownloaderData::PipelinedDownloaderData()
+  {
+    this->allocated = 0             ;
+    this->depth     = DEFAULT_DEPTH ;
+  }
+
+  void PipelinedDownloaderData::backoff( unsigned& spins )
+  {
+    // Network waits last milliseconds, so a stage starved for that long sleeps rather than burning a core.
+    if( spins++ < SPIN_LIMIT ) std::this_thread::yield() ;
+    else                       std::this_thread::sleep_for( std::chrono::microseconds( 100 ) ) ;
+  }
+
+  PipelinedDownloader::PipelinedDownloader()
+  {
+    this->pipelined_data = new PipelinedDownloaderData() ;
+  }
+
+  PipelinedDownloader::~PipelinedDownloader()
+  {
+    delete this->pipelined_data ;
+  }
+
+  void PipelinedDownloader::setDepth( unsigned depth )
+  {
+    data().depth = std::max( 2u, depth ) ;
+  }
+
+  void PipelinedDownloader::download( const char* const* urls, std::size_t count, Callback callback, void* user )
+  {
+    Slot*    slot  ;
+    unsigned spins ;
+
+    if( count == 0 ) return ;
+
+    if( data().allocated != data().depth )
+    {
+      data().slots.reset( new Slot[ data().depth ] ) ;
+      data().allocated = data().depth ;
+    }
+
+    // Slots go round from receiving, to decoding, to the callback & back, so no stage ever allocates.
+    http::Queue<Slot*> available( data().depth ) ;
+    http::Queue<Slot*> received ( data().depth ) ;
+    http::Queue<Slot*> decoded  ( data().depth ) ;
+
+    for( unsigned index = 0; index < data().depth; index++ ) available.push( &data().slots[ index ] ) ;
+
+    std::thread receiver( [&]()
+    {
+      Slot*    slot  ;
+      unsigned spins ;
+
+      for( std::size_t index = 0; index < count; index++ )
+      {
+        for( spins = 0; !available.pop( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+
+        slot->index   = index ;
+        slot->fetched = data().client.get( urls[ index ], slot->response ) && slot->response.status() == 200 ;
+
+        for( spins = 0; !received.push( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+      }
+    } ) ;
+
+    std::thread decoder( [&]()
+    {
+      Slot*    slot  ;
+      unsigned spins ;
+
+      for( std::size_t index = 0; index < count; index++ )
+      {
+        for( spins = 0; !received.pop( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+
+        if( slot->fetched ) slot->image.decode( slot->response.body(), slot->response.size() ) ;
+        else                slot->image.clear() ;
+
+        for( spins = 0; !decoded.push( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+      }
+    } ) ;
+
+    for( std::size_t index = 0; index < count; index++ )
+    {
+      for( spins = 0; !decoded.pop( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+
+      callback( slot->index, slot->image, user ) ;
+
+      for( spins = 0; !available.push( slot ); ) PipelinedDownloaderData::backoff( spins ) ;
+    }
+
+    receiver.join() ;
+    decoder .join() ;
+  }
+
+  PipelinedDownloaderData& PipelinedDownloader::data()
+  {
+    return *this->pipelined_data ;
+  }
+
+  const PipelinedDownloaderData& PipelinedDownloader::data() const
+  {
+    return *this->pipelined_data ;
+  }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   PipelinedDownload.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 16, 2021, 7:15 PM
+ */
+
+#ifndef YGGDRASIL_PIPELINED_DOWNLOAD_H
+#define YGGDRASIL_PIPELINED_DOWNLOAD_H
+
+#include <cstddef>
+
+namespace ygg
+{
+  class Image ;
+
+  /** Class to download a sequence of images with receiving & decoding overlapped.
+   * One thread receives bodies while another decodes them, joined by bounded lock-free queues, so the next image downloads while the last one decodes.
+   * A sequence takes roughly as long as the slower of the two stages, instead of both added together.
+   */
+  class PipelinedDownloader
+  {
+    public:
+
+      /** The function called with each image, in the order the URLs were given.
+       * @param index The index of the image's URL.
+       * @param image The decoded image. Empty if it could not be downloaded or decoded. Only valid for the duration of the call.
+       * @param user The pointer handed to PipelinedDownloader::download().
+       */
+      using Callback = void ( * )( std::size_t index, const Image& image, void* user ) ;
+
+      /** Default constructor.
+       */
+      PipelinedDownloader() ;
+
+      /** Default deconstructor.
+       */
+      ~PipelinedDownloader() ;
+
+      /** Method to set how many images may be in the pipeline at once, i.e. how far receiving may run ahead of decoding.
+       * @param depth The amount of images in flight. Clamped to at least 2.
+       */
+      void setDepth( unsigned depth ) ;
+
+      /** Method to download & decode a sequence of images.
+       * @note This blocks until the whole sequence is done. The callback is called on the calling thread.
+       * @param urls The C-string URLs of the images.
+       * @param count The amount of URLs.
+       * @param callback The function to call with each image.
+       * @param user The pointer handed to every call of the callback.
+       */
+      void download( const char* const* urls, std::size_t count, Callback callback, void* user = nullptr ) ;
+
+    private:
+
+      /** The forward declared structure containing this object's data.
+       */
+      struct PipelinedDownloaderData *pipelined_data ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      PipelinedDownloaderData& data() ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      const PipelinedDownloaderData& data() const ;
+  };
+}
+
+#endif /* PIPELINED_DOWNLOAD_H */
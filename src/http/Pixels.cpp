@@ -0,0 +1,828 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pixels.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 19, 2021, 9:40 AM
+ */
+
+#include "Pixels.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+  #include <emmintrin.h>
+  #define YGGDRASIL_PIXELS_SSE2
+#endif
+
+// Wider kernels are compiled for their own instruction sets & only run once the CPU is known to have them.
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( YGGDRASIL_PIXELS_SSE2 )
+  #include <immintrin.h>
+  #define YGGDRASIL_PIXELS_X86
+  #define YGGDRASIL_PIXELS_TARGET( name ) __attribute__( ( target( name ) ) )
+#endif
+
+#if defined( __ARM_NEON ) && defined( __aarch64__ )
+  #include <arm_neon.h>
+  #define YGGDRASIL_PIXELS_NEON
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+namespace ygg
+{
+  namespace pixels
+  {
+    /** The amount of pixels converted at a time when a conversion takes more than one step, so the second step finds them in cache.
+     */
+    static const std::size_t CHUNK = 256 ;
+
+    /** The weights of red, green & blue in luminance, out of 256. The same as the decoder's, so grey images match however they were made.
+     */
+    static const unsigned LUMA_RED   = 77  ;
+    static const unsigned LUMA_GREEN = 150 ;
+    static const unsigned LUMA_BLUE  = 29  ;
+
+    /** Function to divide a colour by it's alpha. Kernels compute exactly this, so every instruction set gives the same bytes.
+     * @param colour The premultiplied colour.
+     * @param alpha The alpha, above 0.
+     * @return The straight colour.
+     */
+    static inline unsigned char divide( unsigned char colour, unsigned char alpha )
+    {
+      return static_cast<unsigned char>( std::min( 255.0f, colour * 255.0f / alpha + 0.5f ) ) ;
+    }
+
+    /** Function to multiply a colour by it's alpha, rounding to the nearest.
+     * @param colour The straight colour.
+     * @param alpha The alpha.
+     * @return The premultiplied colour.
+     */
+    static inline unsigned char multiply( unsigned char colour, unsigned char alpha )
+    {
+      const unsigned product = colour * alpha + 128 ;
+
+      return static_cast<unsigned char>( ( product + ( product >> 8 ) ) >> 8 ) ;
+    }
+
+    #ifdef YGGDRASIL_PIXELS_X86
+      /** Function to retrieve whether or not the CPU has AVX2.
+       * @return Whether or not AVX2 kernels may run.
+       */
+      static bool hasAvx2()
+      {
+        static const bool value = __builtin_cpu_supports( "avx2" ) ;
+        return value ;
+      }
+
+      /** Function to retrieve whether or not the CPU has SSSE3, for byte shuffles.
+       * @return Whether or not SSSE3 kernels may run.
+       */
+      static bool hasSsse3()
+      {
+        static const bool value = __builtin_cpu_supports( "ssse3" ) ;
+        return value ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "avx2" ) static std::size_t swizzleAvx2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m256i order = _mm256_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 ) ;
+
+        for( ; index + 8 <= count; index += 8 )
+        {
+          const __m256i pixels = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( source + index * 4 ) ) ;
+          _mm256_storeu_si256( reinterpret_cast<__m256i*>( destination + index * 4 ), _mm256_shuffle_epi8( pixels, order ) ) ;
+        }
+
+        return index ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "avx2" ) static inline __m256i premultiplyAvx2( __m256i pixels )
+      {
+        const __m256i colour = _mm256_set1_epi64x( 0x0000FFFFFFFFFFFFll ) ;
+        const __m256i opaque = _mm256_set1_epi64x( 0x00FF000000000000ll ) ;
+        __m256i       alpha  ;
+        __m256i       scaled ;
+
+        // Each pixel's alpha is spread over it's colours, & it's own alpha is multiplied by 255 so it survives the division unchanged.
+        alpha  = _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( pixels, 0xFF ), 0xFF ) ;
+        alpha  = _mm256_or_si256( _mm256_and_si256( alpha, colour ), opaque ) ;
+        scaled = _mm256_add_epi16( _mm256_mullo_epi16( pixels, alpha ), _mm256_set1_epi16( 128 ) ) ;
+
+        return _mm256_srli_epi16( _mm256_add_epi16( scaled, _mm256_srli_epi16( scaled, 8 ) ), 8 ) ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "avx2" ) static std::size_t premultiplyAvx2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m256i zero = _mm256_setzero_si256() ;
+
+        for( ; index + 8 <= count; index += 8 )
+        {
+          const __m256i pixels = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( source + index * 4 ) ) ;
+          const __m256i low    = premultiplyAvx2( _mm256_unpacklo_epi8( pixels, zero ) ) ;
+          const __m256i high   = premultiplyAvx2( _mm256_unpackhi_epi8( pixels, zero ) ) ;
+
+          _mm256_storeu_si256( reinterpret_cast<__m256i*>( destination + index * 4 ), _mm256_packus_epi16( low, high ) ) ;
+        }
+
+        return index ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "avx2" ) static inline __m256i lumaAvx2( __m256i pixels, __m256i red, __m256i green, __m256i blue )
+      {
+        const __m256i mask = _mm256_set1_epi32( 0xFF ) ;
+        __m256i       sum  ;
+
+        // Every product fits 16 bits, so the 16 bit multiply of each 32 bit lane is exact.
+        sum = _mm256_mullo_epi16( _mm256_and_si256( pixels, mask ), red ) ;
+        sum = _mm256_add_epi32( sum, _mm256_mullo_epi16( _mm256_and_si256( _mm256_srli_epi32( pixels, 8  ), mask ), green ) ) ;
+        sum = _mm256_add_epi32( sum, _mm256_mullo_epi16( _mm256_and_si256( _mm256_srli_epi32( pixels, 16 ), mask ), blue  ) ) ;
+
+        return _mm256_srli_epi32( sum, 8 ) ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "avx2" ) static std::size_t lumaAvx2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        const __m256i red   = _mm256_set1_epi32( swap ? LUMA_BLUE : LUMA_RED  ) ;
+        const __m256i green = _mm256_set1_epi32( LUMA_GREEN                   ) ;
+        const __m256i blue  = _mm256_set1_epi32( swap ? LUMA_RED  : LUMA_BLUE ) ;
+        const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 ) ;
+
+        for( ; index + 32 <= count; index += 32 )
+        {
+          const __m256i* pixels = reinterpret_cast<const __m256i*>( source + index * 4 ) ;
+          const __m256i  first  = lumaAvx2( _mm256_loadu_si256( pixels     ), red, green, blue ) ;
+          const __m256i  second = lumaAvx2( _mm256_loadu_si256( pixels + 1 ), red, green, blue ) ;
+          const __m256i  third  = lumaAvx2( _mm256_loadu_si256( pixels + 2 ), red, green, blue ) ;
+          const __m256i  fourth = lumaAvx2( _mm256_loadu_si256( pixels + 3 ), red, green, blue ) ;
+          const __m256i  packed = _mm256_packus_epi16( _mm256_packs_epi32( first, second ), _mm256_packs_epi32( third, fourth ) ) ;
+
+          // Packing works within each 128 bit half, so the groups of 4 come out interleaved & are put back in order.
+          _mm256_storeu_si256( reinterpret_cast<__m256i*>( destination + index ), _mm256_permutevar8x32_epi32( packed, order ) ) ;
+        }
+
+        return index ;
+      }
+
+      /** Function to load 16 3 channel pixels as 4 registers of 4 pixels each, the top 4 bytes of each being left over.
+       */
+      YGGDRASIL_PIXELS_TARGET( "ssse3" ) static inline void load3Ssse3( const unsigned char* source, __m128i* pixels )
+      {
+        const __m128i first  = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source      ) ) ;
+        const __m128i second = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + 16 ) ) ;
+        const __m128i third  = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + 32 ) ) ;
+
+        pixels[ 0 ] = first                                ;
+        pixels[ 1 ] = _mm_alignr_epi8( second, first , 12 ) ;
+        pixels[ 2 ] = _mm_alignr_epi8( third , second, 8  ) ;
+        pixels[ 3 ] = _mm_srli_si128 ( third , 4          ) ;
+      }
+
+      /** Function to store 4 registers of 4 3 channel pixels each, packed into the low 12 bytes, as 16 pixels.
+       */
+      YGGDRASIL_PIXELS_TARGET( "ssse3" ) static inline void store3Ssse3( unsigned char* destination, const __m128i* pixels )
+      {
+        __m128i* out = reinterpret_cast<__m128i*>( destination ) ;
+
+        _mm_storeu_si128( out    , _mm_or_si128( pixels[ 0 ]                      , _mm_slli_si128( pixels[ 1 ], 12 ) ) ) ;
+        _mm_storeu_si128( out + 1, _mm_or_si128( _mm_srli_si128( pixels[ 1 ], 4 ) , _mm_slli_si128( pixels[ 2 ], 8  ) ) ) ;
+        _mm_storeu_si128( out + 2, _mm_or_si128( _mm_srli_si128( pixels[ 2 ], 8 ) , _mm_slli_si128( pixels[ 3 ], 4  ) ) ) ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "ssse3" ) static std::size_t swizzle3Ssse3( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m128i order = _mm_setr_epi8( 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1 ) ;
+        __m128i       pixels[ 4 ] ;
+
+        for( ; index + 16 <= count; index += 16 )
+        {
+          load3Ssse3( source + index * 3, pixels ) ;
+          for( auto& group : pixels ) group = _mm_shuffle_epi8( group, order ) ;
+          store3Ssse3( destination + index * 3, pixels ) ;
+        }
+
+        return index ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "ssse3" ) static std::size_t expandSsse3( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        const __m128i straight = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 ) ;
+        const __m128i swapped  = _mm_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 ) ;
+        const __m128i order    = swap ? swapped : straight ;
+        const __m128i opaque   = _mm_set1_epi32( static_cast<int>( 0xFF000000u ) ) ;
+        __m128i       pixels[ 4 ] ;
+
+        for( ; index + 16 <= count; index += 16 )
+        {
+          __m128i* out = reinterpret_cast<__m128i*>( destination + index * 4 ) ;
+
+          load3Ssse3( source + index * 3, pixels ) ;
+          for( unsigned group = 0; group < 4; group++ ) _mm_storeu_si128( out + group, _mm_or_si128( _mm_shuffle_epi8( pixels[ group ], order ), opaque ) ) ;
+        }
+
+        return index ;
+      }
+
+      YGGDRASIL_PIXELS_TARGET( "ssse3" ) static std::size_t packSsse3( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        const __m128i straight = _mm_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 ) ;
+        const __m128i swapped  = _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) ;
+        const __m128i order    = swap ? swapped : straight ;
+        __m128i       pixels[ 4 ] ;
+
+        // All 16 pixels are loaded before any are stored, so packing in place never overwrites pixels not yet read.
+        for( ; index + 16 <= count; index += 16 )
+        {
+          const __m128i* in = reinterpret_cast<const __m128i*>( source + index * 4 ) ;
+
+          for( unsigned group = 0; group < 4; group++ ) pixels[ group ] = _mm_shuffle_epi8( _mm_loadu_si128( in + group ), order ) ;
+          store3Ssse3( destination + index * 3, pixels ) ;
+        }
+
+        return index ;
+      }
+    #endif
+
+    #ifdef YGGDRASIL_PIXELS_SSE2
+      static std::size_t swizzleSse2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m128i keep = _mm_set1_epi32( static_cast<int>( 0xFF00FF00u ) ) ;
+        const __m128i low  = _mm_set1_epi32( 0x000000FF ) ;
+        const __m128i high = _mm_set1_epi32( 0x00FF0000 ) ;
+
+        // Without byte shuffles, red & blue trade places by shifting each 32 bit pixel both ways.
+        for( ; index + 4 <= count; index += 4 )
+        {
+          const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + index * 4 ) ) ;
+          const __m128i moved  = _mm_or_si128( _mm_and_si128( _mm_srli_epi32( pixels, 16 ), low ), _mm_and_si128( _mm_slli_epi32( pixels, 16 ), high ) ) ;
+
+          _mm_storeu_si128( reinterpret_cast<__m128i*>( destination + index * 4 ), _mm_or_si128( _mm_and_si128( pixels, keep ), moved ) ) ;
+        }
+
+        return index ;
+      }
+
+      static inline __m128i premultiplySse2( __m128i pixels )
+      {
+        const __m128i colour = _mm_setr_epi16( -1, -1, -1, 0, -1, -1, -1, 0 ) ;
+        const __m128i opaque = _mm_setr_epi16( 0, 0, 0, 255, 0, 0, 0, 255 ) ;
+        __m128i       alpha  ;
+        __m128i       scaled ;
+
+        alpha  = _mm_shufflehi_epi16( _mm_shufflelo_epi16( pixels, 0xFF ), 0xFF ) ;
+        alpha  = _mm_or_si128( _mm_and_si128( alpha, colour ), opaque ) ;
+        scaled = _mm_add_epi16( _mm_mullo_epi16( pixels, alpha ), _mm_set1_epi16( 128 ) ) ;
+
+        return _mm_srli_epi16( _mm_add_epi16( scaled, _mm_srli_epi16( scaled, 8 ) ), 8 ) ;
+      }
+
+      static std::size_t premultiplySse2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m128i zero = _mm_setzero_si128() ;
+
+        for( ; index + 4 <= count; index += 4 )
+        {
+          const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + index * 4 ) ) ;
+          const __m128i low    = premultiplySse2( _mm_unpacklo_epi8( pixels, zero ) ) ;
+          const __m128i high   = premultiplySse2( _mm_unpackhi_epi8( pixels, zero ) ) ;
+
+          _mm_storeu_si128( reinterpret_cast<__m128i*>( destination + index * 4 ), _mm_packus_epi16( low, high ) ) ;
+        }
+
+        return index ;
+      }
+
+      static inline __m128i unpremultiplySse2( __m128i pixel )
+      {
+        const __m128  colour = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) ) ;
+        const __m128  value  = _mm_cvtepi32_ps( pixel ) ;
+        const __m128  alpha  = _mm_shuffle_ps( value, value, 0xFF ) ;
+        __m128        result ;
+
+        // Same arithmetic as divide(). A zero alpha divides to infinity or NaN, which the mask then clears.
+        result = _mm_div_ps( _mm_mul_ps( value, _mm_set1_ps( 255.0f ) ), alpha ) ;
+        result = _mm_min_ps( _mm_add_ps( result, _mm_set1_ps( 0.5f ) ), _mm_set1_ps( 255.0f ) ) ;
+        result = _mm_andnot_ps( _mm_cmpeq_ps( alpha, _mm_setzero_ps() ), result ) ;
+        result = _mm_or_ps( _mm_and_ps( colour, result ), _mm_andnot_ps( colour, value ) ) ;
+
+        return _mm_cvttps_epi32( result ) ;
+      }
+
+      static std::size_t unpremultiplySse2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        const __m128i zero   = _mm_setzero_si128() ;
+        const __m128i opaque = _mm_set1_epi8( -1 ) ;
+
+        for( ; index + 4 <= count; index += 4 )
+        {
+          const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + index * 4 ) ) ;
+          __m128i*      out    = reinterpret_cast<__m128i*>( destination + index * 4 ) ;
+
+          // Images are mostly opaque, & opaque pixels divide to themselves.
+          if( ( _mm_movemask_epi8( _mm_cmpeq_epi8( pixels, opaque ) ) & 0x8888 ) == 0x8888 )
+          {
+            _mm_storeu_si128( out, pixels ) ;
+            continue ;
+          }
+
+          const __m128i low  = _mm_unpacklo_epi8( pixels, zero ) ;
+          const __m128i high = _mm_unpackhi_epi8( pixels, zero ) ;
+          const __m128i a    = _mm_packs_epi32( unpremultiplySse2( _mm_unpacklo_epi16( low , zero ) ), unpremultiplySse2( _mm_unpackhi_epi16( low , zero ) ) ) ;
+          const __m128i b    = _mm_packs_epi32( unpremultiplySse2( _mm_unpacklo_epi16( high, zero ) ), unpremultiplySse2( _mm_unpackhi_epi16( high, zero ) ) ) ;
+
+          _mm_storeu_si128( out, _mm_packus_epi16( a, b ) ) ;
+        }
+
+        return index ;
+      }
+
+      static inline __m128i lumaSse2( __m128i pixels, __m128i red, __m128i green, __m128i blue )
+      {
+        const __m128i mask = _mm_set1_epi32( 0xFF ) ;
+        __m128i       sum  ;
+
+        sum = _mm_mullo_epi16( _mm_and_si128( pixels, mask ), red ) ;
+        sum = _mm_add_epi32( sum, _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( pixels, 8  ), mask ), green ) ) ;
+        sum = _mm_add_epi32( sum, _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( pixels, 16 ), mask ), blue  ) ) ;
+
+        return _mm_srli_epi32( sum, 8 ) ;
+      }
+
+      static std::size_t lumaSse2( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        const __m128i red   = _mm_set1_epi32( swap ? LUMA_BLUE : LUMA_RED  ) ;
+        const __m128i green = _mm_set1_epi32( LUMA_GREEN                   ) ;
+        const __m128i blue  = _mm_set1_epi32( swap ? LUMA_RED  : LUMA_BLUE ) ;
+
+        for( ; index + 16 <= count; index += 16 )
+        {
+          const __m128i* pixels = reinterpret_cast<const __m128i*>( source + index * 4 ) ;
+          const __m128i  first  = lumaSse2( _mm_loadu_si128( pixels     ), red, green, blue ) ;
+          const __m128i  second = lumaSse2( _mm_loadu_si128( pixels + 1 ), red, green, blue ) ;
+          const __m128i  third  = lumaSse2( _mm_loadu_si128( pixels + 2 ), red, green, blue ) ;
+          const __m128i  fourth = lumaSse2( _mm_loadu_si128( pixels + 3 ), red, green, blue ) ;
+
+          _mm_storeu_si128( reinterpret_cast<__m128i*>( destination + index ), _mm_packus_epi16( _mm_packs_epi32( first, second ), _mm_packs_epi32( third, fourth ) ) ) ;
+        }
+
+        return index ;
+      }
+    #endif
+
+    #ifdef YGGDRASIL_PIXELS_NEON
+      static std::size_t swizzleNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, unsigned channels )
+      {
+        for( ; index + 16 <= count && channels == 4; index += 16 )
+        {
+          uint8x16x4_t pixels = vld4q_u8( source + index * 4 ) ;
+          std::swap( pixels.val[ 0 ], pixels.val[ 2 ] ) ;
+          vst4q_u8( destination + index * 4, pixels ) ;
+        }
+
+        for( ; index + 16 <= count && channels == 3; index += 16 )
+        {
+          uint8x16x3_t pixels = vld3q_u8( source + index * 3 ) ;
+          std::swap( pixels.val[ 0 ], pixels.val[ 2 ] ) ;
+          vst3q_u8( destination + index * 3, pixels ) ;
+        }
+
+        return index ;
+      }
+
+      static inline uint8x16_t premultiplyNeon( uint8x16_t colour, uint8x16_t alpha )
+      {
+        const uint16x8_t low  = vmull_u8     ( vget_low_u8( colour ), vget_low_u8( alpha ) ) ;
+        const uint16x8_t high = vmull_high_u8( colour, alpha ) ;
+
+        // ( t + ( ( t + 128 ) >> 8 ) + 128 ) >> 8, the same rounding as multiply().
+        return vcombine_u8( vraddhn_u16( low, vrshrq_n_u16( low, 8 ) ), vraddhn_u16( high, vrshrq_n_u16( high, 8 ) ) ) ;
+      }
+
+      static std::size_t premultiplyNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        for( ; index + 16 <= count; index += 16 )
+        {
+          uint8x16x4_t pixels = vld4q_u8( source + index * 4 ) ;
+
+          for( unsigned channel = 0; channel < 3; channel++ ) pixels.val[ channel ] = premultiplyNeon( pixels.val[ channel ], pixels.val[ 3 ] ) ;
+          vst4q_u8( destination + index * 4, pixels ) ;
+        }
+
+        return index ;
+      }
+
+      static inline uint32x4_t unpremultiplyNeon( uint32x4_t colour, uint32x4_t alpha )
+      {
+        const float32x4_t value   = vcvtq_f32_u32( colour ) ;
+        const float32x4_t divisor = vcvtq_f32_u32( alpha  ) ;
+        float32x4_t       result  ;
+
+        result = vdivq_f32( vmulq_n_f32( value, 255.0f ), divisor ) ;
+        result = vminq_f32( vaddq_f32( result, vdupq_n_f32( 0.5f ) ), vdupq_n_f32( 255.0f ) ) ;
+
+        return vandq_u32( vcvtq_u32_f32( result ), vcgtq_u32( alpha, vdupq_n_u32( 0 ) ) ) ;
+      }
+
+      static inline uint8x16_t unpremultiplyNeon( uint8x16_t colour, uint8x16_t alpha )
+      {
+        const uint16x8_t colours[ 2 ] = { vmovl_u8( vget_low_u8( colour ) ), vmovl_high_u8( colour ) } ;
+        const uint16x8_t alphas [ 2 ] = { vmovl_u8( vget_low_u8( alpha  ) ), vmovl_high_u8( alpha  ) } ;
+        uint16x8_t       halves [ 2 ] ;
+
+        for( unsigned half = 0; half < 2; half++ )
+        {
+          const uint32x4_t low  = unpremultiplyNeon( vmovl_u16( vget_low_u16( colours[ half ] ) ), vmovl_u16( vget_low_u16( alphas[ half ] ) ) ) ;
+          const uint32x4_t high = unpremultiplyNeon( vmovl_high_u16( colours[ half ] )            , vmovl_high_u16( alphas[ half ] )          ) ;
+
+          halves[ half ] = vcombine_u16( vmovn_u32( low ), vmovn_u32( high ) ) ;
+        }
+
+        return vcombine_u8( vmovn_u16( halves[ 0 ] ), vmovn_u16( halves[ 1 ] ) ) ;
+      }
+
+      static std::size_t unpremultiplyNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count )
+      {
+        for( ; index + 16 <= count; index += 16 )
+        {
+          uint8x16x4_t pixels = vld4q_u8( source + index * 4 ) ;
+
+          if( vminvq_u8( pixels.val[ 3 ] ) != 255 )
+          {
+            for( unsigned channel = 0; channel < 3; channel++ ) pixels.val[ channel ] = unpremultiplyNeon( pixels.val[ channel ], pixels.val[ 3 ] ) ;
+          }
+
+          vst4q_u8( destination + index * 4, pixels ) ;
+        }
+
+        return index ;
+      }
+
+      static std::size_t expandNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        for( ; index + 16 <= count; index += 16 )
+        {
+          const uint8x16x3_t pixels   = vld3q_u8( source + index * 3 ) ;
+          uint8x16x4_t       expanded ;
+
+          expanded.val[ 0 ] = pixels.val[ swap ? 2 : 0 ] ;
+          expanded.val[ 1 ] = pixels.val[ 1            ] ;
+          expanded.val[ 2 ] = pixels.val[ swap ? 0 : 2 ] ;
+          expanded.val[ 3 ] = vdupq_n_u8( 255 )          ;
+          vst4q_u8( destination + index * 4, expanded ) ;
+        }
+
+        return index ;
+      }
+
+      static std::size_t packNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        for( ; index + 16 <= count; index += 16 )
+        {
+          const uint8x16x4_t pixels = vld4q_u8( source + index * 4 ) ;
+          uint8x16x3_t       packed ;
+
+          packed.val[ 0 ] = pixels.val[ swap ? 2 : 0 ] ;
+          packed.val[ 1 ] = pixels.val[ 1            ] ;
+          packed.val[ 2 ] = pixels.val[ swap ? 0 : 2 ] ;
+          vst3q_u8( destination + index * 3, packed ) ;
+        }
+
+        return index ;
+      }
+
+      static std::size_t lumaNeon( const unsigned char* source, unsigned char* destination, std::size_t index, std::size_t count, bool swap )
+      {
+        const uint8x8_t red   = vdup_n_u8( swap ? LUMA_BLUE : LUMA_RED  ) ;
+        const uint8x8_t green = vdup_n_u8( LUMA_GREEN                   ) ;
+        const uint8x8_t blue  = vdup_n_u8( swap ? LUMA_RED  : LUMA_BLUE ) ;
+
+        for( ; index + 16 <= count; index += 16 )
+        {
+          const uint8x16x4_t pixels = vld4q_u8( source + index * 4 ) ;
+          uint16x8_t         low    ;
+          uint16x8_t         high   ;
+
+          low  = vmull_u8     ( vget_low_u8( pixels.val[ 0 ] ), red ) ;
+          low  = vmlal_u8     ( low, vget_low_u8( pixels.val[ 1 ] ), green ) ;
+          low  = vmlal_u8     ( low, vget_low_u8( pixels.val[ 2 ] ), blue  ) ;
+          high = vmull_high_u8( pixels.val[ 0 ], vcombine_u8( red, red ) ) ;
+          high = vmlal_high_u8( high, pixels.val[ 1 ], vcombine_u8( green, green ) ) ;
+          high = vmlal_high_u8( high, pixels.val[ 2 ], vcombine_u8( blue , blue  ) ) ;
+
+          vst1q_u8( destination + index, vcombine_u8( vshrn_n_u16( low, 8 ), vshrn_n_u16( high, 8 ) ) ) ;
+        }
+
+        return index ;
+      }
+    #endif
+
+    unsigned channels( PixelFormat format )
+    {
+      switch( format )
+      {
+        case PixelFormat::Grey              : return 1 ;
+        case PixelFormat::GreyAlpha         : return 2 ;
+        case PixelFormat::Rgb               :
+        case PixelFormat::Bgr               : return 3 ;
+        case PixelFormat::Rgba              :
+        case PixelFormat::Bgra              :
+        case PixelFormat::RgbaPremultiplied :
+        case PixelFormat::BgraPremultiplied : return 4 ;
+        default                             : return 0 ;
+      }
+    }
+
+    PixelFormat standard( unsigned channels )
+    {
+      switch( channels )
+      {
+        case 1  : return PixelFormat::Grey      ;
+        case 2  : return PixelFormat::GreyAlpha ;
+        case 3  : return PixelFormat::Rgb       ;
+        case 4  : return PixelFormat::Rgba      ;
+        default : return PixelFormat::Native    ;
+      }
+    }
+
+    PixelFormat straight( PixelFormat format )
+    {
+      if( format == PixelFormat::RgbaPremultiplied ) return PixelFormat::Rgba ;
+      if( format == PixelFormat::BgraPremultiplied ) return PixelFormat::Bgra ;
+      return format ;
+    }
+
+    /** Function to retrieve whether or not a format has it's blue channel first.
+     * @param format The format.
+     * @return Whether or not the format is BGR(A).
+     */
+    static bool swapped( PixelFormat format )
+    {
+      return format == PixelFormat::Bgr || format == PixelFormat::Bgra || format == PixelFormat::BgraPremultiplied ;
+    }
+
+    /** Function to retrieve whether or not a format's colours are multiplied by it's alpha.
+     * @param format The format.
+     * @return Whether or not the format is premultiplied.
+     */
+    static bool premultiplied( PixelFormat format )
+    {
+      return format == PixelFormat::RgbaPremultiplied || format == PixelFormat::BgraPremultiplied ;
+    }
+
+    void swizzle( const unsigned char* source, unsigned char* destination, std::size_t count, unsigned channels )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_X86
+        if( channels == 4 && hasAvx2()  ) index = swizzleAvx2  ( source, destination, index, count ) ;
+        if( channels == 3 && hasSsse3() ) index = swizzle3Ssse3( source, destination, index, count ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_SSE2
+        if( channels == 4 ) index = swizzleSse2( source, destination, index, count ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = swizzleNeon( source, destination, index, count, channels ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in  = source      + index * channels ;
+        unsigned char*       out = destination + index * channels ;
+        const unsigned char  red = in[ 0 ] ;
+
+        out[ 0 ] = in[ 2 ] ;
+        out[ 1 ] = in[ 1 ] ;
+        out[ 2 ] = red     ;
+        if( channels == 4 ) out[ 3 ] = in[ 3 ] ;
+      }
+    }
+
+    void premultiply( const unsigned char* source, unsigned char* destination, std::size_t count )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_X86
+        if( hasAvx2() ) index = premultiplyAvx2( source, destination, index, count ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_SSE2
+        index = premultiplySse2( source, destination, index, count ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = premultiplyNeon( source, destination, index, count ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in  = source      + index * 4 ;
+        unsigned char*       out = destination + index * 4 ;
+
+        out[ 0 ] = multiply( in[ 0 ], in[ 3 ] ) ;
+        out[ 1 ] = multiply( in[ 1 ], in[ 3 ] ) ;
+        out[ 2 ] = multiply( in[ 2 ], in[ 3 ] ) ;
+        out[ 3 ] = in[ 3 ]                      ;
+      }
+    }
+
+    void unpremultiply( const unsigned char* source, unsigned char* destination, std::size_t count )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_SSE2
+        index = unpremultiplySse2( source, destination, index, count ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = unpremultiplyNeon( source, destination, index, count ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in    = source      + index * 4 ;
+        unsigned char*       out   = destination + index * 4 ;
+        const unsigned char  alpha = in[ 3 ] ;
+
+        out[ 0 ] = alpha != 0 ? divide( in[ 0 ], alpha ) : 0 ;
+        out[ 1 ] = alpha != 0 ? divide( in[ 1 ], alpha ) : 0 ;
+        out[ 2 ] = alpha != 0 ? divide( in[ 2 ], alpha ) : 0 ;
+        out[ 3 ] = alpha                                     ;
+      }
+    }
+
+    void expand( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_X86
+        if( hasSsse3() ) index = expandSsse3( source, destination, index, count, swap ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = expandNeon( source, destination, index, count, swap ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in  = source      + index * 3 ;
+        unsigned char*       out = destination + index * 4 ;
+
+        out[ 0 ] = in[ swap ? 2 : 0 ] ;
+        out[ 1 ] = in[ 1            ] ;
+        out[ 2 ] = in[ swap ? 0 : 2 ] ;
+        out[ 3 ] = 255                ;
+      }
+    }
+
+    void pack( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_X86
+        if( hasSsse3() ) index = packSsse3( source, destination, index, count, swap ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = packNeon( source, destination, index, count, swap ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in    = source      + index * 4 ;
+        unsigned char*       out   = destination + index * 3 ;
+        const unsigned char  red   = in[ swap ? 2 : 0 ] ;
+        const unsigned char  green = in[ 1            ] ;
+        const unsigned char  blue  = in[ swap ? 0 : 2 ] ;
+
+        out[ 0 ] = red   ;
+        out[ 1 ] = green ;
+        out[ 2 ] = blue  ;
+      }
+    }
+
+    void luma( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap )
+    {
+      std::size_t index = 0 ;
+
+      #ifdef YGGDRASIL_PIXELS_X86
+        if( hasAvx2() ) index = lumaAvx2( source, destination, index, count, swap ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_SSE2
+        index = lumaSse2( source, destination, index, count, swap ) ;
+      #endif
+      #ifdef YGGDRASIL_PIXELS_NEON
+        index = lumaNeon( source, destination, index, count, swap ) ;
+      #endif
+
+      for( ; index < count; index++ )
+      {
+        const unsigned char* in = source + index * 4 ;
+
+        destination[ index ] = static_cast<unsigned char>( ( in[ swap ? 2 : 0 ] * LUMA_RED + in[ 1 ] * LUMA_GREEN + in[ swap ? 0 : 2 ] * LUMA_BLUE ) >> 8 ) ;
+      }
+    }
+
+    /** Function to convert pixels one at a time, for the conversions without a kernel of their own.
+     * @param source The pixels to convert.
+     * @param from The format of the source pixels.
+     * @param destination The pixels to write.
+     * @param to The format to convert to.
+     * @param count The amount of pixels.
+     */
+    static void convertEach( const unsigned char* source, PixelFormat from, unsigned char* destination, PixelFormat to, std::size_t count )
+    {
+      const unsigned in_channels  = channels( from ) ;
+      const unsigned out_channels = channels( to   ) ;
+      unsigned char  pixel[ 4 ]   ;
+
+      for( std::size_t index = 0; index < count; index++ )
+      {
+        const unsigned char* in  = source      + index * in_channels  ;
+        unsigned char*       out = destination + index * out_channels ;
+
+        // Each pixel is read whole into straight RGBA before any of it is written, so converting in place is safe.
+        if( in_channels <= 2 )
+        {
+          pixel[ 0 ] = pixel[ 1 ] = pixel[ 2 ] = in[ 0 ] ;
+          pixel[ 3 ] = in_channels == 2 ? in[ 1 ] : 255 ;
+        }
+        else
+        {
+          pixel[ 0 ] = in[ swapped( from ) ? 2 : 0 ] ;
+          pixel[ 1 ] = in[ 1                       ] ;
+          pixel[ 2 ] = in[ swapped( from ) ? 0 : 2 ] ;
+          pixel[ 3 ] = in_channels == 4 ? in[ 3 ] : 255 ;
+          if( premultiplied( from ) ) unpremultiply( pixel, pixel, 1 ) ;
+        }
+
+        if( out_channels <= 2 )
+        {
+          out[ 0 ] = static_cast<unsigned char>( ( pixel[ 0 ] * LUMA_RED + pixel[ 1 ] * LUMA_GREEN + pixel[ 2 ] * LUMA_BLUE ) >> 8 ) ;
+          if( out_channels == 2 ) out[ 1 ] = pixel[ 3 ] ;
+        }
+        else
+        {
+          if( premultiplied( to ) ) premultiply( pixel, pixel, 1 ) ;
+          out[ 0 ] = pixel[ swapped( to ) ? 2 : 0 ] ;
+          out[ 1 ] = pixel[ 1                     ] ;
+          out[ 2 ] = pixel[ swapped( to ) ? 0 : 2 ] ;
+          if( out_channels == 4 ) out[ 3 ] = pixel[ 3 ] ;
+        }
+      }
+    }
+
+    bool convert( const unsigned char* source, PixelFormat from, unsigned char* destination, PixelFormat to, std::size_t count )
+    {
+      const unsigned in_channels  = channels( from ) ;
+      const unsigned out_channels = channels( to   ) ;
+      const bool     swap         = swapped( from ) != swapped( to ) ;
+      unsigned char  scratch[ CHUNK * 4 ] ;
+
+      if( in_channels == 0 || out_channels == 0 ) return false ;
+
+      if( from == to )
+      {
+        if( source != destination ) std::memmove( destination, source, count * in_channels ) ;
+        return true ;
+      }
+
+      if( in_channels == 3 && out_channels == 3 ) { swizzle( source, destination, count, 3        ) ; return true ; }
+      if( in_channels == 3 && out_channels == 4 ) { expand ( source, destination, count, swap     ) ; return true ; }
+      if( in_channels != 4 || out_channels == 2 )
+      {
+        convertEach( source, from, destination, to, count ) ;
+        return true ;
+      }
+
+      // Opaque pixels are the same premultiplied or not, so only 4 channel sources can need a multiply or divide.
+      for( std::size_t first = 0; first < count; first += CHUNK )
+      {
+        const std::size_t    amount = std::min( CHUNK, count - first ) ;
+        const unsigned char* in     = source      + first * 4            ;
+        unsigned char*       out    = destination + first * out_channels ;
+
+        if( premultiplied( from ) && !premultiplied( to ) ) { unpremultiply( in, scratch, amount ) ; in = scratch ; }
+        if( !premultiplied( from ) && premultiplied( to ) ) { premultiply  ( in, scratch, amount ) ; in = scratch ; }
+
+        if     ( out_channels == 1 ) luma( in, out, amount, swapped( from ) ) ;
+        else if( out_channels == 3 ) pack( in, out, amount, swap            ) ;
+        else if( swap              ) swizzle( in, out, amount, 4 )            ;
+        else                         std::memmove( out, in, amount * 4 )     ;
+      }
+
+      return true ;
+    }
+  }
+}
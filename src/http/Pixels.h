@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pixels.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 19, 2021, 9:40 AM
+ */
+
+#ifndef YGGDRASIL_PIXELS_H
+#define YGGDRASIL_PIXELS_H
+
+#include <cstddef>
+
+namespace ygg
+{
+  /** The layouts decoded pixels can be in. Every channel is a single byte.
+   */
+  enum class PixelFormat
+  {
+    Native,            ///< Whatever the encoded image has, in it's standard order.
+    Grey,              ///< Luminance only.
+    GreyAlpha,         ///< Luminance, then straight alpha.
+    Rgb,               ///< Red, green, blue.
+    Rgba,              ///< Red, green, blue, then straight alpha.
+    Bgr,               ///< Blue, green, red.
+    Bgra,              ///< Blue, green, red, then straight alpha.
+    RgbaPremultiplied, ///< Red, green, blue already multiplied by alpha, then alpha.
+    BgraPremultiplied  ///< Blue, green, red already multiplied by alpha, then alpha.
+  };
+
+  /** Functions to convert pixels between formats.
+   * Each kernel picks the widest instructions the CPU has at runtime: AVX2 or SSSE3 where available, SSE2 otherwise, or NEON on 64-bit ARM.
+   * Unless noted, the destination may be the source itself, converting in place.
+   */
+  namespace pixels
+  {
+    /** Function to retrieve the amount of channels of a format.
+     * @param format The format.
+     * @return The amount of channels of each pixel. 0 for PixelFormat::Native.
+     */
+    unsigned channels( PixelFormat format ) ;
+
+    /** Function to retrieve the standard format for an amount of channels, as decoders produce them.
+     * @param channels The amount of channels. 0 for PixelFormat::Native.
+     * @return The grey, grey-alpha, RGB or RGBA format with that many channels.
+     */
+    PixelFormat standard( unsigned channels ) ;
+
+    /** Function to retrieve the format laid out like another, but with straight alpha. Opaque pixels are the same bytes in either.
+     * @param format The format.
+     * @return The format without premultiplied alpha.
+     */
+    PixelFormat straight( PixelFormat format ) ;
+
+    /** Function to swap the red & blue channels of pixels, turning RGB(A) into BGR(A) & back.
+     * @param source The pixels to swap.
+     * @param destination The pixels to write.
+     * @param count The amount of pixels.
+     * @param channels The amount of channels of each pixel, 3 or 4.
+     */
+    void swizzle( const unsigned char* source, unsigned char* destination, std::size_t count, unsigned channels ) ;
+
+    /** Function to multiply the colour of 4 channel pixels by their alpha, which is last.
+     * @param source The straight pixels.
+     * @param destination The premultiplied pixels to write.
+     * @param count The amount of pixels.
+     */
+    void premultiply( const unsigned char* source, unsigned char* destination, std::size_t count ) ;
+
+    /** Function to divide the colour of 4 channel pixels by their alpha, which is last. Fully transparent pixels become black.
+     * @param source The premultiplied pixels.
+     * @param destination The straight pixels to write.
+     * @param count The amount of pixels.
+     */
+    void unpremultiply( const unsigned char* source, unsigned char* destination, std::size_t count ) ;
+
+    /** Function to add an opaque alpha channel to 3 channel pixels.
+     * @note The destination can not be the source.
+     * @param source The 3 channel pixels.
+     * @param destination The 4 channel pixels to write.
+     * @param count The amount of pixels.
+     * @param swap Whether or not to swap the red & blue channels as well.
+     */
+    void expand( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap ) ;
+
+    /** Function to drop the alpha channel of 4 channel pixels.
+     * @param source The 4 channel pixels.
+     * @param destination The 3 channel pixels to write.
+     * @param count The amount of pixels.
+     * @param swap Whether or not to swap the red & blue channels as well.
+     */
+    void pack( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap ) ;
+
+    /** Function to find the luminance of 4 channel pixels, weighted as the decoder does for grey images.
+     * @param source The 4 channel pixels.
+     * @param destination The 1 channel pixels to write.
+     * @param count The amount of pixels.
+     * @param swap Whether or not the source is BGRA rather than RGBA.
+     */
+    void luma( const unsigned char* source, unsigned char* destination, std::size_t count, bool swap ) ;
+
+    /** Function to convert pixels from one format to another.
+     * @note Converting in place is only possible when the destination format has no more channels than the source's.
+     * @param source The pixels to convert.
+     * @param from The format of the source pixels.
+     * @param destination The pixels to write.
+     * @param to The format to convert to.
+     * @param count The amount of pixels.
+     * @return Whether or not the pixels could be converted. PixelFormat::Native can not be converted from or to.
+     */
+    bool convert( const unsigned char* source, PixelFormat from, unsigned char* destination, PixelFormat to, std::size_t count ) ;
+  }
+}
+
+#endif /* PIXELS_H */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pool.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 9, 2021, 8:30 PM
+ */
+
+#include "Pool.h"
+#include "Url.h"
+#include <ygg/Connection.h>
+#ifdef _WIN32
+  #include <win32/Win32.h>
+#elif __linux__
+  #include <linux/Linux.h>
+#endif
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <mutex>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The default amount of idle connections kept per origin.
+     */
+    static const unsigned DEFAULT_LIMIT = 8 ;
+
+    /** Structure to contain a pool's data.
+     */
+    struct PoolData
+    {
+      using Links = std::vector<Pool::Link*>                 ;
+      using Idle  = std::unordered_map<unsigned, Links>      ;
+
+      Idle       idle  ; ///< The idle connections of each origin, by URL key.
+      std::mutex lock  ; ///< The lock guarding the idle connections.
+      unsigned   limit ; ///< The maximum amount of idle connections per origin.
+
+      /** Default constructor.
+       */
+      PoolData() ;
+    };
+
+    PoolData::PoolData()
+    {
+      this->limit = DEFAULT_LIMIT ;
+    }
+
+    Pool::Pool()
+    {
+      this->pool_data = new PoolData() ;
+    }
+
+    Pool::~Pool()
+    {
+      this->clear() ;
+      delete this->pool_data ;
+    }
+
+    void Pool::setLimit( unsigned amount )
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+
+      data().limit = amount ;
+    }
+
+    Pool::Link* Pool::acquire( const Url& url )
+    {
+      const unsigned key  = url.key() ;
+      Link*          link = nullptr   ;
+
+      {
+        std::lock_guard<std::mutex> lock( data().lock ) ;
+
+        auto& links = data().idle[ key ] ;
+        while( link == nullptr && !links.empty() )
+        {
+          link = links.back() ;
+          links.pop_back() ;
+
+          if( !link->valid() )
+          {
+            delete link ;
+            link = nullptr ;
+          }
+        }
+      }
+
+      if( link != nullptr ) return link ;
+
+      // Connecting blocks, so it happens outside the lock.
+      link = new Link() ;
+      link->connect( std::string( url.host() ).c_str(), ygg::ConnectionType::Client, url.port(), url.secure() ) ;
+
+      if( !link->valid() )
+      {
+        delete link ;
+        return nullptr ;
+      }
+
+      return link ;
+    }
+
+    void Pool::release( const Url& url, Link* link, bool reusable )
+    {
+      const unsigned key = url.key() ;
+
+      if( link == nullptr ) return ;
+
+      if( reusable && link->valid() )
+      {
+        std::lock_guard<std::mutex> lock( data().lock ) ;
+
+        auto& links = data().idle[ key ] ;
+        if( links.size() < data().limit )
+        {
+          links.push_back( link ) ;
+          return ;
+        }
+      }
+
+      delete link ;
+    }
+
+    void Pool::clear()
+    {
+      std::lock_guard<std::mutex> lock( data().lock ) ;
+
+      for( auto& origin : data().idle )
+      {
+        for( auto* link : origin.second ) delete link ;
+      }
+
+      data().idle.clear() ;
+    }
+
+    PoolData& Pool::data()
+    {
+      return *this->pool_data ;
+    }
+
+    const PoolData& Pool::data() const
+    {
+      return *this->pool_data ;
+    }
+  }
+}
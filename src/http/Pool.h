@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Pool.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 9, 2021, 8:30 PM
+ */
+
+#ifndef YGGDRASIL_POOL_H
+#define YGGDRASIL_POOL_H
+
+namespace ygg
+{
+  template<typename Impl>
+  class Connection ;
+
+  namespace lx
+  {
+    class Linux ;
+  }
+
+  namespace win32
+  {
+    class Win32 ;
+  }
+
+  namespace http
+  {
+    class Url ;
+
+    /** Class to keep idle keep-alive connections around, so later requests to the same origin skip the connect & TLS handshake.
+     * Connections are handed out & taken back from any thread.
+     */
+    class Pool
+    {
+      public:
+
+        /** The type of connection the pool hands out.
+         */
+        #ifdef _WIN32
+          using Link = ygg::Connection<ygg::win32::Win32> ;
+        #else
+          using Link = ygg::Connection<ygg::lx::Linux> ;
+        #endif
+
+        /** Default constructor.
+         */
+        Pool() ;
+
+        /** Default deconstructor. Closes every idle connection.
+         */
+        ~Pool() ;
+
+        /** Method to set how many idle connections are kept per origin.
+         * @param amount The maximum amount of idle connections to one origin.
+         */
+        void setLimit( unsigned amount ) ;
+
+        /** Method to take a connection to the origin of a URL, reusing an idle one if there is one.
+         * @note The connection belongs to the caller until it is handed back with Pool::release().
+         * @param url The URL to connect for.
+         * @return A connection to the URL's origin, or nullptr if none could be made.
+         */
+        Link* acquire( const Url& url ) ;
+
+        /** Method to hand back a connection taken with Pool::acquire().
+         * @param url The URL the connection was taken for.
+         * @param link The connection to hand back.
+         * @param reusable Whether or not the connection can carry another request, i.e. the response was read whole & the server did not ask to close.
+         */
+        void release( const Url& url, Link* link, bool reusable ) ;
+
+        /** Method to close every idle connection.
+         */
+        void clear() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct PoolData *pool_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        PoolData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const PoolData& data() const ;
+    };
+  }
+}
+
+#endif /* POOL_H */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Queue.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 16, 2021, 7:15 PM
+ */
+
+#ifndef YGGDRASIL_QUEUE_H
+#define YGGDRASIL_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Bounded lock-free queue between exactly one producing thread & one consuming thread.
+     * Neither side ever blocks or takes a lock; a full or empty queue is reported instead, and the caller decides how to wait.
+     */
+    template<typename Type>
+    class Queue
+    {
+      public:
+
+        /** Constructor.
+         * @param capacity The minimum amount of values the queue holds. Rounded up to a power of two.
+         */
+        explicit Queue( std::size_t capacity ) ;
+
+        /** Default deconstructor.
+         */
+        ~Queue() = default ;
+
+        /** Method to add a value to the back of the queue. Only called by the producing thread.
+         * @param value The value to add.
+         * @return Whether or not the value was added. False if the queue is full.
+         */
+        bool push( const Type& value ) ;
+
+        /** Method to take the value at the front of the queue. Only called by the consuming thread.
+         * @param value Set to the value taken.
+         * @return Whether or not a value was taken. False if the queue is empty.
+         */
+        bool pop( Type& value ) ;
+
+        /** Method to retrieve the amount of values the queue holds.
+         * @return The capacity of the queue.
+         */
+        std::size_t capacity() const ;
+
+      private:
+
+        /** The size of a cache line, so the producer's & consumer's positions never share one.
+         */
+        static constexpr std::size_t LINE = 64 ;
+
+        std::vector<Type>                        queue_values ; ///< The ring of values.
+        std::size_t                              queue_mask   ; ///< The mask wrapping a position into the ring.
+        alignas( LINE ) std::atomic<std::size_t> queue_head   ; ///< The position of the next value to take. Written by the consumer.
+        alignas( LINE ) std::atomic<std::size_t> queue_tail   ; ///< The position of the next value to add. Written by the producer.
+    };
+
+    template<typename Type>
+    Queue<Type>::Queue( std::size_t capacity )
+    {
+      std::size_t size = 1 ;
+
+      while( size < capacity ) size <<= 1 ;
+
+      this->queue_values.resize( size ) ;
+      this->queue_mask = size - 1 ;
+      this->queue_head.store( 0, std::memory_order_relaxed ) ;
+      this->queue_tail.store( 0, std::memory_order_relaxed ) ;
+    }
+
+    template<typename Type>
+    bool Queue<Type>::push( const Type& value )
+    {
+      const std::size_t tail = this->queue_tail.load( std::memory_order_relaxed ) ;
+
+      if( tail - this->queue_head.load( std::memory_order_acquire ) == this->queue_values.size() ) return false ;
+
+      // The value is written before the tail is published, so the consumer never sees a half written value.
+      this->queue_values[ tail & this->queue_mask ] = value ;
+      this->queue_tail.store( tail + 1, std::memory_order_release ) ;
+
+      return true ;
+    }
+
+    template<typename Type>
+    bool Queue<Type>::pop( Type& value )
+    {
+      const std::size_t head = this->queue_head.load( std::memory_order_relaxed ) ;
+
+      if( head == this->queue_tail.load( std::memory_order_acquire ) ) return false ;
+
+      value = this->queue_values[ head & this->queue_mask ] ;
+      this->queue_head.store( head + 1, std::memory_order_release ) ;
+
+      return true ;
+    }
+
+    template<typename Type>
+    std::size_t Queue<Type>::capacity() const
+    {
+      return this->queue_values.size() ;
+    }
+  }
+}
+
+#endif /* QUEUE_H */
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Request.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 6, 2021, 3:12 PM
+ */
+
+#include "Request.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <charconv>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Structure to contain a request builder's data.
+     */
+    struct RequestData
+    {
+      using Header  = std::pair<std::string, std::string> ;
+      using Headers = std::vector<Header>                 ;
+
+      Headers     headers   ; ///< The headers sent with every request.
+      std::string host      ; ///< The authority the template was built for.
+      std::string compiled  ; ///< The serialized HOST header & persistent headers.
+      std::string buffer    ; ///< The serialized requests.
+      bool        dirty     ; ///< Whether or not the template has to be rebuilt before the next request.
+
+      /** Default constructor.
+       */
+      RequestData() ;
+
+      /** Method to rebuild the header template.
+       */
+      void compile() ;
+
+      /** Method to write a header line to a buffer.
+       * @param out The buffer to write to.
+       * @param name The name of the header.
+       * @param value The value of the header.
+       */
+      static void write( std::string& out, std::string_view name, std::string_view value ) ;
+    };
+
+    RequestData::RequestData()
+    {
+      this->dirty = true ;
+    }
+
+    void RequestData::write( std::string& out, std::string_view name, std::string_view value )
+    {
+      out.append( name.data(), name.size() ) ;
+      out.append( ": " ) ;
+      out.append( value.data(), value.size() ) ;
+      out.append( "\r\n" ) ;
+    }
+
+    void RequestData::compile()
+    {
+      this->compiled.clear() ;
+      RequestData::write( this->compiled, "HOST", this->host ) ;
+      for( const auto& header : this->headers ) RequestData::write( this->compiled, header.first, header.second ) ;
+
+      this->dirty = false ;
+    }
+
+    Request::Request()
+    {
+      this->request_data = new RequestData() ;
+    }
+
+    Request::~Request()
+    {
+      delete this->request_data ;
+    }
+
+    void Request::setHost( std::string_view authority )
+    {
+      if( data().host == authority ) return ;
+
+      data().host.assign( authority.data(), authority.size() ) ;
+      data().dirty = true ;
+    }
+
+    void Request::setHeader( std::string_view name, std::string_view value )
+    {
+      auto& headers = data().headers ;
+
+      data().dirty = true ;
+      for( auto iter = headers.begin(); iter != headers.end(); ++iter )
+      {
+        if( iter->first == name )
+        {
+          if( value.empty() ) headers.erase( iter ) ;
+          else                iter->second.assign( value.data(), value.size() ) ;
+          return ;
+        }
+      }
+
+      if( !value.empty() ) headers.emplace_back( std::string( name ), std::string( value ) ) ;
+    }
+
+    void Request::clear()
+    {
+      data().buffer.clear() ;
+    }
+
+    void Request::begin( std::string_view method, std::string_view path, std::string_view query )
+    {
+      std::string& out = data().buffer ;
+
+      if( data().dirty ) data().compile() ;
+
+      out.append( method.data(), method.size() ) ;
+      out.push_back( ' ' ) ;
+      out.append( path.data(), path.size() ) ;
+      if( !query.empty() )
+      {
+        out.push_back( '?' ) ;
+        out.append( query.data(), query.size() ) ;
+      }
+
+      out.append( " HTTP/1.1\r\n" ) ;
+      out.append( data().compiled ) ;
+    }
+
+    void Request::add( std::string_view name, std::string_view value )
+    {
+      RequestData::write( data().buffer, name, value ) ;
+    }
+
+    void Request::end( const void* body, unsigned size )
+    {
+      char length[ 16 ] ;
+
+      if( body != nullptr )
+      {
+        const auto result = std::to_chars( length, length + sizeof( length ), size ) ;
+
+        RequestData::write( data().buffer, "Content-Length", std::string_view( length, static_cast<std::size_t>( result.ptr - length ) ) ) ;
+      }
+
+      data().buffer.append( "\r\n" ) ;
+      if( body != nullptr ) data().buffer.append( static_cast<const char*>( body ), size ) ;
+    }
+
+    const char* Request::payload() const
+    {
+      return data().buffer.data() ;
+    }
+
+    unsigned Request::size() const
+    {
+      return static_cast<unsigned>( data().buffer.size() ) ;
+    }
+
+    RequestData& Request::data()
+    {
+      return *this->request_data ;
+    }
+
+    const RequestData& Request::data() const
+    {
+      return *this->request_data ;
+    }
+  }
+}
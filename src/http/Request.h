@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Request.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 6, 2021, 3:12 PM
+ */
+
+#ifndef YGGDRASIL_REQUEST_H
+#define YGGDRASIL_REQUEST_H
+
+#include <string_view>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to serialize HTTP/1.1 requests into a reused buffer.
+     * The HOST header & every header set with Request::setHeader() are compiled into a template once per host, so each request only writes it's request line, it's own headers & the template.
+     * Many requests can be written back-to-back before sending, e.g. for pipelining. Once the buffer has grown to fit, building a request allocates nothing.
+     */
+    class Request
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Request() ;
+
+        /** Default deconstructor.
+         */
+        ~Request() ;
+
+        /** Method to set the host every following request is made to. The template is only rebuilt if the host changed.
+         * @param authority The host & port, if not the default, as sent in the HOST header.
+         */
+        void setHost( std::string_view authority ) ;
+
+        /** Method to set a header sent with every following request.
+         * @param name The name of the header.
+         * @param value The value of the header. An empty value removes the header.
+         */
+        void setHeader( std::string_view name, std::string_view value ) ;
+
+        /** Method to drop every written request, keeping the buffer's memory.
+         */
+        void clear() ;
+
+        /** Method to start a new request after any already written, writing it's request line & the header template.
+         * @param method The request method, e.g. "GET".
+         * @param path The path to request, e.g. "/media/image.png".
+         * @param query The query of the request without the '?', if any.
+         */
+        void begin( std::string_view method, std::string_view path, std::string_view query = std::string_view() ) ;
+
+        /** Method to add a header to only the current request.
+         * @param name The name of the header.
+         * @param value The value of the header.
+         */
+        void add( std::string_view name, std::string_view value ) ;
+
+        /** Method to finish the current request.
+         * @param body The request body to send, if any. A body adds a Content-Length header.
+         * @param size The amount of bytes in the body.
+         */
+        void end( const void* body = nullptr, unsigned size = 0 ) ;
+
+        /** Method to retrieve the serialized requests.
+         * @return The pointer to the start of every request written since the last clear.
+         */
+        const char* payload() const ;
+
+        /** Method to retrieve the size of the serialized requests.
+         * @return The amount of bytes written since the last clear.
+         */
+        unsigned size() const ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct RequestData *request_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        RequestData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const RequestData& data() const ;
+    };
+  }
+}
+
+#endif /* REQUEST_H */
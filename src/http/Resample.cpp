@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Resample.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 18, 2021, 2:30 PM
+ */
+
+#include "Resample.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+  #include <emmintrin.h>
+  #define YGGDRASIL_RESAMPLE_SSE2
+#endif
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+namespace ygg
+{
+  /** The fixed point value the weights of every output pixel add up to.
+   */
+  static const std::uint32_t WEIGHT_ONE = 1 << 12 ;
+
+  /** Structure to describe the source pixels one output pixel covers along an axis.
+   */
+  struct Span
+  {
+    std::size_t first  ; ///< The first source pixel covered.
+    std::size_t count  ; ///< The amount of source pixels covered.
+    std::size_t offset ; ///< The offset of the weights of the covered pixels.
+  };
+
+  /** Structure to contain the spans & weights of every output pixel along an axis.
+   */
+  struct Axis
+  {
+    using Spans   = std::vector<Span>          ;
+    using Weights = std::vector<std::uint32_t> ;
+
+    Spans    spans   ; ///< The span of each output pixel.
+    Weights  weights ; ///< The weight of each covered source pixel, by how much of it the output pixel covers.
+    unsigned size    ; ///< The amount of source pixels the axis was built for.
+    unsigned out     ; ///< The amount of output pixels the axis was built for.
+
+    /** Default constructor.
+     */
+    Axis() ;
+
+    /** Method to build the spans & weights shrinking one length to another, unless they are built already.
+     * @param size The amount of source pixels.
+     * @param out The amount of output pixels.
+     */
+    void build( unsigned size, unsigned out ) ;
+  };
+
+  /** Structure to contain a resampler's data.
+   */
+  struct ResamplerData
+  {
+    using Sums = std::vector<std::uint32_t> ;
+
+    Axis horizontal ; ///< The spans & weights along each row.
+    Axis vertical   ; ///< The spans & weights along each column.
+    Sums sums       ; ///< The weighted sum of the source rows an output row covers.
+
+    /** Function to add a weighted source row onto the sums.
+     * @param row The source row.
+     * @param weight The weight of the row.
+     * @param sums The sums to add onto.
+     * @param count The amount of bytes in the row.
+     */
+    static void accumulate( const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t count ) ;
+  };
+
+  Axis::Axis()
+  {
+    this->size = 0 ;
+    this->out  = 0 ;
+  }
+
+  void Axis::build( unsigned size, unsigned out )
+  {
+    std::uint64_t begin   ;
+    std::uint64_t end     ;
+    std::uint64_t covered ;
+    std::uint32_t last    ;
+    std::uint32_t next    ;
+
+    if( this->size == size && this->out == out ) return ;
+
+    this->size = size ;
+    this->out  = out  ;
+    this->spans.resize( out ) ;
+    this->weights.clear() ;
+
+    // Positions are counted in 1/out of a source pixel, so every boundary lands on a whole number.
+    for( unsigned index = 0; index < out; index++ )
+    {
+      begin = static_cast<std::uint64_t>( index     ) * size ;
+      end   = static_cast<std::uint64_t>( index + 1 ) * size ;
+
+      this->spans[ index ].first  = begin / out ;
+      this->spans[ index ].count  = ( end - 1 ) / out - begin / out + 1 ;
+      this->spans[ index ].offset = this->weights.size() ;
+
+      // Weights are rounded from the running total, so they always add up to exactly WEIGHT_ONE.
+      covered = 0 ;
+      last    = 0 ;
+      for( std::size_t pixel = this->spans[ index ].first; pixel < this->spans[ index ].first + this->spans[ index ].count; pixel++ )
+      {
+        covered += std::min<std::uint64_t>( end, ( pixel + 1 ) * out ) - std::max<std::uint64_t>( begin, pixel * out ) ;
+        next     = static_cast<std::uint32_t>( ( covered * WEIGHT_ONE + size / 2 ) / size ) ;
+        this->weights.push_back( next - last ) ;
+        last     = next ;
+      }
+    }
+  }
+
+  void ResamplerData::accumulate( const unsigned char* row, std::uint32_t weight, std::uint32_t* sums, std::size_t count )
+  {
+    std::size_t index = 0 ;
+
+    #ifdef YGGDRASIL_RESAMPLE_SSE2
+      const __m128i scale = _mm_set1_epi16( static_cast<short>( weight ) ) ;
+      const __m128i zero  = _mm_setzero_si128() ;
+
+      // Eight bytes at a time: widened to 16 bits, multiplied into 32 bit products & added onto the sums.
+      for( ; index + 8 <= count; index += 8 )
+      {
+        const __m128i bytes = _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( row + index ) ), zero ) ;
+        const __m128i low   = _mm_mullo_epi16( bytes, scale ) ;
+        const __m128i high  = _mm_mulhi_epu16( bytes, scale ) ;
+        __m128i*      out   = reinterpret_cast<__m128i*>( sums + index ) ;
+
+        _mm_storeu_si128( out    , _mm_add_epi32( _mm_loadu_si128( out     ), _mm_unpacklo_epi16( low, high ) ) ) ;
+        _mm_storeu_si128( out + 1, _mm_add_epi32( _mm_loadu_si128( out + 1 ), _mm_unpackhi_epi16( low, high ) ) ) ;
+      }
+    #endif
+
+    for( ; index < count; index++ ) sums[ index ] += row[ index ] * weight ;
+  }
+
+  Resampler::Resampler()
+  {
+    this->resampler_data = new ResamplerData() ;
+  }
+
+  Resampler::~Resampler()
+  {
+    delete this->resampler_data ;
+  }
+
+  bool Resampler::resize( const unsigned char* source, unsigned width, unsigned height, unsigned channels, unsigned char* destination, unsigned out_width, unsigned out_height )
+  {
+    const std::size_t stride = static_cast<std::size_t>( width ) * channels ;
+    std::uint32_t     total  ;
+
+    if( source == nullptr || destination == nullptr || channels == 0 || channels > 4 ) return false ;
+    if( out_width == 0 || out_height == 0 || out_width > width || out_height > height ) return false ;
+
+    data().horizontal.build( width , out_width  ) ;
+    data().vertical  .build( height, out_height ) ;
+
+    for( unsigned row = 0; row < out_height; row++ )
+    {
+      const Span& span = data().vertical.spans[ row ] ;
+
+      // Every source row the output row covers is summed first, so each source byte is read once per output row.
+      data().sums.assign( stride, 0 ) ;
+      for( std::size_t line = 0; line < span.count; line++ )
+      {
+        ResamplerData::accumulate( source + ( span.first + line ) * stride, data().vertical.weights[ span.offset + line ], data().sums.data(), stride ) ;
+      }
+
+      for( unsigned column = 0; column < out_width; column++ )
+      {
+        const Span&          across  = data().horizontal.spans[ column ] ;
+        const std::uint32_t* weights = data().horizontal.weights.data() + across.offset ;
+        const std::uint32_t* sums    = data().sums.data() + across.first * channels ;
+
+        for( unsigned channel = 0; channel < channels; channel++ )
+        {
+          // At most 255 * WEIGHT_ONE * WEIGHT_ONE plus rounding, which still fits in 32 bits.
+          total = 1u << 23 ;
+          for( std::size_t pixel = 0; pixel < across.count; pixel++ ) total += sums[ pixel * channels + channel ] * weights[ pixel ] ;
+
+          destination[ ( static_cast<std::size_t>( row ) * out_width + column ) * channels + channel ] = static_cast<unsigned char>( total >> 24 ) ;
+        }
+      }
+    }
+
+    return true ;
+  }
+
+  ResamplerData& Resampler::data()
+  {
+    return *this->resampler_data ;
+  }
+
+  const ResamplerData& Resampler::data() const
+  {
+    return *this->resampler_data ;
+  }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Resample.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 18, 2021, 2:30 PM
+ */
+
+#ifndef YGGDRASIL_RESAMPLE_H
+#define YGGDRASIL_RESAMPLE_H
+
+namespace ygg
+{
+  /** Class to shrink images, averaging all of the source pixels each output pixel covers.
+   * Area averaging never skips source pixels, so fine detail is blended rather than aliased at any ratio.
+   */
+  class Resampler
+  {
+    public:
+
+      /** Default constructor.
+       */
+      Resampler() ;
+
+      /** Default deconstructor.
+       */
+      ~Resampler() ;
+
+      /** Method to shrink an image.
+       * @note The weights & buffers are kept, so resizing many images through one object does not allocate each time.
+       * @param source The pixels of the image, tightly packed.
+       * @param width The width of the image in pixels.
+       * @param height The height of the image in pixels.
+       * @param channels The amount of channels of each pixel.
+       * @param destination The pixels to write the shrunk image to. Must hold out_width * out_height * channels bytes.
+       * @param out_width The width to shrink to. At most the width of the image.
+       * @param out_height The height to shrink to. At most the height of the image.
+       * @return Whether or not the image could be shrunk to the size given.
+       */
+      bool resize( const unsigned char* source, unsigned width, unsigned height, unsigned channels, unsigned char* destination, unsigned out_width, unsigned out_height ) ;
+
+    private:
+
+      /** The forward declared structure containing this object's data.
+       */
+      struct ResamplerData *resampler_data ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      ResamplerData& data() ;
+
+      /** Method to retrieve a reference to this object's internal data structure.
+       * @return A reference to this object's internal data structure.
+       */
+      const ResamplerData& data() const ;
+  };
+}
+
+#endif /* RESAMPLE_H */
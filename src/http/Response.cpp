@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Response.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 12, 2021, 6:05 PM
+ */
+
+#include "Response.h"
+#include "Parser.h"
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The most bytes reserved for a body before it arrives, whatever it's Content-Length claims. Bigger bodies grow as they arrive.
+     */
+    static const std::size_t RESERVE_LIMIT = 16 * 1024 * 1024 ;
+
+    /** Structure to contain a response's data.
+     */
+    struct ResponseData
+    {
+      using Body = std::vector<unsigned char> ;
+
+      Parser      parser ; ///< The parsed header of the response.
+      Body        body   ; ///< The body of the response.
+      std::string url    ; ///< The URL that was answered.
+      bool        head   ; ///< Whether or not the request was a HEAD, whose Content-Length describes a body that is not sent.
+
+      /** Default constructor.
+       */
+      ResponseData() ;
+    };
+
+    ResponseData::ResponseData()
+    {
+      this->head = false ;
+    }
+
+    Response::Response()
+    {
+      this->response_data = new ResponseData() ;
+    }
+
+    Response::~Response()
+    {
+      delete this->response_data ;
+    }
+
+    unsigned Response::status() const
+    {
+      return data().parser.status() ;
+    }
+
+    const char* Response::value( const char* key ) const
+    {
+      return data().parser.value( key ) ;
+    }
+
+    const char* Response::url() const
+    {
+      return data().url.c_str() ;
+    }
+
+    const unsigned char* Response::body() const
+    {
+      return data().body.data() ;
+    }
+
+    std::size_t Response::size() const
+    {
+      return data().body.size() ;
+    }
+
+    bool Response::header( const Parser& header )
+    {
+      const char* length = header.value( "Content-Length" ) ;
+
+      // An encoded body's length is not the length of what gets written, so it's only a lower bound. It's also only the server's word,
+      // so a huge one must not be allocated up front.
+      data().body.clear() ;
+      if( length[ 0 ] != '\0' && !data().head ) data().body.reserve( std::min<unsigned long long>( std::strtoull( length, nullptr, 10 ), RESERVE_LIMIT ) ) ;
+
+      return true ;
+    }
+
+    bool Response::write( const unsigned char* bytes, std::size_t amount )
+    {
+      data().body.insert( data().body.end(), bytes, bytes + amount ) ;
+      return true ;
+    }
+
+    void Response::prepare( bool head )
+    {
+      data().parser.reset() ;
+      data().body.clear() ;
+      data().url.clear() ;
+      data().head = head ;
+    }
+
+    void Response::setUrl( const char* url )
+    {
+      data().url = url ;
+    }
+
+    Parser& Response::parser()
+    {
+      return data().parser ;
+    }
+
+    ResponseData& Response::data()
+    {
+      return *this->response_data ;
+    }
+
+    const ResponseData& Response::data() const
+    {
+      return *this->response_data ;
+    }
+  }
+}
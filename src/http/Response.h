@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Response.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 12, 2021, 6:05 PM
+ */
+
+#ifndef YGGDRASIL_RESPONSE_H
+#define YGGDRASIL_RESPONSE_H
+
+#include "Client.h"
+#include <cstddef>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to hold a whole response made by a Client.
+     * The body is received straight into this object's buffer, and handed out in place rather than copied.
+     * The buffer is reused by every response made into this object, so keeping one around avoids reallocating per request.
+     */
+    class Response : public Sink
+    {
+      public:
+
+        /** Default constructor.
+         */
+        Response() ;
+
+        /** Default deconstructor.
+         */
+        ~Response() ;
+
+        /** Method to retrieve the status code of this response.
+         * @return The HTTP status code of this response, or 0 if none was received.
+         */
+        unsigned status() const ;
+
+        /** Method to retrieve the value of a header of this response.
+         * @param key The header name to look up.
+         * @return The value of the header, or an empty string if it was not sent.
+         */
+        const char* value( const char* key ) const ;
+
+        /** Method to retrieve the URL this response came from, after any redirects.
+         * @return The C-string URL that was answered.
+         */
+        const char* url() const ;
+
+        /** Method to retrieve the body of this response.
+         * @note This is only valid until the next request made into this object.
+         * @return The pointer to the start of the body bytes.
+         */
+        const unsigned char* body() const ;
+
+        /** Method to retrieve the size of the body of this response.
+         * @return The amount of bytes in the body.
+         */
+        std::size_t size() const ;
+
+        /** Method to prepare for a body once the header is parsed, reserving room for it if it's length is known.
+         * @param header The parsed header of this response.
+         * @return Always true.
+         */
+        bool header( const Parser& header ) override ;
+
+        /** Method to append the next block of the body.
+         * @param bytes The body bytes.
+         * @param amount The amount of body bytes.
+         * @return Always true.
+         */
+        bool write( const unsigned char* bytes, std::size_t amount ) override ;
+
+      private:
+
+        friend class Client ;
+
+        /** Method to clear this response before a new request is made into it.
+         * @param head Whether or not the request is a HEAD, so no body will follow the header.
+         */
+        void prepare( bool head ) ;
+
+        /** Method to set the URL this response came from.
+         * @param url The C-string URL that was answered.
+         */
+        void setUrl( const char* url ) ;
+
+        /** Method to retrieve the parser this response's header is parsed into.
+         * @return A reference to the parser of this response.
+         */
+        Parser& parser() ;
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct ResponseData *response_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        ResponseData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const ResponseData& data() const ;
+    };
+  }
+}
+
+#endif /* RESPONSE_H */
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Segmented.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 9, 2021, 9:12 PM
+ */
+
+#include "Segmented.h"
+#include "Pool.h"
+#include "Url.h"
+#include "Parser.h"
+#include "Request.h"
+#include <ygg/Connection.h>
+#ifdef _WIN32
+  #include <win32/Win32.h>
+#elif __linux__
+  #include <linux/Linux.h>
+#endif
+
+#include <vector>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The amount of times a range is restarted after it's connection drops.
+     */
+    static const unsigned RANGE_ATTEMPTS = 3 ;
+
+    /** Structure to describe a single range of a download.
+     */
+    struct Range
+    {
+      std::size_t begin   ; ///< The offset of the first byte of the range.
+      std::size_t end     ; ///< The offset one past the last byte of the range.
+      bool        success ; ///< Whether or not the whole range was fetched.
+    };
+
+    /** Structure to contain a segmented download's data.
+     */
+    struct SegmentedDownloadData
+    {
+      using Ranges  = std::vector<Range>       ;
+      using Threads = std::vector<std::thread> ;
+
+      Pool*          pool      ; ///< The pool connections are taken from.
+      Pool           own_pool  ; ///< The pool used if none was set.
+      const Url*     url       ; ///< The URL being fetched.
+      std::string    validator ; ///< The If-Range validator.
+      unsigned char* buffer    ; ///< The buffer of the whole body.
+      std::size_t    total     ; ///< The size of the whole body.
+      Ranges         ranges    ; ///< The ranges of the current download.
+      Threads        threads   ; ///< The thread fetching each range.
+
+      /** Default constructor.
+       */
+      SegmentedDownloadData() ;
+
+      /** Method to fetch a single range, resuming it if it's connection drops.
+       * @param range The range to fetch.
+       */
+      void fetch( Range& range ) ;
+
+      /** Method to make one attempt at the rest of a range.
+       * @param offset The offset of the next byte of the range to fetch. Advanced by every byte received.
+       * @param end The offset one past the last byte of the range.
+       * @return Whether or not the server still serves the same body. False if resuming is pointless.
+       */
+      bool attempt( std::size_t& offset, std::size_t end ) ;
+    };
+
+    SegmentedDownloadData::SegmentedDownloadData()
+    {
+      this->pool   = &this->own_pool ;
+      this->url    = nullptr         ;
+      this->buffer = nullptr         ;
+      this->total  = 0               ;
+    }
+
+    bool SegmentedDownloadData::attempt( std::size_t& offset, std::size_t end )
+    {
+      Request     request ;
+      Parser      parser  ;
+      Packet      packet  ;
+      std::string range   ;
+      const char* content ;
+      const char* slash   ;
+      unsigned    amount  ;
+      bool        closing ;
+
+      Pool::Link* link = this->pool->acquire( *this->url ) ;
+      if( link == nullptr ) return true ;
+
+      range  = "bytes=" ;
+      range += std::to_string( offset  ) ;
+      range += '-' ;
+      range += std::to_string( end - 1 ) ;
+
+      request.setHost( this->url->authority() ) ;
+      request.begin( "GET", this->url->path(), this->url->query() ) ;
+      request.add( "Range", range ) ;
+      if( !this->validator.empty() ) request.add( "If-Range", this->validator ) ;
+      request.end() ;
+      link->send( request.payload(), request.size() ) ;
+
+      while( !parser.parsed() )
+      {
+        packet = link->recieve() ;
+        if( packet.size() == 0 )
+        {
+          this->pool->release( *this->url, link, false ) ;
+          return true ;
+        }
+
+        parser.parse( packet ) ;
+      }
+
+      // Anything but the exact range of the same body means it changed or ranges are not supported.
+      content = parser.value( "Content-Range" ) ;
+      slash   = std::strchr( content, '/' ) ;
+      if( parser.status() != 206 || std::strncmp( content, "bytes ", 6 ) != 0 || std::strtoull( content + 6, nullptr, 10 ) != offset || slash == nullptr || std::strtoull( slash + 1, nullptr, 10 ) != this->total )
+      {
+        this->pool->release( *this->url, link, false ) ;
+        return false ;
+      }
+
+      closing = std::string( parser.value( "Connection" ) ).find( "close" ) != std::string::npos ;
+      packet  = parser.leftover() ;
+
+      while( true )
+      {
+        amount = static_cast<unsigned>( std::min<std::size_t>( end - offset, packet.size() ) ) ;
+        std::memcpy( this->buffer + offset, packet.payload(), amount ) ;
+        offset += amount ;
+
+        if( offset == end ) break ;
+
+        packet = link->recieve( static_cast<unsigned>( std::min<std::size_t>( end - offset, ygg::PACKET_SIZE ) ) ) ;
+        if( packet.size() == 0 )
+        {
+          this->pool->release( *this->url, link, false ) ;
+          return true ;
+        }
+      }
+
+      this->pool->release( *this->url, link, !closing ) ;
+      return true ;
+    }
+
+    void SegmentedDownloadData::fetch( Range& range )
+    {
+      std::size_t offset = range.begin ;
+
+      for( unsigned attempt = 0; attempt < RANGE_ATTEMPTS && offset < range.end; attempt++ )
+      {
+        if( !this->attempt( offset, range.end ) ) break ;
+      }
+
+      range.success = offset == range.end ;
+    }
+
+    SegmentedDownload::SegmentedDownload()
+    {
+      this->segmented_data = new SegmentedDownloadData() ;
+    }
+
+    SegmentedDownload::~SegmentedDownload()
+    {
+      this->wait() ;
+      delete this->segmented_data ;
+    }
+
+    void SegmentedDownload::setPool( Pool& pool )
+    {
+      data().pool = &pool ;
+    }
+
+    void SegmentedDownload::start( const Url& url, const char* validator, std::size_t total, unsigned char* buffer, std::size_t begin, std::size_t end, unsigned parts )
+    {
+      std::size_t size ;
+
+      this->wait() ;
+
+      data().url       = &url      ;
+      data().validator = validator ;
+      data().buffer    = buffer    ;
+      data().total     = total     ;
+      data().ranges.clear() ;
+
+      parts = std::max( 1u, parts ) ;
+      size  = ( end - begin + parts - 1 ) / parts ;
+      for( std::size_t offset = begin; offset < end; offset += size )
+      {
+        data().ranges.push_back( { offset, std::min( offset + size, end ), false } ) ;
+      }
+
+      // The ranges vector is not touched again until every thread is joined, so each thread can hold onto it's range.
+      for( auto& range : data().ranges )
+      {
+        data().threads.emplace_back( [this, &range]() { data().fetch( range ) ; } ) ;
+      }
+    }
+
+    bool SegmentedDownload::wait()
+    {
+      bool success = true ;
+
+      for( auto& thread : data().threads ) thread.join() ;
+      data().threads.clear() ;
+
+      for( const auto& range : data().ranges ) success = success && range.success ;
+
+      data().ranges.clear() ;
+
+      return success ;
+    }
+
+    SegmentedDownloadData& SegmentedDownload::data()
+    {
+      return *this->segmented_data ;
+    }
+
+    const SegmentedDownloadData& SegmentedDownload::data() const
+    {
+      return *this->segmented_data ;
+    }
+  }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Segmented.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 9, 2021, 9:12 PM
+ */
+
+#ifndef YGGDRASIL_SEGMENTED_H
+#define YGGDRASIL_SEGMENTED_H
+
+#include <cstddef>
+
+namespace ygg
+{
+  namespace http
+  {
+    class Url  ;
+    class Pool ;
+
+    /** Class to fetch a span of a body as byte ranges in parallel, each over it's own pooled connection.
+     * Every range is written straight into it's place in one caller-owned buffer, so nothing has to be stitched together after.
+     * A range whose connection drops is resumed from the last byte received.
+     */
+    class SegmentedDownload
+    {
+      public:
+
+        /** Default constructor.
+         */
+        SegmentedDownload() ;
+
+        /** Default deconstructor. Waits for any running ranges.
+         */
+        ~SegmentedDownload() ;
+
+        /** Method to set the pool the ranges take their connections from.
+         * @param pool The pool to use. It must outlive every download.
+         */
+        void setPool( Pool& pool ) ;
+
+        /** Method to start fetching a span of a body in the background.
+         * @param url The URL of the body. The string it views must stay alive until SegmentedDownload::wait() returns.
+         * @param validator The C-string ETag or Last-Modified date the body must still match, sent as If-Range. Empty to skip the check.
+         * @param total The size of the whole body, which every range response must agree with.
+         * @param buffer The buffer holding the whole body. Bytes are written at their offset in the body.
+         * @param begin The offset of the first byte to fetch.
+         * @param end The offset one past the last byte to fetch.
+         * @param parts The amount of ranges to split the span into.
+         */
+        void start( const Url& url, const char* validator, std::size_t total, unsigned char* buffer, std::size_t begin, std::size_t end, unsigned parts ) ;
+
+        /** Method to wait for every range of the last download to finish.
+         * @return Whether or not every byte of the span was fetched.
+         */
+        bool wait() ;
+
+      private:
+
+        /** The forward declared structure containing this object's data.
+         */
+        struct SegmentedDownloadData *segmented_data ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        SegmentedDownloadData& data() ;
+
+        /** Method to retrieve a reference to this object's internal data structure.
+         * @return A reference to this object's internal data structure.
+         */
+        const SegmentedDownloadData& data() const ;
+    };
+  }
+}
+
+#endif /* SEGMENTED_H */
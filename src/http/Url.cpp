@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Url.cpp
+ * Author: Jordan Hendl
+ *
+ * Created on February 5, 2021, 7:20 PM
+ */
+
+#include "Url.h"
+#include <unordered_map>
+#include <string>
+#include <mutex>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** The scheme used when a URL does not have one.
+     */
+    static const std::string_view DEFAULT_SCHEME = "http" ;
+
+    /** The path used when a URL does not have one.
+     */
+    static const std::string_view DEFAULT_PATH = "/" ;
+
+    /** The interned origins of every URL that has asked for a key, and the lock guarding them.
+     */
+    static std::unordered_map<std::string, unsigned> origins      ;
+    static std::mutex                                 origins_lock ;
+
+    /** Function to compare two strings, ignoring the case of ASCII letters.
+     * @param first The first string to compare.
+     * @param second The second string to compare.
+     * @return Whether or not the strings are equal.
+     */
+    static bool equals( std::string_view first, std::string_view second ) ;
+
+    /** Function to lower the case of an ASCII letter.
+     * @param character The character to lower.
+     * @return The lower-case character.
+     */
+    static char lower( char character ) ;
+
+    /** Function to check whether or not a character may appear in a scheme.
+     * @param character The character to check.
+     * @param first Whether or not the character is the first of the scheme, which must be a letter.
+     * @return Whether or not the character is allowed.
+     */
+    static bool isScheme( char character, bool first ) ;
+
+    /** Function to check whether or not a character can never appear in a URL, e.g. whitespace.
+     * @param character The character to check.
+     * @return Whether or not the character is forbidden.
+     */
+    static bool isForbidden( char character ) ;
+
+    char lower( char character )
+    {
+      return character >= 'A' && character <= 'Z' ? static_cast<char>( character - 'A' + 'a' ) : character ;
+    }
+
+    bool equals( std::string_view first, std::string_view second )
+    {
+      if( first.size() != second.size() ) return false ;
+
+      for( std::size_t index = 0; index < first.size(); index++ )
+      {
+        if( lower( first[ index ] ) != lower( second[ index ] ) ) return false ;
+      }
+
+      return true ;
+    }
+
+    bool isScheme( char character, bool first )
+    {
+      const bool letter = ( character >= 'a' && character <= 'z' ) || ( character >= 'A' && character <= 'Z' ) ;
+
+      if( first ) return letter ;
+      return letter || ( character >= '0' && character <= '9' ) || character == '+' || character == '-' || character == '.' ;
+    }
+
+    bool isForbidden( char character )
+    {
+      return static_cast<unsigned char>( character ) <= 0x20 || character == 0x7F ;
+    }
+
+    Url::Url()
+    {
+      this->url_port   = 0     ;
+      this->url_secure = false ;
+      this->url_valid  = false ;
+    }
+
+    Url::Url( std::string_view url )
+    {
+      this->parse( url ) ;
+    }
+
+    bool Url::parse( std::string_view url )
+    {
+      std::size_t      position ;
+      std::size_t      start    ;
+      std::size_t      at       ;
+      std::string_view port     ;
+      unsigned         value    ;
+
+      *this = Url() ;
+
+      // The scheme is only present when followed by "://", otherwise the URL starts at the host.
+      position = 0 ;
+      while( position < url.size() && isScheme( url[ position ], position == 0 ) ) position++ ;
+
+      if( position != 0 && url.substr( position, 3 ) == "://" )
+      {
+        this->url_scheme = url.substr( 0, position ) ;
+        position += 3 ;
+      }
+      else
+      {
+        this->url_scheme = DEFAULT_SCHEME ;
+        position = 0 ;
+      }
+
+      if     ( equals( this->url_scheme, "http"  ) ) { this->url_port = 80  ; this->url_secure = false ; }
+      else if( equals( this->url_scheme, "https" ) ) { this->url_port = 443 ; this->url_secure = true  ; }
+      else return false ;
+
+      // The authority runs until the path, query or fragment. The last '@' ends the user information.
+      start = position       ;
+      at    = std::string_view::npos ;
+      for( ; position < url.size() && url[ position ] != '/' && url[ position ] != '?' && url[ position ] != '#'; position++ )
+      {
+        if( isForbidden( url[ position ] ) ) return false ;
+        if( url[ position ] == '@'         ) at = position ;
+      }
+
+      if( at != std::string_view::npos )
+      {
+        this->url_userinfo = url.substr( start, at - start ) ;
+        start = at + 1 ;
+      }
+
+      this->url_authority = url.substr( start, position - start ) ;
+      if( this->url_authority.empty() ) return false ;
+
+      // IPv6 literals are bracketed, as they contain colons of their own.
+      if( this->url_authority[ 0 ] == '[' )
+      {
+        at = this->url_authority.find( ']' ) ;
+        if( at == std::string_view::npos ) return false ;
+
+        this->url_host = this->url_authority.substr( 1, at - 1 ) ;
+        port           = this->url_authority.substr( at + 1    ) ;
+      }
+      else
+      {
+        at             = this->url_authority.find( ':' ) ;
+        this->url_host = this->url_authority.substr( 0, at ) ;
+        port           = at != std::string_view::npos ? this->url_authority.substr( at ) : std::string_view() ;
+      }
+
+      if( this->url_host.empty() ) return false ;
+
+      // An empty port, e.g. "example.org:", means the scheme's default.
+      if( !port.empty() )
+      {
+        if( port[ 0 ] != ':' ) return false ;
+
+        value = 0 ;
+        for( std::size_t index = 1; index < port.size(); index++ )
+        {
+          if( port[ index ] < '0' || port[ index ] > '9' ) return false ;
+
+          value = value * 10 + static_cast<unsigned>( port[ index ] - '0' ) ;
+          if( value > 65535 ) return false ;
+        }
+
+        if( port.size() > 1 ) this->url_port = value ;
+      }
+
+      // The path, query & fragment follow in that order, each optional.
+      start = position ;
+      for( ; position < url.size() && url[ position ] != '?' && url[ position ] != '#'; position++ ) if( isForbidden( url[ position ] ) ) return false ;
+      this->url_path = position != start ? url.substr( start, position - start ) : DEFAULT_PATH ;
+
+      if( position < url.size() && url[ position ] == '?' )
+      {
+        start = ++position ;
+        for( ; position < url.size() && url[ position ] != '#'; position++ ) if( isForbidden( url[ position ] ) ) return false ;
+        this->url_query = url.substr( start, position - start ) ;
+      }
+
+      if( position < url.size() && url[ position ] == '#' )
+      {
+        this->url_fragment = url.substr( position + 1 ) ;
+      }
+
+      this->url_valid = true ;
+      return true ;
+    }
+
+    bool Url::valid() const
+    {
+      return this->url_valid ;
+    }
+
+    std::string_view Url::scheme() const
+    {
+      return this->url_scheme ;
+    }
+
+    std::string_view Url::userinfo() const
+    {
+      return this->url_userinfo ;
+    }
+
+    std::string_view Url::host() const
+    {
+      return this->url_host ;
+    }
+
+    std::string_view Url::authority() const
+    {
+      return this->url_authority ;
+    }
+
+    std::string_view Url::path() const
+    {
+      return this->url_path ;
+    }
+
+    std::string_view Url::query() const
+    {
+      return this->url_query ;
+    }
+
+    std::string_view Url::fragment() const
+    {
+      return this->url_fragment ;
+    }
+
+    unsigned Url::port() const
+    {
+      return this->url_port ;
+    }
+
+    bool Url::secure() const
+    {
+      return this->url_secure ;
+    }
+
+    unsigned Url::key() const
+    {
+      // The origin is built in a reused buffer, so that looking up a known origin does not allocate.
+      thread_local std::string origin ;
+
+      if( !this->url_valid ) return 0 ;
+
+      origin.clear() ;
+      origin += this->url_secure ? "https://" : "http://" ;
+      for( char character : this->url_host ) origin += lower( character ) ;
+      origin += ':' ;
+      origin += std::to_string( this->url_port ) ;
+
+      std::lock_guard<std::mutex> lock( origins_lock ) ;
+
+      const auto iter = origins.find( origin ) ;
+      if( iter != origins.end() ) return iter->second ;
+
+      return origins.emplace( origin, static_cast<unsigned>( origins.size() + 1 ) ).first->second ;
+    }
+  }
+}
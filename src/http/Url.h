@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021 Jordan Hendl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   Url.h
+ * Author: Jordan Hendl
+ *
+ * Created on February 5, 2021, 7:20 PM
+ */
+
+#ifndef YGGDRASIL_URL_H
+#define YGGDRASIL_URL_H
+
+#include <string_view>
+
+namespace ygg
+{
+  namespace http
+  {
+    /** Class to view the parts of an absolute URL (RFC 3986), without copying it.
+     * Every part is a view into the parsed string, so the string must outlive this object.
+     * A URL without a scheme, e.g. "example.org/image.png", is treated as "http".
+     */
+    class Url
+    {
+      public:
+
+        /** Default constructor. An empty URL is not valid.
+         */
+        Url() ;
+
+        /** Constructor to parse a URL.
+         * @param url The URL to parse.
+         */
+        explicit Url( std::string_view url ) ;
+
+        /** Method to parse a URL, replacing the last one.
+         * @param url The URL to parse.
+         * @return Whether or not the URL was valid. Only the "http" & "https" schemes are supported.
+         */
+        bool parse( std::string_view url ) ;
+
+        /** Method to retrieve whether or not the last parsed URL was valid.
+         * @return Whether or not this object holds a valid URL.
+         */
+        bool valid() const ;
+
+        /** Method to retrieve the scheme of the URL, e.g. "https".
+         * @return The scheme as written, without the "://".
+         */
+        std::string_view scheme() const ;
+
+        /** Method to retrieve the user information of the URL, e.g. "user:password".
+         * @return The user information without the '@', or an empty view if there is none.
+         */
+        std::string_view userinfo() const ;
+
+        /** Method to retrieve the host of the URL.
+         * @note IPv6 literals are returned without their brackets.
+         * @return The host as written.
+         */
+        std::string_view host() const ;
+
+        /** Method to retrieve the host & explicit port of the URL, as sent in the HOST header.
+         * @return The host & port, without the user information.
+         */
+        std::string_view authority() const ;
+
+        /** Method to retrieve the path of the URL.
+         * @return The path, or "/" if the URL has none.
+         */
+        std::string_view path() const ;
+
+        /** Method to retrieve the query of the URL.
+         * @return The query without the '?', or an empty view if there is none.
+         */
+        std::string_view query() const ;
+
+        /** Method to retrieve the fragment of the URL.
+         * @return The fragment without the '#', or an empty view if there is none.
+         */
+        std::string_view fragment() const ;
+
+        /** Method to retrieve the port to connect to.
+         * @return The explicit port of the URL, or the default port of it's scheme.
+         */
+        unsigned port() const ;
+
+        /** Method to retrieve whether or not the connection for this URL uses TLS.
+         * @return Whether or not the scheme is "https".
+         */
+        bool secure() const ;
+
+        /** Method to retrieve a key identifying the origin (scheme, host & port) of this URL.
+         * Every URL of the same origin gets the same key for the life of the program, so it can be used to find a connection pool or cache.
+         * @note Only the first lookup of an origin allocates.
+         * @return The interned key of this URL's origin, or 0 if the URL is not valid.
+         */
+        unsigned key() const ;
+
+      private:
+
+        std::string_view url_scheme    ; ///< The scheme of the URL.
+        std::string_view url_userinfo  ; ///< The user information of the URL.
+        std::string_view url_host      ; ///< The host of the URL.
+        std::string_view url_authority ; ///< The host & port of the URL.
+        std::string_view url_path      ; ///< The path of the URL.
+        std::string_view url_query     ; ///< The query of the URL.
+        std::string_view url_fragment  ; ///< The fragment of the URL.
+        unsigned         url_port      ; ///< The port to connect to.
+        bool             url_secure    ; ///< Whether or not the scheme uses TLS.
+        bool             url_valid     ; ///< Whether or not the URL was valid.
+    };
+  }
+}
+
+#endif /* URL_H */
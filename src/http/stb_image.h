@@ -242,6 +242,12 @@ RECENT REVISION HISTORY:
 // you have issues compiling it, you can disable it entirely by
 // defining STBI_NO_SIMD.
 //
+// The same SSE2 test picks SIMD unfiltering of 8-bit RGB & RGBA PNG rows.
+// Built with GCC or Clang, the JPEG IDCT, YCbCr conversion & 2x2 chroma
+// upsampling, & some of the PNG filters, also have AVX2 versions, picked at
+// run time on CPUs that report it; so a baseline x86-64 build still uses
+// them where it can. define STBI_NO_AVX2 to leave everything at SSE2.
+//
 // ===========================================================================
 //
 // HDR image support   (disable by defining STBI_NO_HDR)
@@ -296,6 +302,13 @@ RECENT REVISION HISTORY:
 //
 // ADDITIONAL CONFIGURATION
 //
+//  - On 64-bit little-endian targets, zlib streams are inflated by a fast
+//    loop that refills a 64-bit bit buffer 8 bytes at a time, decodes up to
+//    two literals per table lookup and copies matches 8 or 16 bytes at a
+//    time. Its output is byte-identical to the plain decoder, which still
+//    handles the ends of streams & anything unusual. #define
+//    STBI_NO_FAST_INFLATE to always use the plain decoder.
+//
 //  - You can suppress implementation of any of the decoders to reduce
 //    your code footprint by #defining one or more of the following
 //    symbols before creating the implementation.
@@ -392,6 +405,19 @@ typedef struct
 STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer, int len   , int *x, int *y, int *channels_in_file, int desired_channels);
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk  , void *user, int *x, int *y, int *channels_in_file, int desired_channels);
 
+// as stbi_load_from_memory, but JPEGs are decoded at 1/2, 1/4 or 1/8 of their size
+// for a jpeg_scale of 1, 2 or 3, without ever building the full size image. the
+// returned size is the scaled one, rounded up. other formats ignore jpeg_scale.
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int jpeg_scale);
+
+// called with each row of a JPEG as soon as it is written to the output, while it
+// is still in cache, so the caller can rework it in place. rows come in order, with
+// width pixels of the output's channels each. other formats never call it.
+typedef void (*stbi_row_callback)(void *user, stbi_uc *row, int width, int channels);
+
+// as stbi_load_from_memory_scaled, calling row for every finished JPEG row
+STBIDEF stbi_uc *stbi_load_from_memory_ex(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int jpeg_scale, stbi_row_callback row, void *user);
+
 #ifndef STBI_NO_STDIO
 STBIDEF stbi_uc *stbi_load            (char const *filename, int *x, int *y, int *channels_in_file, int desired_channels);
 STBIDEF stbi_uc *stbi_load_from_file  (FILE *f, int *x, int *y, int *channels_in_file, int desired_channels);
@@ -618,6 +644,12 @@ typedef uint32_t stbi__uint32;
 typedef int32_t  stbi__int32;
 #endif
 
+#if defined(_MSC_VER) && _MSC_VER < 1600
+typedef unsigned __int64 stbi__uint64;
+#else
+typedef unsigned long long stbi__uint64;
+#endif
+
 // should produce compiler error if size is wrong
 typedef unsigned char validate_uint32[sizeof(stbi__uint32)==4 ? 1 : -1];
 
@@ -717,7 +749,7 @@ static int stbi__cpuid3(void)
 
 #define STBI_SIMD_ALIGN(type, name) __declspec(align(16)) type name
 
-#if !defined(STBI_NO_JPEG) && defined(STBI_SSE2)
+#if (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)) && defined(STBI_SSE2)
 static int stbi__sse2_available(void)
 {
    int info3 = stbi__cpuid3();
@@ -728,7 +760,7 @@ static int stbi__sse2_available(void)
 #else // assume GCC-style if not VC++
 #define STBI_SIMD_ALIGN(type, name) type name __attribute__((aligned(16)))
 
-#if !defined(STBI_NO_JPEG) && defined(STBI_SSE2)
+#if (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)) && defined(STBI_SSE2)
 static int stbi__sse2_available(void)
 {
    // If we're even attempting to compile this on GCC/Clang, that means
@@ -741,6 +773,18 @@ static int stbi__sse2_available(void)
 #endif
 #endif
 
+// AVX2 kernels are compiled for that target alone & picked at run time, so
+// the rest of the library still runs on any SSE2 machine
+#if (!defined(STBI_NO_JPEG) || !defined(STBI_NO_PNG)) && defined(STBI_SSE2) && defined(__GNUC__) && !defined(STBI_NO_AVX2)
+#define STBI__AVX2
+#include <immintrin.h>
+#define STBI__AVX2_TARGET __attribute__((target("avx2")))
+static int stbi__avx2_available(void)
+{
+   return __builtin_cpu_supports("avx2");
+}
+#endif
+
 // ARM NEON
 #if defined(STBI_NO_SIMD) && defined(STBI_NEON)
 #undef STBI_NEON
@@ -781,6 +825,10 @@ typedef struct
 
    stbi_uc *img_buffer, *img_buffer_end;
    stbi_uc *img_buffer_original, *img_buffer_original_end;
+
+   int jpeg_scale; // log2 of the factor to shrink JPEGs by while decoding, 0..3
+   stbi_row_callback row_callback; // called with each finished JPEG row, if set
+   void *row_user;
 } stbi__context;
 
 
@@ -792,6 +840,9 @@ static void stbi__start_mem(stbi__context *s, stbi_uc const *buffer, int len)
    s->io.read = NULL;
    s->read_from_callbacks = 0;
    s->callback_already_read = 0;
+   s->jpeg_scale = 0;
+   s->row_callback = NULL;
+   s->row_user = NULL;
    s->img_buffer = s->img_buffer_original = (stbi_uc *) buffer;
    s->img_buffer_end = s->img_buffer_original_end = (stbi_uc *) buffer+len;
 }
@@ -804,6 +855,9 @@ static void stbi__start_callbacks(stbi__context *s, stbi_io_callbacks *c, void *
    s->buflen = sizeof(s->buffer_start);
    s->read_from_callbacks = 1;
    s->callback_already_read = 0;
+   s->jpeg_scale = 0;
+   s->row_callback = NULL;
+   s->row_user = NULL;
    s->img_buffer = s->img_buffer_original = s->buffer_start;
    stbi__refill_buffer(s);
    s->img_buffer_original_end = s->img_buffer_end;
@@ -1374,6 +1428,22 @@ STBIDEF stbi_uc *stbi_load_from_memory(stbi_uc const *buffer, int len, int *x, i
    return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
 }
 
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int jpeg_scale)
+{
+   return stbi_load_from_memory_ex(buffer,len,x,y,comp,req_comp,jpeg_scale,NULL,NULL);
+}
+
+STBIDEF stbi_uc *stbi_load_from_memory_ex(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int jpeg_scale, stbi_row_callback row, void *user)
+{
+   stbi__context s;
+   if (jpeg_scale < 0 || jpeg_scale > 3) return stbi__errpuc("bad jpeg_scale", "Internal error");
+   stbi__start_mem(&s,buffer,len);
+   s.jpeg_scale = jpeg_scale;
+   s.row_callback = row;
+   s.row_user = user;
+   return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
+}
+
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk, void *user, int *x, int *y, int *comp, int req_comp)
 {
    stbi__context s;
@@ -1933,6 +2003,7 @@ typedef struct
 
    int scan_n, order[4];
    int restart_interval, todo;
+   int scale; // log2 of the factor blocks are shrunk by as they are stored, 0..3
 
 // kernels
    void (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
@@ -2629,6 +2700,180 @@ static void stbi__idct_simd(stbi_uc *out, int out_stride, short data[64])
 #undef dct_pass
 }
 
+#ifdef STBI__AVX2
+// avx2 integer IDCT. the same passes & transposes as the sse2 version, but
+// the 32-bit half of each pass works on whole rows of 8 lanes at once rather
+// than two halves of 4, so it's just as bit-identical to the generic version.
+STBI__AVX2_TARGET static void stbi__idct_avx2(stbi_uc *out, int out_stride, short data[64])
+{
+   __m128i row0, row1, row2, row3, row4, row5, row6, row7;
+   __m128i tmp;
+
+   // dot product constant: even elems=x, odd elems=y
+   #define dct_const(x,y)  _mm256_set1_epi32((int) (((unsigned) (y) << 16) | (unsigned short) (x)))
+
+   // out(0) = c0[even]*x + c0[odd]*y   (c0, x, y 16-bit, out 32-bit)
+   // out(1) = c1[even]*x + c1[odd]*y
+   #define dct_rot(out0,out1, x,y,c0,c1) \
+      __m256i c0##xy = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16((x),(y))), _mm_unpackhi_epi16((x),(y)), 1); \
+      __m256i out0 = _mm256_madd_epi16(c0##xy, c0); \
+      __m256i out1 = _mm256_madd_epi16(c0##xy, c1)
+
+   // out = in << 12  (in 16-bit, out 32-bit)
+   #define dct_widen(out, in) \
+      __m256i out = _mm256_slli_epi32(_mm256_cvtepi16_epi32(in), 12)
+
+   // wide add
+   #define dct_wadd(out, a, b) \
+      __m256i out = _mm256_add_epi32(a, b)
+
+   // wide sub
+   #define dct_wsub(out, a, b) \
+      __m256i out = _mm256_sub_epi32(a, b)
+
+   // butterfly a/b, add bias, then shift by "s" and pack. packing works within
+   // 128-bit lanes, so the 64-bit quarters are put back in order after.
+   #define dct_bfly32o(out0, out1, a,b,bias,s) \
+      { \
+         __m256i abiased = _mm256_add_epi32(a, bias); \
+         dct_wadd(sum, abiased, b); \
+         dct_wsub(dif, abiased, b); \
+         __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_srai_epi32(sum, s), _mm256_srai_epi32(dif, s)), 0xd8); \
+         out0 = _mm256_castsi256_si128(packed); \
+         out1 = _mm256_extracti128_si256(packed, 1); \
+      }
+
+   // 8-bit interleave step (for transposes)
+   #define dct_interleave8(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi8(a, b); \
+      b = _mm_unpackhi_epi8(tmp, b)
+
+   // 16-bit interleave step (for transposes)
+   #define dct_interleave16(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi16(a, b); \
+      b = _mm_unpackhi_epi16(tmp, b)
+
+   #define dct_pass(bias,shift) \
+      { \
+         /* even part */ \
+         dct_rot(t2e,t3e, row2,row6, rot0_0,rot0_1); \
+         __m128i sum04 = _mm_add_epi16(row0, row4); \
+         __m128i dif04 = _mm_sub_epi16(row0, row4); \
+         dct_widen(t0e, sum04); \
+         dct_widen(t1e, dif04); \
+         dct_wadd(x0, t0e, t3e); \
+         dct_wsub(x3, t0e, t3e); \
+         dct_wadd(x1, t1e, t2e); \
+         dct_wsub(x2, t1e, t2e); \
+         /* odd part */ \
+         dct_rot(y0o,y2o, row7,row3, rot2_0,rot2_1); \
+         dct_rot(y1o,y3o, row5,row1, rot3_0,rot3_1); \
+         __m128i sum17 = _mm_add_epi16(row1, row7); \
+         __m128i sum35 = _mm_add_epi16(row3, row5); \
+         dct_rot(y4o,y5o, sum17,sum35, rot1_0,rot1_1); \
+         dct_wadd(x4, y0o, y4o); \
+         dct_wadd(x5, y1o, y5o); \
+         dct_wadd(x6, y2o, y5o); \
+         dct_wadd(x7, y3o, y4o); \
+         dct_bfly32o(row0,row7, x0,x7,bias,shift); \
+         dct_bfly32o(row1,row6, x1,x6,bias,shift); \
+         dct_bfly32o(row2,row5, x2,x5,bias,shift); \
+         dct_bfly32o(row3,row4, x3,x4,bias,shift); \
+      }
+
+   __m256i rot0_0 = dct_const(stbi__f2f(0.5411961f), stbi__f2f(0.5411961f) + stbi__f2f(-1.847759065f));
+   __m256i rot0_1 = dct_const(stbi__f2f(0.5411961f) + stbi__f2f( 0.765366865f), stbi__f2f(0.5411961f));
+   __m256i rot1_0 = dct_const(stbi__f2f(1.175875602f) + stbi__f2f(-0.899976223f), stbi__f2f(1.175875602f));
+   __m256i rot1_1 = dct_const(stbi__f2f(1.175875602f), stbi__f2f(1.175875602f) + stbi__f2f(-2.562915447f));
+   __m256i rot2_0 = dct_const(stbi__f2f(-1.961570560f) + stbi__f2f( 0.298631336f), stbi__f2f(-1.961570560f));
+   __m256i rot2_1 = dct_const(stbi__f2f(-1.961570560f), stbi__f2f(-1.961570560f) + stbi__f2f( 3.072711026f));
+   __m256i rot3_0 = dct_const(stbi__f2f(-0.390180644f) + stbi__f2f( 2.053119869f), stbi__f2f(-0.390180644f));
+   __m256i rot3_1 = dct_const(stbi__f2f(-0.390180644f), stbi__f2f(-0.390180644f) + stbi__f2f( 1.501321110f));
+
+   // rounding biases in column/row passes, see stbi__idct_block for explanation.
+   __m256i bias_0 = _mm256_set1_epi32(512);
+   __m256i bias_1 = _mm256_set1_epi32(65536 + (128<<17));
+
+   // load
+   row0 = _mm_load_si128((const __m128i *) (data + 0*8));
+   row1 = _mm_load_si128((const __m128i *) (data + 1*8));
+   row2 = _mm_load_si128((const __m128i *) (data + 2*8));
+   row3 = _mm_load_si128((const __m128i *) (data + 3*8));
+   row4 = _mm_load_si128((const __m128i *) (data + 4*8));
+   row5 = _mm_load_si128((const __m128i *) (data + 5*8));
+   row6 = _mm_load_si128((const __m128i *) (data + 6*8));
+   row7 = _mm_load_si128((const __m128i *) (data + 7*8));
+
+   // column pass
+   dct_pass(bias_0, 10);
+
+   {
+      // 16bit 8x8 transpose pass 1
+      dct_interleave16(row0, row4);
+      dct_interleave16(row1, row5);
+      dct_interleave16(row2, row6);
+      dct_interleave16(row3, row7);
+
+      // transpose pass 2
+      dct_interleave16(row0, row2);
+      dct_interleave16(row1, row3);
+      dct_interleave16(row4, row6);
+      dct_interleave16(row5, row7);
+
+      // transpose pass 3
+      dct_interleave16(row0, row1);
+      dct_interleave16(row2, row3);
+      dct_interleave16(row4, row5);
+      dct_interleave16(row6, row7);
+   }
+
+   // row pass
+   dct_pass(bias_1, 17);
+
+   {
+      // pack
+      __m128i p0 = _mm_packus_epi16(row0, row1); // a0a1a2a3...a7b0b1b2b3...b7
+      __m128i p1 = _mm_packus_epi16(row2, row3);
+      __m128i p2 = _mm_packus_epi16(row4, row5);
+      __m128i p3 = _mm_packus_epi16(row6, row7);
+
+      // 8bit 8x8 transpose pass 1
+      dct_interleave8(p0, p2); // a0e0a1e1...
+      dct_interleave8(p1, p3); // c0g0c1g1...
+
+      // transpose pass 2
+      dct_interleave8(p0, p1); // a0c0e0g0...
+      dct_interleave8(p2, p3); // b0d0f0h0...
+
+      // transpose pass 3
+      dct_interleave8(p0, p2); // a0b0c0d0...
+      dct_interleave8(p1, p3); // a4b4c4d4...
+
+      // store
+      _mm_storel_epi64((__m128i *) out, p0); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p0, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p2); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p2, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p1); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p1, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p3); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p3, 0x4e));
+   }
+
+#undef dct_const
+#undef dct_rot
+#undef dct_widen
+#undef dct_wadd
+#undef dct_wsub
+#undef dct_bfly32o
+#undef dct_interleave8
+#undef dct_interleave16
+#undef dct_pass
+}
+#endif // STBI__AVX2
+
 #endif // STBI_SSE2
 
 #ifdef STBI_NEON
@@ -2873,6 +3118,74 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
+// 4 point inverse transform of the 4 lowest frequencies, with each frequency weighted
+// by how much of it survives averaging the full 8 point output down in pairs
+static void stbi__idct_4(int *o, int s0, int s1, int s2, int s3)
+{
+   int p1 = stbi__f2f(0.35355339) * s0, p2 = stbi__f2f(0.32664074) * s2;
+   int e0 = p1 + p2, e1 = p1 - p2;
+   int o0 = stbi__f2f(0.45306372) * s1 + stbi__f2f(0.15909482) * s3;
+   int o1 = stbi__f2f(0.18766514) * s1 - stbi__f2f(0.38408888) * s3;
+   o[0] = e0 + o0;
+   o[1] = e1 + o1;
+   o[2] = e1 - o1;
+   o[3] = e0 - o0;
+}
+
+// store a reduced block straight from it's lowest frequencies, never building the
+// full 8x8 block: a 4x4 or 2x2 inverse transform, or just the DC level for 1x1.
+// frequencies above the reduced size are dropped rather than folded into the
+// average, which costs a level or two against averaging the full transform down
+static void stbi__idct_reduced(stbi__jpeg *z, stbi_uc *out, int out_stride, short data[64])
+{
+   int i, j, t[16], o[4];
+
+   if (z->scale == 3) {
+      // the dequantized DC coefficient is 8x the block's mean level
+      int v = ((data[0] + 4) >> 3) + 128;
+      out[0] = stbi__clamp(v);
+      return;
+   }
+
+   if (z->scale == 2) {
+      // 2 point transforms, the lowest frequency weighted for a 4 pixel average
+      for (i=0; i < 2; ++i) {
+         int e = stbi__f2f(0.35355339) * data[i], d = stbi__f2f(0.32036443) * data[8+i];
+         t[i] = (e + d + 512) >> 10;
+         t[2+i] = (e - d + 512) >> 10;
+      }
+      for (j=0; j < 2; ++j) {
+         int e = stbi__f2f(0.35355339) * t[j*2], d = stbi__f2f(0.32036443) * t[j*2+1];
+         out[j*out_stride + 0] = stbi__clamp(((e + d + (1 << 13)) >> 14) + 128);
+         out[j*out_stride + 1] = stbi__clamp(((e - d + (1 << 13)) >> 14) + 128);
+      }
+      return;
+   }
+
+   // columns, then rows: constants are scaled up by 1<<12, and the columns keep 1<<2 of it
+   for (i=0; i < 4; ++i) {
+      stbi__idct_4(o, data[i], data[8+i], data[16+i], data[24+i]);
+      for (j=0; j < 4; ++j)
+         t[j*4 + i] = (o[j] + 512) >> 10;
+   }
+   for (j=0; j < 4; ++j) {
+      stbi__idct_4(o, t[j*4], t[j*4+1], t[j*4+2], t[j*4+3]);
+      for (i=0; i < 4; ++i)
+         out[j*out_stride + i] = stbi__clamp(((o[i] + (1 << 13)) >> 14) + 128);
+   }
+}
+
+// inverse transform the block at (bx,by), in 8x8 blocks, into it's component
+static void stbi__jpeg_store_block(stbi__jpeg *z, int n, int bx, int by, short data[64])
+{
+   int stride = z->img_comp[n].w2 >> z->scale;
+   stbi_uc *out = z->img_comp[n].data + stride*((by*8) >> z->scale) + ((bx*8) >> z->scale);
+   if (z->scale == 0)
+      z->idct_block_kernel(out, stride, data);
+   else
+      stbi__idct_reduced(z, out, stride, data);
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
 {
    stbi__jpeg_reset(z);
@@ -2891,7 +3204,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__jpeg_store_block(z, n, i, j, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2915,11 +3228,11 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   // by the basic H and V specified for the component
                   for (y=0; y < z->img_comp[n].v; ++y) {
                      for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
+                        int x2 = (i*z->img_comp[n].h + x);
+                        int y2 = (j*z->img_comp[n].v + y);
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
+                        stbi__jpeg_store_block(z, n, x2, y2, data);
                      }
                   }
                }
@@ -3016,7 +3329,7 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__jpeg_store_block(z, n, i, j, data);
             }
          }
       }
@@ -3253,7 +3566,7 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
-      z->img_comp[i].raw_data = stbi__malloc_mad2(z->img_comp[i].w2, z->img_comp[i].h2, 15);
+      z->img_comp[i].raw_data = stbi__malloc_mad2(z->img_comp[i].w2 >> z->scale, z->img_comp[i].h2 >> z->scale, 15);
       if (z->img_comp[i].raw_data == NULL)
          return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
       // align blocks for idct using mmx/sse
@@ -3543,6 +3856,84 @@ static stbi_uc *stbi__resample_row_hv_2_simd(stbi_uc *out, stbi_uc *in_near, stb
 }
 #endif
 
+#ifdef STBI__AVX2
+// the sse2 kernel above, 16 pixels at a time
+STBI__AVX2_TARGET static stbi_uc *stbi__resample_row_hv_2_avx2(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
+{
+   // need to generate 2x2 samples for every one in input
+   int i=0,t0,t1;
+
+   if (w == 1) {
+      out[0] = out[1] = stbi__div4(3*in_near[0] + in_far[0] + 2);
+      return out;
+   }
+
+   t1 = 3*in_near[0] + in_far[0];
+   // process groups of 16 pixels for as long as we can.
+   // note we can't handle the last pixel in a row in this loop
+   // because we need to handle the filter boundary conditions.
+   for (; i < ((w-1) & ~15); i += 16) {
+      // load and perform the vertical filtering pass
+      // this uses 3*x + y = 4*x + (y - x)
+      __m256i farw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_far + i)));
+      __m256i nearw = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_near + i)));
+      __m256i diff  = _mm256_sub_epi16(farw, nearw);
+      __m256i nears = _mm256_slli_epi16(nearw, 2);
+      __m256i curr  = _mm256_add_epi16(nears, diff); // current row
+
+      // "prev" & "next" as in the sse2 kernel. byte shifts only work within
+      // 128-bit lanes, so the pixel crossing between the lanes is brought
+      // in by aligning against the other lane.
+      __m256i prv0 = _mm256_alignr_epi8(curr, _mm256_permute2x128_si256(curr, curr, 0x08), 14);
+      __m256i nxt0 = _mm256_alignr_epi8(_mm256_permute2x128_si256(curr, curr, 0x81), curr, 2);
+      __m256i prev = _mm256_insert_epi16(prv0, t1, 0);
+      __m256i next = _mm256_insert_epi16(nxt0, 3*in_near[i+16] + in_far[i+16], 15);
+
+      // horizontal filter, polyphase implementation since it's convenient:
+      // even pixels = 3*cur + prev = cur*4 + (prev - cur)
+      // odd  pixels = 3*cur + next = cur*4 + (next - cur)
+      // note the shared term.
+      __m256i bias = _mm256_set1_epi16(8);
+      __m256i curs = _mm256_slli_epi16(curr, 2);
+      __m256i prvd = _mm256_sub_epi16(prev, curr);
+      __m256i nxtd = _mm256_sub_epi16(next, curr);
+      __m256i curb = _mm256_add_epi16(curs, bias);
+      __m256i even = _mm256_add_epi16(prvd, curb);
+      __m256i odd  = _mm256_add_epi16(nxtd, curb);
+
+      // interleave even and odd pixels, then undo scaling. the interleave &
+      // pack both stay within lanes, so the output comes out in order.
+      __m256i int0 = _mm256_unpacklo_epi16(even, odd);
+      __m256i int1 = _mm256_unpackhi_epi16(even, odd);
+      __m256i de0  = _mm256_srli_epi16(int0, 4);
+      __m256i de1  = _mm256_srli_epi16(int1, 4);
+
+      // pack and write output
+      __m256i outv = _mm256_packus_epi16(de0, de1);
+      _mm256_storeu_si256((__m256i *) (out + i*2), outv);
+
+      // "previous" value for next iter
+      t1 = 3*in_near[i+15] + in_far[i+15];
+   }
+
+   t0 = t1;
+   t1 = 3*in_near[i] + in_far[i];
+   out[i*2] = stbi__div16(3*t1 + t0 + 8);
+
+   for (++i; i < w; ++i) {
+      t0 = t1;
+      t1 = 3*in_near[i]+in_far[i];
+      out[i*2-1] = stbi__div16(3*t0 + t1 + 8);
+      out[i*2  ] = stbi__div16(3*t1 + t0 + 8);
+   }
+   out[w*2-1] = stbi__div4(t1+2);
+
+   STBI_NOTUSED(hs);
+
+   return out;
+}
+#endif
+
 static stbi_uc *stbi__resample_row_generic(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
 {
    // resample with nearest-neighbor
@@ -3717,9 +4108,95 @@ static void stbi__YCbCr_to_RGB_simd(stbi_uc *out, stbi_uc const *y, stbi_uc cons
 }
 #endif
 
+#ifdef STBI__AVX2
+// the sse2 kernel above, 16 pixels at a time, & for step == 3 as well: with
+// pshufb dropping the alpha bytes it's no uglier. the rest are left to it
+STBI__AVX2_TARGET static void stbi__YCbCr_to_RGB_avx2(stbi_uc *out, stbi_uc const *y, stbi_uc const *pcb, stbi_uc const *pcr, int count, int step)
+{
+   int i = 0;
+
+   if (step == 4 || step == 3) {
+      __m128i signflip  = _mm_set1_epi8(-0x80);
+      __m256i cr_const0 = _mm256_set1_epi16(   (short) ( 1.40200f*4096.0f+0.5f));
+      __m256i cr_const1 = _mm256_set1_epi16( - (short) ( 0.71414f*4096.0f+0.5f));
+      __m256i cb_const0 = _mm256_set1_epi16( - (short) ( 0.34414f*4096.0f+0.5f));
+      __m256i cb_const1 = _mm256_set1_epi16(   (short) ( 1.77200f*4096.0f+0.5f));
+      __m256i y_bias = _mm256_set1_epi16(128);
+      __m256i xw = _mm256_set1_epi16(255); // alpha channel
+      __m256i rgb = _mm256_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1, 0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+
+      for (; i+15 < count; i += 16) {
+         // load
+         __m128i y_bytes = _mm_loadu_si128((__m128i *) (y+i));
+         __m128i cr_bytes = _mm_loadu_si128((__m128i *) (pcr+i));
+         __m128i cb_bytes = _mm_loadu_si128((__m128i *) (pcb+i));
+         __m128i cr_biased = _mm_xor_si128(cr_bytes, signflip); // -128
+         __m128i cb_biased = _mm_xor_si128(cb_bytes, signflip); // -128
+
+         // unpack to short (and left-shift cr, cb by 8). the sse2 kernel
+         // unpacks against zero or the y bias; widening, then shifting, is
+         // the same across 16 lanes
+         __m256i yw  = _mm256_or_si256(_mm256_slli_epi16(_mm256_cvtepu8_epi16(y_bytes), 8), y_bias);
+         __m256i crw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(cr_biased), 8);
+         __m256i cbw = _mm256_slli_epi16(_mm256_cvtepu8_epi16(cb_biased), 8);
+
+         // color transform
+         __m256i yws = _mm256_srli_epi16(yw, 4);
+         __m256i cr0 = _mm256_mulhi_epi16(cr_const0, crw);
+         __m256i cb0 = _mm256_mulhi_epi16(cb_const0, cbw);
+         __m256i cb1 = _mm256_mulhi_epi16(cbw, cb_const1);
+         __m256i cr1 = _mm256_mulhi_epi16(crw, cr_const1);
+         __m256i rws = _mm256_add_epi16(cr0, yws);
+         __m256i gwt = _mm256_add_epi16(cb0, yws);
+         __m256i bws = _mm256_add_epi16(yws, cb1);
+         __m256i gws = _mm256_add_epi16(gwt, cr1);
+
+         // descale
+         __m256i rw = _mm256_srai_epi16(rws, 4);
+         __m256i bw = _mm256_srai_epi16(bws, 4);
+         __m256i gw = _mm256_srai_epi16(gws, 4);
+
+         // back to byte, set up for transpose
+         __m256i brb = _mm256_packus_epi16(rw, bw);
+         __m256i gxb = _mm256_packus_epi16(gw, xw);
+
+         // transpose to interleave channels. this works within 128-bit lanes,
+         // leaving pixels 0-3 & 8-11 in o0, & 4-7 & 12-15 in o1
+         __m256i t0 = _mm256_unpacklo_epi8(brb, gxb);
+         __m256i t1 = _mm256_unpackhi_epi8(brb, gxb);
+         __m256i o0 = _mm256_unpacklo_epi16(t0, t1);
+         __m256i o1 = _mm256_unpackhi_epi16(t0, t1);
+
+         // store
+         if (step == 4) {
+            _mm256_storeu_si256((__m256i *) (out + 0), _mm256_permute2x128_si256(o0, o1, 0x20));
+            _mm256_storeu_si256((__m256i *) (out + 32), _mm256_permute2x128_si256(o0, o1, 0x31));
+            out += 64;
+         } else {
+            // 12 bytes of every 16 are wanted; each store runs 4 bytes into
+            // the next, which overwrites them, & the last stops exactly at the end
+            __m256i s0 = _mm256_shuffle_epi8(o0, rgb);
+            __m256i s1 = _mm256_shuffle_epi8(o1, rgb);
+            __m128i last = _mm256_extracti128_si256(s1, 1);
+            int tail = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+            _mm_storeu_si128((__m128i *) (out + 0), _mm256_castsi256_si128(s0));
+            _mm_storeu_si128((__m128i *) (out + 12), _mm256_castsi256_si128(s1));
+            _mm_storeu_si128((__m128i *) (out + 24), _mm256_extracti128_si256(s0, 1));
+            _mm_storel_epi64((__m128i *) (out + 36), last);
+            memcpy(out + 44, &tail, 4);
+            out += 48;
+         }
+      }
+   }
+
+   stbi__YCbCr_to_RGB_simd(out, y + i, pcb + i, pcr + i, count - i, step);
+}
+#endif
+
 // set up the kernels
 static void stbi__setup_jpeg(stbi__jpeg *j)
 {
+   j->scale = 0;
    j->idct_block_kernel = stbi__idct_block;
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
@@ -3732,6 +4209,14 @@ static void stbi__setup_jpeg(stbi__jpeg *j)
    }
 #endif
 
+#ifdef STBI__AVX2
+   if (stbi__avx2_available()) {
+      j->idct_block_kernel = stbi__idct_avx2;
+      j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_avx2;
+      j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_avx2;
+   }
+#endif
+
 #ifdef STBI_NEON
    j->idct_block_kernel = stbi__idct_simd;
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
@@ -3773,6 +4258,19 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
    // load a jpeg image from whichever source, but leave in YCbCr format
    if (!stbi__decode_jpeg_image(z)) { stbi__cleanup_jpeg(z); return NULL; }
 
+   // components were stored shrunk, so everything from here on works at the reduced size
+   if (z->scale) {
+      int k, round = (1 << z->scale) - 1;
+      z->s->img_x = (z->s->img_x + round) >> z->scale;
+      z->s->img_y = (z->s->img_y + round) >> z->scale;
+      for (k=0; k < z->s->img_n; ++k) {
+         z->img_comp[k].x = (z->img_comp[k].x + round) >> z->scale;
+         z->img_comp[k].y = (z->img_comp[k].y + round) >> z->scale;
+         z->img_comp[k].w2 >>= z->scale;
+         z->img_comp[k].h2 >>= z->scale;
+      }
+   }
+
    // determine actual number of components to generate
    n = req_comp ? req_comp : z->s->img_n >= 3 ? 3 : 1;
 
@@ -3912,6 +4410,8 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
                   for (i=0; i < z->s->img_x; ++i) { *out++ = y[i]; *out++ = 255; }
             }
          }
+         if (z->s->row_callback)
+            z->s->row_callback(z->s->row_user, output + n * z->s->img_x * j, z->s->img_x, n);
       }
       stbi__cleanup_jpeg(z);
       *out_x = z->s->img_x;
@@ -3928,6 +4428,7 @@ static void *stbi__jpeg_load(stbi__context *s, int *x, int *y, int *comp, int re
    STBI_NOTUSED(ri);
    j->s = s;
    stbi__setup_jpeg(j);
+   j->scale = s->jpeg_scale;
    result = load_jpeg_image(j, x,y,comp,req_comp);
    STBI_FREE(j);
    return result;
@@ -3981,6 +4482,31 @@ static int stbi__jpeg_info(stbi__context *s, int *x, int *y, int *comp)
 #define STBI__ZFAST_BITS  9 // accelerate all cases in default tables
 #define STBI__ZFAST_MASK  ((1 << STBI__ZFAST_BITS) - 1)
 
+// the fast inflate loop loads 8 bytes at a time into a 64-bit bit buffer,
+// so it needs a 64-bit little-endian target
+#if !defined(STBI_NO_FAST_INFLATE) && (defined(__x86_64__) || defined(_M_X64) || (defined(__aarch64__) && !defined(__AARCH64EB__)) || defined(_M_ARM64))
+#define STBI__ZWIDE
+#endif
+
+#ifdef STBI__ZWIDE
+// wide tables cover longer codes than the fast ones, & literal/length
+// entries hold a pair of literals whenever both codes fit. entries are
+//    bits  0..4  : code bits consumed (0 = not in table, use the plain decoder)
+//    bit   5     : literal, bits 8..15 the first literal, 16..23 the second
+//    bit   6     : length or distance, bits 8..22 the base, 24..27 extra bits
+//    bit   7     : a second literal follows
+#define STBI__ZWIDE_BITS       11
+#define STBI__ZWIDE_DIST_BITS  10
+#define STBI__ZWIDE_LITERAL    0x20
+#define STBI__ZWIDE_MATCH      0x40
+#define STBI__ZWIDE_PAIR       0x80
+// symbols a block decodes the plain way before building the wide tables,
+// so small blocks are over before they would pay for them
+#ifndef STBI__ZWIDE_AFTER
+#define STBI__ZWIDE_AFTER      256
+#endif
+#endif
+
 // zlib-style huffman encoding
 // (jpegs packs from left, zlib from right, so can't share code)
 typedef struct
@@ -4075,6 +4601,10 @@ typedef struct
    int   z_expandable;
 
    stbi__zhuffman z_length, z_distance;
+#ifdef STBI__ZWIDE
+   stbi__uint32 wide_length[1 << STBI__ZWIDE_BITS];
+   stbi__uint32 wide_distance[1 << STBI__ZWIDE_DIST_BITS];
+#endif
 } stbi__zbuf;
 
 stbi_inline static int stbi__zeof(stbi__zbuf *z)
@@ -4183,11 +4713,174 @@ static const int stbi__zdist_base[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129
 static const int stbi__zdist_extra[32] =
 { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
 
+#ifdef STBI__ZWIDE
+// fill a wide table from a huffman table, with the entry for every symbol
+// whose code is at most 'bits' long
+static void stbi__zbuild_wide(const stbi__zhuffman *z, stbi__uint32 *table, int bits, int distance)
+{
+   int i,j,s,c,count,sym;
+   int n = 1 << bits;
+   stbi__uint32 e;
+   memset(table, 0, sizeof(*table) << bits);
+   for (s=1; s <= bits; ++s) {
+      count = (z->maxcode[s] >> (16-s)) - z->firstcode[s];
+      for (c=0; c < count; ++c) {
+         sym = z->value[z->firstsymbol[s] + c];
+         if (distance)
+            e = sym < 30 ? (stbi__uint32) (s | STBI__ZWIDE_MATCH | (stbi__zdist_base[sym] << 8) | (stbi__zdist_extra[sym] << 24)) : 0;
+         else if (sym < 256)
+            e = (stbi__uint32) (s | STBI__ZWIDE_LITERAL | (sym << 8));
+         else if (sym > 256 && sym < 286)
+            e = (stbi__uint32) (s | STBI__ZWIDE_MATCH | (stbi__zlength_base[sym-257] << 8) | (stbi__zlength_extra[sym-257] << 24));
+         else
+            e = 0; // end of block & invalid symbols are left to the plain decoder
+         for (j = stbi__bit_reverse(z->firstcode[s] + c, s); j < n; j += 1 << s)
+            table[j] = e;
+      }
+   }
+   if (distance) return;
+   // pair up literals whose codes fit together. going downwards, the entry
+   // for the bits after the first code is still a single one
+   for (i=n-1; i >= 0; --i) {
+      stbi__uint32 first = table[i], second;
+      int used = first & 31;
+      if (!(first & STBI__ZWIDE_LITERAL) || used >= bits) continue;
+      second = table[i >> used];
+      if ((second & STBI__ZWIDE_LITERAL) && used + (int) (second & 31) <= bits)
+         table[i] = (stbi__uint32) ((used + (second & 31)) | STBI__ZWIDE_LITERAL | STBI__ZWIDE_PAIR | (first & 0xff00) | ((second & 0xff00) << 8));
+   }
+}
+
+static void stbi__zbuild_wide_tables(stbi__zbuf *a)
+{
+   stbi__zbuild_wide(&a->z_length  , a->wide_length  , STBI__ZWIDE_BITS     , 0);
+   stbi__zbuild_wide(&a->z_distance, a->wide_distance, STBI__ZWIDE_DIST_BITS, 1);
+}
+
+stbi_inline static stbi__uint64 stbi__zload64(const stbi_uc *p)
+{
+   stbi__uint64 v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+// decode as much of a block as can be done without checking for the end of
+// the input or output. returns without consuming anything it can't handle:
+// the end of the block, long or invalid codes, and bad distances are all left
+// to the plain decoder, which then calls back in here
+static void stbi__zinflate_wide(stbi__zbuf *a, char **pzout)
+{
+   stbi_uc *in = a->zbuffer;
+   stbi_uc *in_end = a->zbuffer_end;
+   char *zout = *pzout;
+   char *zout_end = a->zout_end;
+   stbi__uint64 bits;
+   int count;
+
+   // every iteration loads 8 bytes, & writes at most a 258 byte match plus
+   // 15 bytes of overrun from wide copies. there is no point starting at all
+   // without room for a few of them
+   if (in_end - in < 64 || zout_end - zout < 1024) return;
+
+   // the buffered bits only ever come from the input here, never from
+   // padding past it, so they can be handed back as whole bytes at the end
+   bits  = a->code_buffer;
+   count = a->num_bits;
+
+   while (in_end - in >= 8 && zout_end - zout >= 258 + 16) {
+      stbi_uc *in_start;
+      stbi__uint64 bits_start;
+      int count_start, len, dist, extra;
+      stbi__uint32 e;
+
+      // branchless refill to 56..63 bits. the bits above the count are the
+      // next byte's, so reloading it later ORs in the same values
+      bits |= stbi__zload64(in) << count;
+      in += (63 - count) >> 3;
+      count |= 56;
+      in_start = in;
+      bits_start = bits;
+      count_start = count;
+
+      e = a->wide_length[bits & ((1 << STBI__ZWIDE_BITS) - 1)];
+      if (e & STBI__ZWIDE_LITERAL) {
+         bits >>= e & 31;
+         count -= e & 31;
+         *zout++ = (char) (e >> 8);
+         if (e & STBI__ZWIDE_PAIR) *zout++ = (char) (e >> 16);
+         continue;
+      }
+      if (!e) break;
+
+      // at most 15+5 bits for the length & 15+13 for the distance, all of
+      // which the refill covers
+      bits >>= e & 31;
+      count -= e & 31;
+      extra = (e >> 24) & 15;
+      len = (int) ((e >> 8) & 0x7fff) + (int) (bits & ((1u << extra) - 1));
+      bits >>= extra;
+      count -= extra;
+
+      e = a->wide_distance[bits & ((1 << STBI__ZWIDE_DIST_BITS) - 1)];
+      if (!e) {
+         in = in_start; bits = bits_start; count = count_start;
+         break;
+      }
+      bits >>= e & 31;
+      count -= e & 31;
+      extra = (e >> 24) & 15;
+      dist = (int) ((e >> 8) & 0x7fff) + (int) (bits & ((1u << extra) - 1));
+      bits >>= extra;
+      count -= extra;
+      if (zout - a->zout_start < dist) {
+         in = in_start; bits = bits_start; count = count_start;
+         break;
+      }
+
+      {
+         char *src = zout - dist;
+         char *end = zout + len;
+         // copies may run up to 15 bytes past the match, which the next
+         // symbols overwrite. chunks never read bytes they have not written
+         if (dist >= 16) {
+            do { memcpy(zout, src, 16); zout += 16; src += 16; } while (zout < end);
+         } else if (dist >= 8) {
+            do { memcpy(zout, src, 8); zout += 8; src += 8; } while (zout < end);
+         } else if (dist == 1) {
+            memset(zout, *src, len);
+         } else {
+            do *zout++ = *src++; while (zout < end);
+         }
+         zout = end;
+      }
+   }
+
+   // hand back whole unused bytes, so the plain decoder carries on exactly
+   // where this left off
+   in -= count >> 3;
+   count &= 7;
+   a->zbuffer = in;
+   a->code_buffer = (stbi__uint32) (bits & ((1u << count) - 1));
+   a->num_bits = count;
+   *pzout = zout;
+}
+#endif
+
 static int stbi__parse_huffman_block(stbi__zbuf *a)
 {
    char *zout = a->zout;
+#ifdef STBI__ZWIDE
+   int plain = 0;
+#endif
    for(;;) {
-      int z = stbi__zhuffman_decode(a, &a->z_length);
+      int z;
+#ifdef STBI__ZWIDE
+      if (plain == STBI__ZWIDE_AFTER)
+         stbi__zinflate_wide(a, &zout);
+      else if (++plain == STBI__ZWIDE_AFTER)
+         stbi__zbuild_wide_tables(a);
+#endif
+      z = stbi__zhuffman_decode(a, &a->z_length);
       if (z < 256) {
          if (z < 0) return stbi__err("bad huffman code","Corrupt PNG"); // error in huffman codes
          if (zout >= a->zout_end) {
@@ -4536,6 +5229,187 @@ static int stbi__paeth(int a, int b, int c)
 
 static const stbi_uc stbi__depth_scale_table[9] = { 0, 0xff, 0x55, 0, 0x11, 0,0,0, 0x01 };
 
+#ifdef STBI_SSE2
+// SIMD unfiltering of 8-bit RGB & RGBA rows. up goes 16 (or with AVX2, 32)
+// bytes at a time, & sub 4 pixels at a time as a running sum. avg & paeth
+// depend on the pixel to the left, so go a pixel at a time with every channel
+// at once. rows are img_n bytes a pixel in & out_n bytes a pixel out, with
+// out_n == img_n+1 filling in alpha = 255 (which stays a pixel at a time).
+
+stbi_inline static __m128i stbi__png_load(const stbi_uc *p, int n)
+{
+   stbi__uint32 v = 0;
+   if (n == 4) memcpy(&v, p, 4); else memcpy(&v, p, 3);
+   return _mm_cvtsi32_si128((int) v);
+}
+
+stbi_inline static void stbi__png_store(stbi_uc *p, __m128i v, int n)
+{
+   stbi__uint32 x = (stbi__uint32) _mm_cvtsi128_si32(v);
+   if (n == 4) memcpy(p, &x, 4); else memcpy(p, &x, 3);
+}
+
+// paeth predictor on 16-bit lanes; with p = a+b-c, |p-a| = |b-c|, |p-b| = |a-c|
+// & |p-c| = |(b-c)+(a-c)|. ties go to a, then b, like stbi__paeth
+stbi_inline static __m128i stbi__paeth_sse2(__m128i a, __m128i b, __m128i c)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i pa = _mm_sub_epi16(b, c);
+   __m128i pb = _mm_sub_epi16(a, c);
+   __m128i pc = _mm_add_epi16(pa, pb);
+   __m128i smallest, pick, r;
+   pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+   pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+   pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+   smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+   pick = _mm_cmpeq_epi16(pb, smallest);
+   r = _mm_or_si128(_mm_and_si128(pick, b), _mm_andnot_si128(pick, c));
+   pick = _mm_cmpeq_epi16(pa, smallest);
+   return _mm_or_si128(_mm_and_si128(pick, a), _mm_andnot_si128(pick, r));
+}
+
+// unfilter 'count' pixels a pixel at a time, reading & writing 'in' & 'out'
+// bytes of each. 4 is faster than 3 & fine for all but the last pixel of a
+// row, as the byte past a pixel is only the next, not yet written, one
+static void stbi__unfilter_pixels_sse2(int filter, stbi_uc *cur, const stbi_uc *raw, const stbi_uc *prior, stbi__uint32 count, int img_n, int out_n, int in, int out)
+{
+   __m128i zero  = _mm_setzero_si128();
+   __m128i alpha = _mm_cvtsi32_si128(out_n == img_n ? 0 : (int) 0xff000000u);
+   __m128i left  = stbi__png_load(cur - out_n, out);
+   stbi__uint32 i;
+
+   switch (filter) {
+      case STBI__F_none:
+         for (i=0; i < count; ++i, cur += out_n, raw += img_n)
+            stbi__png_store(cur, _mm_or_si128(stbi__png_load(raw, in), alpha), out);
+         break;
+      case STBI__F_sub:
+      case STBI__F_paeth_first: // paeth(a,0,0) is always a
+         for (i=0; i < count; ++i, cur += out_n, raw += img_n) {
+            left = _mm_or_si128(_mm_add_epi8(stbi__png_load(raw, in), left), alpha);
+            stbi__png_store(cur, left, out);
+         }
+         break;
+      case STBI__F_up:
+         for (i=0; i < count; ++i, cur += out_n, raw += img_n, prior += out_n)
+            stbi__png_store(cur, _mm_or_si128(_mm_add_epi8(stbi__png_load(raw, in), stbi__png_load(prior, out)), alpha), out);
+         break;
+      case STBI__F_avg:
+      case STBI__F_avg_first: {
+         // floor of the average: avg_epu8 rounds up, so take the odd bit back off
+         __m128i one = _mm_set1_epi8(1);
+         for (i=0; i < count; ++i, cur += out_n, raw += img_n, prior += out_n) {
+            __m128i up = filter == STBI__F_avg ? stbi__png_load(prior, out) : zero;
+            __m128i avg = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), one));
+            left = _mm_or_si128(_mm_add_epi8(stbi__png_load(raw, in), avg), alpha);
+            stbi__png_store(cur, left, out);
+         }
+         break;
+      }
+      case STBI__F_paeth: {
+         __m128i mask = _mm_set1_epi16(0xff);
+         __m128i a = _mm_unpacklo_epi8(left, zero);
+         __m128i c = _mm_unpacklo_epi8(stbi__png_load(prior - out_n, out), zero);
+         for (i=0; i < count; ++i, cur += out_n, raw += img_n, prior += out_n) {
+            __m128i b = _mm_unpacklo_epi8(stbi__png_load(prior, out), zero);
+            __m128i x = _mm_unpacklo_epi8(stbi__png_load(raw, in), zero);
+            a = _mm_and_si128(_mm_add_epi16(x, stbi__paeth_sse2(a, b, c)), mask);
+            stbi__png_store(cur, _mm_or_si128(_mm_packus_epi16(a, a), alpha), out);
+            c = b;
+         }
+         break;
+      }
+   }
+}
+
+// unfilter 'count' pixels, starting after the first of the row. the pixels
+// to the left & up-left are already in cur[-out_n] & prior[-out_n]
+static void stbi__unfilter_sse2(int filter, stbi_uc *cur, const stbi_uc *raw, const stbi_uc *prior, stbi__uint32 count, int img_n, int out_n)
+{
+   stbi__uint32 i = 0, n = count*img_n;
+
+   // whole vectors, when there is no chain to follow from pixel to pixel
+   if (img_n == out_n) {
+      if (filter == STBI__F_none) {
+         memcpy(cur, raw, n);
+         return;
+      }
+      if (filter == STBI__F_up) {
+         for (; i+16 <= n; i += 16)
+            _mm_storeu_si128((__m128i *) (cur+i), _mm_add_epi8(_mm_loadu_si128((const __m128i *) (raw+i)), _mm_loadu_si128((const __m128i *) (prior+i))));
+         for (; i < n; ++i)
+            cur[i] = STBI__BYTECAST(raw[i] + prior[i]);
+         return;
+      }
+      if (filter == STBI__F_sub || filter == STBI__F_paeth_first) {
+         // running sums of 4 pixels: add the vector shifted by one pixel, then
+         // by two, then the last pixel of the vector before
+         __m128i left = stbi__png_load(cur - out_n, out_n);
+         for (; i*img_n + 16 <= n; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (raw + i*img_n));
+            if (img_n == 4) {
+               v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+               v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+               v = _mm_add_epi8(v, _mm_shuffle_epi32(left, 0));
+               _mm_storeu_si128((__m128i *) (cur + i*4), v);
+               left = _mm_shuffle_epi32(v, 0xff);
+            } else {
+               __m128i carry = _mm_add_epi8(left, _mm_slli_si128(left, 3));
+               carry = _mm_add_epi8(carry, _mm_slli_si128(carry, 6));
+               v = _mm_add_epi8(v, _mm_slli_si128(v, 3));
+               v = _mm_add_epi8(v, _mm_slli_si128(v, 6));
+               v = _mm_add_epi8(v, carry);
+               // the 4 bytes past the 4 pixels are yet to be written, so may be scribbled on
+               _mm_storeu_si128((__m128i *) (cur + i*3), v);
+               left = _mm_srli_si128(_mm_slli_si128(v, 4), 13);
+            }
+         }
+      }
+   }
+
+   // everything else goes a pixel at a time
+   if (i < count) {
+      cur += i*out_n; raw += i*img_n; prior += i*out_n;
+      stbi__unfilter_pixels_sse2(filter, cur, raw, prior, count-i-1, img_n, out_n, 4, 4);
+      i = count-1-i;
+      stbi__unfilter_pixels_sse2(filter, cur + i*out_n, raw + i*img_n, prior + i*out_n, 1, img_n, out_n, img_n, out_n);
+   }
+}
+
+#ifdef STBI__AVX2
+// up & RGBA sub 32 bytes at a time. returns the pixels done, leaving the rest
+// of the row to stbi__unfilter_sse2
+STBI__AVX2_TARGET static stbi__uint32 stbi__unfilter_avx2(int filter, stbi_uc *cur, const stbi_uc *raw, const stbi_uc *prior, stbi__uint32 count, int img_n)
+{
+   stbi__uint32 i = 0;
+   if (filter == STBI__F_up) {
+      stbi__uint32 n = count*img_n / 32 * 32;
+      for (; i < n; i += 32)
+         _mm256_storeu_si256((__m256i *) (cur+i), _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) (raw+i)), _mm256_loadu_si256((const __m256i *) (prior+i))));
+      return n / img_n;
+   }
+   if (img_n == 4 && (filter == STBI__F_sub || filter == STBI__F_paeth_first)) {
+      int last;
+      __m256i left;
+      memcpy(&last, cur - 4, 4);
+      left = _mm256_set1_epi32(last);
+      for (; i+8 <= count; i += 8) {
+         __m256i v = _mm256_loadu_si256((const __m256i *) (raw + i*4));
+         // running sums within each half, then the low half's last pixel
+         // carried into the high half, then the last pixel before
+         v = _mm256_add_epi8(v, _mm256_slli_si256(v, 4));
+         v = _mm256_add_epi8(v, _mm256_slli_si256(v, 8));
+         v = _mm256_add_epi8(v, _mm256_permute2x128_si256(_mm256_shuffle_epi32(v, 0xff), _mm256_shuffle_epi32(v, 0xff), 0x08));
+         v = _mm256_add_epi8(v, left);
+         _mm256_storeu_si256((__m256i *) (cur + i*4), v);
+         left = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(7));
+      }
+   }
+   return i;
+}
+#endif
+#endif
+
 // create the png data from post-deflated data
 static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 raw_len, int out_n, stbi__uint32 x, stbi__uint32 y, int depth, int color)
 {
@@ -4549,6 +5423,12 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
    int output_bytes = out_n*bytes;
    int filter_bytes = img_n*bytes;
    int width = x;
+#ifdef STBI_SSE2
+   int simd = stbi__sse2_available();
+#endif
+#ifdef STBI__AVX2
+   int avx2 = stbi__avx2_available();
+#endif
 
    STBI_ASSERT(out_n == s->img_n || out_n == s->img_n+1);
    a->out = (stbi_uc *) stbi__malloc_mad3(x, y, output_bytes, 0); // extra bytes to write off the end into
@@ -4615,6 +5495,19 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
          prior += 1;
       }
 
+#ifdef STBI_SSE2
+      if (simd && depth == 8 && (img_n == 3 || img_n == 4)) {
+         stbi__uint32 done = 0;
+#ifdef STBI__AVX2
+         if (avx2 && img_n == out_n)
+            done = stbi__unfilter_avx2(filter, cur, raw, prior, x-1, img_n);
+#endif
+         stbi__unfilter_sse2(filter, cur + done*out_n, raw + done*img_n, prior + done*out_n, x-1-done, img_n, out_n);
+         raw += (x-1)*img_n;
+         continue;
+      }
+#endif
+
       // this is a little gross, so that we don't switch per-pixel or per-component
       if (depth < 8 || img_n == out_n) {
          int nk = (width - 1)*filter_bytes;
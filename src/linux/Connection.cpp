@@ -38,13 +38,42 @@
 #include <iostream>
 #include <array>
 #include <algorithm>
+#include <mutex>
 #include <unistd.h>
+#include <cstdint>
 
 namespace ygg
 {
   namespace lx
   {
-    static bool ssl_initialized = false ;
+    static std::once_flag ssl_initialized ;
+    
+    /** The BIO method TLS records are written to sockets with, made once OpenSSL is initialized.
+     */
+    static BIO_METHOD* nosignal_method = nullptr ;
+    
+    /** Function to write TLS records to the socket of a BIO, with a peer that already closed reported as a failed write instead of raising SIGPIPE.
+     * @param bio The BIO, holding the socket as it's data.
+     * @param bytes The bytes to write.
+     * @param amount The amount of bytes to write.
+     * @return The amount of bytes written, or -1 on failure.
+     */
+    static int nosignalWrite( BIO* bio, const char* bytes, int amount ) ;
+    
+    /** Function to answer the controls OpenSSL sends to the BIO TLS records are written with.
+     * @param bio The BIO.
+     * @param command The control to answer.
+     * @param number The number argument of the control.
+     * @param pointer The pointer argument of the control.
+     * @return 1 for a flush, which has nothing to do as nothing is buffered. 0 for anything else.
+     */
+    static long nosignalControl( BIO* bio, int command, long number, void* pointer ) ;
+    
+    /** Function to set up a BIO TLS records are written with.
+     * @param bio The BIO.
+     * @return Always 1.
+     */
+    static int nosignalCreate( BIO* bio ) ;
     
     /** Structure to contain a linux connection's data.
      */
@@ -56,8 +85,6 @@ namespace ygg
       
       SSL               *ssl               ;
       SSL_CTX           *context           ;
-      BIO               *read_bio          ;
-      BIO               *write_bio         ;
       unsigned           port              ;
       int                socket_descriptor ;
       Buffer             reply_buffer      ;
@@ -65,7 +92,10 @@ namespace ygg
       Message            message           ;
       std::string        ip_address        ;
       std::string        host_name         ;
+      std::string        protocols         ;
+      std::string        protocol          ;
       ygg::ConnectionType type             ;
+      bool               secure            ;
       bool               valid             ;
 
       /** Default constructor.
@@ -82,13 +112,46 @@ namespace ygg
        */
       std::string ipFromHostname( const char* host_name ) ;
       
-      /** Method to initialize the SSL Context.
+      /** Method to initialize the SSL Context & perform the TLS handshake over the connected socket.
        */
       void initialize() ;
+      
+      /** Method to release the SSL objects of this connection, if any were made.
+       */
+      void release() ;
     };
     
+    int nosignalWrite( BIO* bio, const char* bytes, int amount )
+    {
+      const int socket = static_cast<int>( reinterpret_cast<std::intptr_t>( BIO_get_data( bio ) ) ) ;
+      const int sent   = static_cast<int>( ::send( socket, bytes, static_cast<std::size_t>( amount ), MSG_NOSIGNAL ) ) ;
+      
+      BIO_clear_retry_flags( bio ) ;
+      if( sent <= 0 && BIO_sock_should_retry( sent ) ) BIO_set_retry_write( bio ) ;
+      
+      return sent ;
+    }
+    
+    long nosignalControl( BIO* bio, int command, long number, void* pointer )
+    {
+      static_cast<void>( bio     ) ;
+      static_cast<void>( number  ) ;
+      static_cast<void>( pointer ) ;
+      
+      return command == BIO_CTRL_FLUSH ? 1 : 0 ;
+    }
+    
+    int nosignalCreate( BIO* bio )
+    {
+      BIO_set_init( bio, 1 ) ;
+      return 1 ;
+    }
+    
     ConnectionData::ConnectionData()
     {
+      this->ssl               = nullptr                     ;
+      this->context           = nullptr                     ;
+      this->secure            = false                       ;
       this->valid             = false                       ;
       this->port              = 80                          ;
       this->socket_descriptor = 0x0                         ;
@@ -99,18 +162,28 @@ namespace ygg
     
     void ConnectionData::initialize()
     {
-      if( !ygg::lx::ssl_initialized )
-      {
-        SSL_library_init          () ;
-        SSL_load_error_strings    () ;
-        ERR_load_CRYPTO_strings   () ;
-        SSL_load_error_strings    () ; 
+      std::vector<unsigned char> wire          ;
+      std::stringstream          stream        ;
+      BIO*                       reader        ;
+      BIO*                       writer        ;
+      std::string                name          ;
+      const unsigned char*       selected      ;
+      unsigned                   selected_size ;
+      int                        result        ;
 
-        ygg::lx::ssl_initialized = true ;
-      }
+      std::call_once( ygg::lx::ssl_initialized, []()
+      {
+        OPENSSL_init_ssl( 0, nullptr ) ;
+        
+        nosignal_method = BIO_meth_new( BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "socket without SIGPIPE" ) ;
+        if( nosignal_method == nullptr ) return ;
+        
+        BIO_meth_set_write ( nosignal_method, &nosignalWrite   ) ;
+        BIO_meth_set_ctrl  ( nosignal_method, &nosignalControl ) ;
+        BIO_meth_set_create( nosignal_method, &nosignalCreate  ) ;
+      } ) ;
       
-      this->context = SSL_CTX_new( SSLv23_method() ) ;
-      this->ssl     = SSL_new    ( this->context   ) ;
+      this->context = SSL_CTX_new( this->type == ygg::ConnectionType::Client ? TLS_client_method() : TLS_server_method() ) ;
       
       if( !this->context )
       {
@@ -118,47 +191,79 @@ namespace ygg
         this->valid = false ;
         return ;
       };
-        
-      if( this->type == ygg::ConnectionType::Client ) 
-      {
-        SSL_set_connect_state( this->ssl ) ;
-      }
-      else
+      
+      SSL_CTX_set_options( this->context, SSL_OP_ALL | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 ) ;
+      SSL_CTX_set_default_verify_paths( this->context ) ;
+      
+      // A certificate is only needed to act as a server, or for servers that ask for client certificates.
+      if( Linux::certificate()[ 0 ] != '\0' && Linux::key()[ 0 ] != '\0' )
       {
-        SSL_set_accept_state( this->ssl ) ;
+        SSL_CTX_use_certificate_file( this->context, Linux::certificate(), SSL_FILETYPE_PEM ) ;
+        SSL_CTX_use_PrivateKey_file ( this->context, Linux::key()        , SSL_FILETYPE_PEM ) ;
+        
+        if( SSL_CTX_check_private_key( this->context ) != 1 )
+        {
+          ygg::Yggdrasil::addError( Yggdrasil::Error::SslPrivateKeyCheckFailure ) ;
+        }
       }
       
-      SSL_CTX_use_certificate_file( this->context, Linux::certificate(), SSL_FILETYPE_PEM ) ;
-      SSL_CTX_use_PrivateKey_file ( this->context, Linux::key()        , SSL_FILETYPE_PEM ) ;
-      SSL_CTX_set_verify_depth( this->context, 1 ) ;
-
-      if( SSL_do_handshake( this->ssl ) != 1 )
+      // Records are read straight off the socket, but written with MSG_NOSIGNAL, so a peer that already closed can't raise SIGPIPE.
+      this->ssl = SSL_new( this->context ) ;
+      reader    = this->ssl       ? BIO_new_socket( this->socket_descriptor, BIO_NOCLOSE ) : nullptr ;
+      writer    = nosignal_method ? BIO_new( nosignal_method )                           : nullptr ;
+      if( !this->ssl || !reader || !writer )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::SslConnectionFailure ) ;
+        if( reader ) BIO_free( reader ) ;
+        if( writer ) BIO_free( writer ) ;
+        
+        ygg::Yggdrasil::addError( Yggdrasil::Error::SslFDFailure ) ;
         this->valid = false ;
         return ;
       }
       
-      if( SSL_set_fd( this->ssl , this->socket_descriptor ) != 1 )
+      BIO_set_data( writer, reinterpret_cast<void*>( static_cast<std::intptr_t>( this->socket_descriptor ) ) ) ;
+      SSL_set_bio( this->ssl, reader, writer ) ;
+      
+      if( this->type == ygg::ConnectionType::Client ) 
+      {
+        SSL_set_tlsext_host_name( this->ssl, this->host_name.c_str() ) ;
+        SSL_set1_host           ( this->ssl, this->host_name.c_str() ) ;
+        SSL_set_verify          ( this->ssl, SSL_VERIFY_PEER, nullptr ) ;
+      }
+      
+      // ALPN wants the protocols as length-prefixed strings, so convert them from the comma separated list.
+      stream.str( this->protocols ) ;
+      while( std::getline( stream, name, ',' ) )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::SslFDFailure ) ;
-        this->valid = false ;
-        return ;
+        if( name.empty() || name.size() > 255 ) continue ;
+        wire.push_back( static_cast<unsigned char>( name.size() ) ) ;
+        wire.insert( wire.end(), name.begin(), name.end() ) ;
       }
       
-      if( SSL_CTX_check_private_key( this->context ) != 1 )
+      if( !wire.empty() ) SSL_set_alpn_protos( this->ssl, wire.data(), static_cast<unsigned>( wire.size() ) ) ;
+      
+      result = this->type == ygg::ConnectionType::Client ? SSL_connect( this->ssl ) : SSL_accept( this->ssl ) ;
+      if( result != 1 )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::SslPrivateKeyCheckFailure ) ;
+        ygg::Yggdrasil::addError( Yggdrasil::Error::SslConnectionFailure ) ;
         this->valid = false ;
         return ;
       }
       
-      SSL_CTX_set_options( this->context, SSL_OP_ALL | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 ) ;
-
-      this->read_bio  = BIO_new( BIO_s_mem() ) ;
-      this->write_bio = BIO_new( BIO_s_mem() ) ;
-      SSL_set_bio( this->ssl, this->read_bio, this->write_bio ) ;
-
+      selected      = nullptr ;
+      selected_size = 0       ;
+      SSL_get0_alpn_selected( this->ssl, &selected, &selected_size ) ;
+      this->protocol.assign( reinterpret_cast<const char*>( selected ), selected_size ) ;
+    }
+    
+    void ConnectionData::release()
+    {
+      if( this->ssl     ) SSL_free    ( this->ssl     ) ;
+      if( this->context ) SSL_CTX_free( this->context ) ;
+      
+      this->ssl     = nullptr ;
+      this->context = nullptr ;
+      this->protocol.clear() ;
     }
     
     void ConnectionData::connect()
@@ -176,24 +281,24 @@ namespace ygg
     
     std::string ConnectionData::ipFromHostname( const char* host_name )
     {
-      std::string ip           ;
-      hostent    *host         ;
-      in_addr   **address_list ;
-      unsigned    index        ;
+      char      ip[ INET_ADDRSTRLEN ] ;
+      addrinfo  hints                 ;
+      addrinfo *result                ;
       
-      if( ( host = gethostbyname( host_name ) ) == nullptr )
+      // getaddrinfo is used over gethostbyname, as connections may be made from many threads at once.
+      hints             = addrinfo() ;
+      hints.ai_family   = AF_INET     ;
+      hints.ai_socktype = SOCK_STREAM ;
+      
+      if( getaddrinfo( host_name, nullptr, &hints, &result ) != 0 || result == nullptr )
       {
         ygg::Yggdrasil::addError( Yggdrasil::Error::InvalidIP ) ;
         this->valid = false ;
-        return ip ;
+        return std::string() ;
       }
       
-      address_list = reinterpret_cast<in_addr**>( host->h_addr_list ) ;
-      
-      for( index = 0; address_list[ index ] != nullptr; index++ )
-      {
-        ip = std::string( ( inet_ntoa( *address_list[ index ] ) ) ) ;
-      }
+      inet_ntop( AF_INET, &reinterpret_cast<sockaddr_in*>( result->ai_addr )->sin_addr, ip, sizeof( ip ) ) ;
+      freeaddrinfo( result ) ;
       
       return ip ;
     }
@@ -205,29 +310,56 @@ namespace ygg
     
     Connection::~Connection()
     {
+      this->reset() ;
       delete this->connection_data ;
     }
     
-    void Connection::connect( const char* host_name, ygg::ConnectionType type, unsigned port )
+    void Connection::connect( const char* host_name, ygg::ConnectionType type, unsigned port, bool secure )
     {
+      this->reset() ;
+      
+      // Valid until proven otherwise, so a failed lookup is not overwritten & then connected to anyway.
+      data().valid             = true                               ;
       data().port              = port                               ;
       data().socket_descriptor = socket( AF_INET, SOCK_STREAM, 0 )  ;
       data().ip_address        = data().ipFromHostname( host_name ) ;
       data().type              = type                               ;
       data().host_name         = host_name                          ;
-      data().valid             = true                               ;
+      data().secure            = secure                             ;
 
-      data().connect()    ;
-//      data().initialize() ;
+      if( data().valid              ) data().connect()    ;
+      if( data().valid && secure    ) data().initialize() ;
+    }
+    
+    void Connection::setProtocols( const char* protocols )
+    {
+      data().protocols = protocols ;
+    }
+    
+    const char* Connection::protocol() const
+    {
+      return data().protocol.c_str() ;
     }
     
     void Connection::send( const char* cmd, unsigned size )
     { 
-      // Send data.
-      if( ::send( data().socket_descriptor, cmd, size, 0 ) < 0 )
+      int sent ;
+      
+      // Send data until all of it has been taken. A peer that already closed must not raise SIGPIPE, it is reported like any other failed send.
+      while( size > 0 )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::SendFailure ) ;
-        data().valid = false ;
+        if( data().ssl ) sent = SSL_write( data().ssl, cmd, static_cast<int>( size ) ) ;
+        else             sent = ::send( data().socket_descriptor, cmd, size, MSG_NOSIGNAL ) ;
+        
+        if( sent <= 0 )
+        {
+          ygg::Yggdrasil::addError( Yggdrasil::Error::SendFailure ) ;
+          data().valid = false ;
+          return ;
+        }
+        
+        cmd  += sent ;
+        size -= static_cast<unsigned>( sent ) ;
       }
     }
     
@@ -240,8 +372,13 @@ namespace ygg
     {
       if( data().socket_descriptor != 0x0 )
       {
+        if( data().ssl ) SSL_shutdown( data().ssl ) ;
         ::close( data().socket_descriptor ) ;
       }
+      
+      data().release() ;
+      data().socket_descriptor = 0x0   ;
+      data().valid             = false ;
     }
 
     Packet Connection::recieve( unsigned size )
@@ -249,16 +386,28 @@ namespace ygg
       Packet packet       ;
       int    recieved_amt ;
 
-      recieved_amt = ::recv( data().socket_descriptor, data().reply_buffer.data(), size, 0 ) ;
+      size = std::min<unsigned>( size, data().reply_buffer.size() ) ;
+      
+      if( data().ssl )
+      {
+        // A TLS close_notify is an orderly close, anything else is a failed read.
+        recieved_amt = SSL_read( data().ssl, data().reply_buffer.data(), static_cast<int>( size ) ) ;
+        if( recieved_amt <= 0 ) recieved_amt = SSL_get_error( data().ssl, recieved_amt ) == SSL_ERROR_ZERO_RETURN ? 0 : -1 ;
+      }
+      else
+      {
+        recieved_amt = ::recv( data().socket_descriptor, data().reply_buffer.data(), size, 0 ) ;
+      }
       
+      // The peer closing is not an error, it just ends the connection. A reset only warns, since callers can
+      // reconnect & resume. Either way they see an empty packet.
       if( recieved_amt == 0 )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::RecieveFailure ) ;
-        exit( 1 ) ;
+        data().valid = false ;
       }
-      if( recieved_amt < 0 )
+      else if( recieved_amt < 0 )
       {
-        ygg::Yggdrasil::addError( Yggdrasil::Error::RecieveFailure ) ;
+        ygg::Yggdrasil::addError( Yggdrasil::Error::ConnectionReset ) ;
         data().valid = false ;
       }
       else
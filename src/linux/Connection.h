@@ -42,7 +42,9 @@ namespace ygg
       public:
         Connection() ;
         ~Connection() ;
-        void connect( const char* url_path, ygg::ConnectionType type, unsigned port = 80 ) ;
+        void connect( const char* url_path, ygg::ConnectionType type, unsigned port = 80, bool secure = false ) ;
+        void setProtocols( const char* protocols ) ;
+        const char* protocol() const ;
         void send( const char* cmd, unsigned size ) ;
         bool valid() const ;
         void reset() ;
@@ -147,8 +147,19 @@ namespace ygg
        * @param host The C-string representation of the host name to connect to.
        * @param port The port number to use.
        * @param type The type of connection to make.
+       * @param secure Whether or not to run the connection over TLS.
        */
-      void connect( const char* host, ygg::ConnectionType type = ygg::ConnectionType::Client, unsigned port = 80 ) ;
+      void connect( const char* host, ygg::ConnectionType type = ygg::ConnectionType::Client, unsigned port = 80, bool secure = false ) ;
+      
+      /** Method to set the application protocols to offer through ALPN on the next secure connection.
+       * @param protocols The C-string comma separated list of protocols, most preferred first. E.g. "h2,http/1.1".
+       */
+      void setProtocols( const char* protocols ) ;
+      
+      /** Method to retrieve the application protocol the server chose through ALPN.
+       * @return The C-string name of the negotiated protocol, or an empty string if none was negotiated.
+       */
+      const char* protocol() const ;
       
       /** Method to retrieve whether or not this connection is successfully connected.
        * @return Whether or not this connection is valid & working correctly.
@@ -182,9 +193,21 @@ namespace ygg
   }
   
   template<typename Impl>
-  void Connection<Impl>::connect( const char* host, ygg::ConnectionType type, unsigned port )
+  void Connection<Impl>::connect( const char* host, ygg::ConnectionType type, unsigned port, bool secure )
+  {
+    this->connection.connect( host, type, port, secure ) ;
+  }
+  
+  template<typename Impl>
+  void Connection<Impl>::setProtocols( const char* protocols )
+  {
+    this->connection.setProtocols( protocols ) ;
+  }
+  
+  template<typename Impl>
+  const char* Connection<Impl>::protocol() const
   {
-    this->connection.connect( host, type, port ) ;
+    return this->connection.protocol() ;
   }
   
   template<typename Impl>
@@ -24,7 +24,7 @@
 
 #include "Yggdrasil.h"
 #include <map>
-#include <string>
+#include <mutex>
 #include <iostream>
 
 namespace ygg
@@ -35,9 +35,9 @@ namespace ygg
   static void defaultHandler( ygg::Yggdrasil::Error error ) ;
 
   /** Function to convert an Yggdrasil error to a string.
-   * @return A string representation of the error.
+   * @return A static C-string representation of the error.
    */
-  static std::string toString( Yggdrasil::Error error ) ;
+  static const char* toString( Yggdrasil::Error error ) ;
   
   /** Function to find the severity of an Yggdrasil error.
    * @param error The error to find the severity of.
@@ -53,6 +53,7 @@ namespace ygg
     
     Callback                 error_cb ;
     Yggdrasil::ErrorHandler* handler  ;
+    std::recursive_mutex     lock     ;
     
     /** Default constructor.
      */
@@ -69,7 +70,7 @@ namespace ygg
     if( error.severity() == Yggdrasil::Severity::Fatal ) exit( -1 ) ;
   }
   
-  std::string toString( Yggdrasil::Error error )
+  const char* toString( Yggdrasil::Error error )
   {
     switch( error.error() )
     {
@@ -106,6 +107,18 @@ namespace ygg
       case Yggdrasil::Error::InvalidIP :
         return "Could not find the IP of the hostname" ;
 
+      case Yggdrasil::Error::InvalidUrl :
+        return "Could not parse the URL" ;
+
+      case Yggdrasil::Error::InvalidStatus :
+        return "The server did not answer with success" ;
+
+      case Yggdrasil::Error::InvalidImage :
+        return "Could not decode the image" ;
+
+      case Yggdrasil::Error::ConnectionReset :
+        return "The connection was reset by the peer" ;
+
       case Yggdrasil::Error::None :
         return "None" ;
 
@@ -117,7 +130,8 @@ namespace ygg
   {
     switch( error.error() )
     {
-      case Yggdrasil::Error::RecieveFailure : return Yggdrasil::Severity::Fatal ;
+      case Yggdrasil::Error::RecieveFailure  : return Yggdrasil::Severity::Fatal   ;
+      case Yggdrasil::Error::ConnectionReset : return Yggdrasil::Severity::Warning ;
       case Yggdrasil::Error::None :
       default : return Yggdrasil::Severity::None ;
     }
@@ -163,20 +177,24 @@ namespace ygg
   
   const char* Yggdrasil::Error::toString() const
   {
-    static std::string str ;
-    
-    str = ygg::toString( *this ) ;
-
-    return str.c_str() ;
+    return ygg::toString( *this ) ;
   }
   
   Yggdrasil::Severity Yggdrasil::Error::severity() const
   {
     return ygg::severity( *this ) ;
   }
+  
+  Yggdrasil::ErrorHandler::~ErrorHandler()
+  {
+    
+  }
 
   void Yggdrasil::addError( Yggdrasil::Error error )
   {
+    // Recursive, so a handler can report an error of it's own.
+    std::lock_guard<std::recursive_mutex> lock( data.lock ) ;
+
     if( data.error_cb != nullptr )
     {
       ( data.error_cb )( error ) ;
@@ -190,11 +208,15 @@ namespace ygg
   
   void Yggdrasil::setErrorHandler( void ( *error_handler )( Yggdrasil::Error ) )
   {
+    std::lock_guard<std::recursive_mutex> lock( data.lock ) ;
+
     data.error_cb = error_handler ;
   }
   
   void Yggdrasil::setErrorHandler( ygg::Yggdrasil::ErrorHandler* handler )
   {
+    std::lock_guard<std::recursive_mutex> lock( data.lock ) ;
+
     data.handler = handler ;
   }
 }
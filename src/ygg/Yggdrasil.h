@@ -112,7 +112,23 @@ namespace ygg
             
             /** Error when looking up the IP.
              */
-            InvalidIP
+            InvalidIP,
+            
+            /** Error when a URL could not be parsed.
+             */
+            InvalidUrl,
+            
+            /** Error when a server answered with a status other than success.
+             */
+            InvalidStatus,
+            
+            /** Error when a downloaded image could not be decoded.
+             */
+            InvalidImage,
+            
+            /** Error when the peer dropped a connection mid-transfer, e.g. by resetting it.
+             */
+            ConnectionReset
           };
           
           /** Default constructor.
@@ -158,7 +174,7 @@ namespace ygg
           unsigned val ; ///< The internal container for the enumeration.
       };
       
-      /** Static method to push an error onto this library.
+      /** Static method to push an error onto this library. Safe to call from any thread, as handlers are called one error at a time.
        * @param error The error to handle by this library
        */
       static void addError( Yggdrasil::Error error ) ;